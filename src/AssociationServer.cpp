@@ -0,0 +1,282 @@
+// AssociationServer.cpp
+#include "AssociationServer.h"
+#include "DatasetSpill.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "PrintSCP.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <dcmtk/dcmdata/dcuid.h>
+
+namespace {
+
+// Supported SOP Classes for DICOM Print
+const char* PRINT_SOP_CLASSES[] = {
+    UID_BasicFilmSessionSOPClass,
+    UID_BasicFilmBoxSOPClass,
+    UID_BasicGrayscaleImageBoxSOPClass,
+    UID_PrinterSOPClass,
+    UID_BasicColorImageBoxSOPClass,
+    UID_PresentationLUTSOPClass,
+    UID_BasicGrayscalePrintManagementMetaSOPClass,
+    UID_BasicColorPrintManagementMetaSOPClass,
+    NULL
+};
+
+// Accept print SOP class contexts with the first transfer syntax of our
+// preference list that the requestor proposed (not the requestor's first choice)
+OFCondition acceptPrintPresentationContexts(T_ASC_Parameters* params,
+                                            const std::vector<std::string>& transferSyntaxes) {
+    std::vector<const char*> syntaxes;
+    for (const std::string& uid : transferSyntaxes) syntaxes.push_back(uid.c_str());
+
+    int abstractCount = 0;
+    while (PRINT_SOP_CLASSES[abstractCount] != NULL) ++abstractCount;
+
+    OFCondition cond = ASC_acceptContextsWithPreferredTransferSyntaxes(
+        params, PRINT_SOP_CLASSES, abstractCount, syntaxes.data(), (int)syntaxes.size());
+    if (cond.bad()) return cond;
+
+    int presentationContextCount = ASC_countPresentationContexts(params);
+    LOG_DEBUG << "Number of presentation contexts: " << presentationContextCount;
+
+    for (int i = 0; i < presentationContextCount; i++) {
+        T_ASC_PresentationContext pc;
+        if (ASC_getPresentationContext(params, i, &pc).bad()) continue;
+        LOG_DEBUG << "Context " << (int)pc.presentationContextID << ": " << pc.abstractSyntax
+                  << (pc.resultReason == ASC_P_ACCEPTANCE ? " -> ACCEPTED with " : " -> REJECTED (reason ")
+                  << (pc.resultReason == ASC_P_ACCEPTANCE ? std::string(pc.acceptedTransferSyntax)
+                                                          : std::to_string(pc.resultReason) + ")");
+    }
+    return EC_Normal;
+}
+
+// DCMTK reads these when it sets up each accepted socket
+void applySocketOptions(const ServerConfig& config) {
+    const std::string noDelay = config.tcpNoDelay ? "1" : "0";
+    const std::string bufferLength = std::to_string(config.socketBufferKB * 1024);
+#ifdef _WIN32
+    _putenv_s("TCP_NODELAY", noDelay.c_str());
+    if (config.socketBufferKB) _putenv_s("TCP_BUFFER_LENGTH", bufferLength.c_str());
+#else
+    setenv("TCP_NODELAY", noDelay.c_str(), 1);
+    if (config.socketBufferKB) setenv("TCP_BUFFER_LENGTH", bufferLength.c_str(), 1);
+#endif
+}
+
+} // namespace
+
+// -----------------------------
+// AssociationServer Implementation
+// -----------------------------
+AssociationServer::AssociationServer(const ServerConfig& config)
+    : config_(config),
+      network_(nullptr),
+      spooler_(config),
+      metricsExporter_(config, [this](std::string& out) { renderMetrics(out); }),
+      stopRequested_(false),
+      inFlight_(0) {
+    parseTransferSyntaxList(config_.transferSyntaxes, transferSyntaxes_);
+}
+
+AssociationServer::~AssociationServer() {
+    stop();
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    if (network_) ASC_dropNetwork(&network_);
+}
+
+void AssociationServer::stop() {
+    stopRequested_ = true;
+    queueCond_.notify_all();
+}
+
+// -----------------------------
+// Acceptor loop
+// -----------------------------
+OFCondition AssociationServer::run(T_ASC_Network* network) {
+    if (transferSyntaxes_.empty()) {
+        LOG_ERROR << "❌ No usable transfer syntax in: " << config_.transferSyntaxes;
+        return EC_IllegalParameter;
+    }
+    applySocketOptions(config_);
+
+    OFCondition cond = EC_Normal;
+    if (network) {
+        network_ = network;
+    } else {
+        cond = ASC_initializeNetwork(NET_ACCEPTOR, config_.port, 30, &network_);
+        if (cond.bad()) {
+            LOG_ERROR << "❌ Failed to initialize DCMTK network: " << cond.text();
+            return cond;
+        }
+    }
+
+    if (!spooler_.start()) {
+        ASC_dropNetwork(&network_);
+        network_ = nullptr;
+        return EC_IllegalCall;
+    }
+    if (!metricsExporter_.start()) {
+        spooler_.stop();
+        ASC_dropNetwork(&network_);
+        network_ = nullptr;
+        return EC_IllegalCall;
+    }
+    for (unsigned i = 0; i < config_.workerThreads; ++i)
+        workers_.emplace_back(&AssociationServer::workerLoop, this, i);
+
+    LOG_INFO << "👷 Worker threads: " << config_.workerThreads
+             << ", association cap: " << config_.maxAssociations;
+    LOG_INFO << "🔌 Max PDU " << config_.maxPdu << ", TCP_NODELAY " << (config_.tcpNoDelay ? "on" : "off")
+             << ", socket buffer " << (config_.socketBufferKB ? std::to_string(config_.socketBufferKB) + " KB"
+                                                              : std::string("default"))
+             << ", transfer syntaxes " << config_.transferSyntaxes;
+
+    while (!stopRequested_) {
+        T_ASC_Association* assoc = NULL;
+
+        // Time-limited wait so the stop flag is checked regularly
+        cond = ASC_receiveAssociation(network_, &assoc, config_.maxPdu,
+                                      NULL, NULL, OFFalse,
+                                      DUL_NOBLOCK, config_.pollInterval);
+        if (cond.bad()) {
+            // A shared listening socket is shut down by the supervisor on stop
+            if (cond != DUL_NOASSOCIATIONREQUEST &&
+                cond != DUL_PEERREQUESTEDRELEASE &&
+                cond != DUL_PEERABORTEDASSOCIATION && !stopRequested_) {
+                LOG_ERROR << "❌ Association receive error: " << cond.text();
+            }
+            if (assoc) {
+                ASC_dropAssociation(assoc);
+                ASC_destroyAssociation(&assoc);
+            }
+            continue;
+        }
+
+        LOG_INFO << "New connection from AE: " << assoc->params->DULparams.callingAPTitle;
+
+        if (inFlight_.load() >= config_.maxAssociations) {
+            LOG_WARN << "⛔ Association limit reached (" << config_.maxAssociations
+                     << "), rejecting " << assoc->params->DULparams.callingAPTitle;
+            rejectAssociation(assoc);
+            Metrics::instance().associationRejected();
+            continue;
+        }
+
+        {
+            StageTimer timer(Stage::AssociationSetup);
+            cond = negotiateAssociation(assoc);
+        }
+        if (cond.bad()) {
+            ASC_dropAssociation(assoc);
+            ASC_destroyAssociation(&assoc);
+            Metrics::instance().associationRejected();
+            continue;
+        }
+        Metrics::instance().associationAccepted();
+
+        ++inFlight_;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            pending_.push_back(assoc);
+        }
+        queueCond_.notify_one();
+    }
+
+    LOG_INFO << "🛑 Stopping acceptor, waiting for workers...";
+    queueCond_.notify_all();
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    workers_.clear();
+
+    // Associations still queued when the workers stopped are aborted
+    for (T_ASC_Association* assoc : pending_) {
+        ASC_abortAssociation(assoc);
+        releaseAssociation(assoc);
+    }
+    pending_.clear();
+
+    // Jobs already accepted from modalities are printed before exiting
+    spooler_.stop();
+    metricsExporter_.stop();
+
+    ASC_dropNetwork(&network_);
+    network_ = nullptr;
+    return EC_Normal;
+}
+
+OFCondition AssociationServer::negotiateAssociation(T_ASC_Association* assoc) {
+    // Accept print-related SOPs
+    OFCondition cond = acceptPrintPresentationContexts(assoc->params, transferSyntaxes_);
+    if (cond.bad()) {
+        LOG_ERROR << "❌ Failed to accept presentation contexts: " << cond.text();
+        return cond;
+    }
+
+    cond = ASC_acknowledgeAssociation(assoc);
+    if (cond.bad()) {
+        LOG_ERROR << "❌ Failed to acknowledge association: " << cond.text();
+        return cond;
+    }
+
+    LOG_INFO << "✅ Association accepted successfully!";
+    return EC_Normal;
+}
+
+void AssociationServer::rejectAssociation(T_ASC_Association* assoc) {
+    T_ASC_RejectParameters rej = {
+        ASC_RESULT_REJECTEDTRANSIENT,
+        ASC_SOURCE_SERVICEPROVIDER_PRESENTATION_RELATED,
+        ASC_REASON_SP_PRES_LOCALLIMITEXCEEDED
+    };
+    ASC_rejectAssociation(assoc, &rej);
+    ASC_dropAssociation(assoc);
+    ASC_destroyAssociation(&assoc);
+}
+
+// -----------------------------
+// Worker threads
+// -----------------------------
+void AssociationServer::workerLoop(unsigned workerId) {
+    PrintSCP scp(config_, spooler_, store_, &stopRequested_);
+
+    while (true) {
+        T_ASC_Association* assoc = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueCond_.wait(lock, [this] { return stopRequested_ || !pending_.empty(); });
+            if (stopRequested_) return;
+            assoc = pending_.front();
+            pending_.pop_front();
+        }
+
+        LOG_INFO << "👷 Worker " << workerId << " handling association from "
+                 << assoc->params->DULparams.callingAPTitle;
+
+        OFCondition cond = scp.handleAssociation(assoc);
+        if (cond.bad() && cond != DUL_PEERREQUESTEDRELEASE && cond != DUL_PEERABORTEDASSOCIATION)
+            LOG_ERROR << "❌ Association ended with error: " << cond.text();
+
+        releaseAssociation(assoc);
+        LOG_INFO << "🔚 Connection closed (worker " << workerId << ").";
+    }
+}
+
+void AssociationServer::renderMetrics(std::string& out) {
+    Metrics::instance().renderPrometheus(out);
+    appendMetric(out, "dicom_print_associations_in_flight", "gauge",
+                 "Associations queued or being served.", inFlight_.load());
+    spooler_.appendMetrics(out);
+    appendSpillMetrics(out);
+}
+
+void AssociationServer::releaseAssociation(T_ASC_Association*& assoc) {
+    ASC_dropAssociation(assoc);
+    ASC_destroyAssociation(&assoc);
+    --inFlight_;
+}
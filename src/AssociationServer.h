@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmnet/assoc.h>
+
+#include "ServerConfig.h"
+#include "MetricsExporter.h"
+#include "PrintSpooler.h"
+#include "PrintObjectStore.h"
+
+/**
+ * @class AssociationServer
+ * @brief مستقبِل اتصالات DICOM متعدد الخيوط.
+ *
+ * خيط الاستقبال يقبل الاتصالات ويتفاوض عليها ثم يسلمها إلى مجموعة محدودة
+ * من خيوط العمال، كل عامل يشغّل نسخة PrintSCP خاصة به وتشترك جميعها
+ * في طابور طباعة واحد. عند تجاوز الحد الأقصى للاتصالات يُرفض الاتصال
+ * الجديد مؤقتاً بدلاً من تركه ينتظر.
+ */
+class AssociationServer {
+private:
+    const ServerConfig& config_;
+    T_ASC_Network* network_; ///< شبكة DCMTK المستمعة
+    PrintSpooler spooler_;   ///< طابور الطباعة المشترك بين العمال
+    PrintObjectStore store_; ///< كائنات الطباعة لكل الاتصالات الجارية
+    std::vector<std::string> transferSyntaxes_; ///< UIDs صيغ النقل بترتيب الأفضلية
+    MetricsExporter metricsExporter_;         ///< نشر المقاييس عبر HTTP المحلي / ملف
+
+    std::atomic<bool> stopRequested_;        ///< طلب إيقاف الخادم
+    std::atomic<unsigned> inFlight_;         ///< الاتصالات المنتظرة + قيد المعالجة
+    std::mutex queueMutex_;                  ///< قفل لحماية طابور الاتصالات
+    std::condition_variable queueCond_;      ///< إشعار العمال بوصول اتصال
+    std::deque<T_ASC_Association*> pending_; ///< اتصالات مقبولة بانتظار عامل
+    std::vector<std::thread> workers_;       ///< خيوط العمال
+
+public:
+    explicit AssociationServer(const ServerConfig& config);
+    ~AssociationServer();
+
+    AssociationServer(const AssociationServer&) = delete;
+    AssociationServer& operator=(const AssociationServer&) = delete;
+
+    /**
+     * @brief تهيئة الشبكة وتشغيل العمال ثم حلقة الاستقبال حتى طلب الإيقاف
+     * @param network شبكة مستمعة جاهزة موروثة من المشرف (nullptr = فتح المنفذ هنا)
+     * @return حالة التنفيذ (DCMTK OFCondition)
+     */
+    OFCondition run(T_ASC_Network* network = nullptr);
+
+    /**
+     * @brief طلب إيقاف نظيف: يتوقف الاستقبال وتُنهى الاتصالات الجارية
+     *        آمنة للاستدعاء من معالج الإشارات / Console handler
+     */
+    void stop();
+
+    bool stopRequested() const { return stopRequested_.load(); }
+
+private:
+    /**
+     * @brief التفاوض على سياقات العرض وإرسال القبول (يعمل في خيط الاستقبال)
+     */
+    OFCondition negotiateAssociation(T_ASC_Association* assoc);
+
+    /**
+     * @brief رفض الاتصال مؤقتاً عند الوصول إلى الحد الأقصى
+     */
+    void rejectAssociation(T_ASC_Association* assoc);
+
+    /**
+     * @brief حلقة خيط العامل: سحب اتصال من الطابور ومعالجته
+     */
+    void workerLoop(unsigned workerId);
+
+    /**
+     * @brief كل المقاييس (العامة + الاتصالات الجارية + الطابور) بصيغة Prometheus
+     */
+    void renderMetrics(std::string& out);
+
+    /**
+     * @brief تحرير الاتصال وإنقاص عداد الاتصالات الجارية
+     */
+    void releaseAssociation(T_ASC_Association*& assoc);
+};
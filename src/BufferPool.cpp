@@ -0,0 +1,221 @@
+// BufferPool.cpp
+#include "BufferPool.h"
+#include "Metrics.h"
+#include <new>
+
+namespace {
+
+const size_t kMinClass = 64 * 1024;  // smaller requests share the 64 KB class
+const size_t kStepsPerDoubling = 8;  // at most 12.5% of a buffer is rounding
+const size_t kDefaultIdleLimit = 256 * 1024 * 1024;
+
+} // namespace
+
+// -----------------------------
+// PooledBytes Implementation
+// -----------------------------
+bool PooledBytes::allocate(size_t bytes) {
+    if (bytes <= capacity_) {
+        size_ = bytes;
+        return true;
+    }
+    release();
+    if (bytes == 0) return true;
+    data_ = BufferPool::instance().acquire(bytes, capacity_);
+    size_ = data_ ? bytes : 0;
+    return data_ != nullptr;
+}
+
+void PooledBytes::release() {
+    if (data_) BufferPool::instance().recycle(data_, capacity_);
+    data_ = nullptr;
+    size_ = 0;
+    capacity_ = 0;
+}
+
+// -----------------------------
+// BufferPool Implementation
+// -----------------------------
+BufferPool::Reservation::~Reservation() {
+    if (pool_ && bytes_) pool_->unreserve(bytes_);
+}
+
+BufferPool::BufferPool()
+    : budgetBytes_(0), idleLimitBytes_(kDefaultIdleLimit), reservedBytes_(0), freeBytes_(0),
+      liveBytes_(0),
+      hits_(0), misses_(0), waits_(0), waitMicros_(0) {
+}
+
+BufferPool::~BufferPool() {
+    trim();
+}
+
+BufferPool& BufferPool::instance() {
+    static BufferPool pool;
+    return pool;
+}
+
+void BufferPool::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budgetBytes_ = bytes;
+    if (budgetBytes_ && freeBytes_ > budgetBytes_) trimLocked(budgetBytes_);
+}
+
+size_t BufferPool::budget() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return budgetBytes_;
+}
+
+void BufferPool::setIdleLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idleLimitBytes_ = bytes;
+    if (freeBytes_ > idleLimitBytes_) trimLocked(idleLimitBytes_);
+}
+
+size_t BufferPool::sizeClass(size_t bytes) {
+    if (bytes <= kMinClass) return kMinClass;
+    // Round up to the next of kStepsPerDoubling steps between two powers of two
+    size_t power = kMinClass;
+    while (power * 2 < bytes) power *= 2;
+    const size_t step = power / kStepsPerDoubling;
+    return (bytes + step - 1) / step * step;
+}
+
+BufferPool::Reservation BufferPool::reserve(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (budgetBytes_ == 0) return Reservation();
+    if (bytes > budgetBytes_) bytes = budgetBytes_; // runs alone instead of never
+
+    const auto fits = [&] { return reservedBytes_ + bytes <= budgetBytes_; };
+    if (!fits()) {
+        ++waits_;
+        const auto start = std::chrono::steady_clock::now();
+        released_.wait(lock, fits);
+        waitMicros_ += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+    reservedBytes_ += bytes;
+    // Free buffers kept for reuse must fit in what the reservations leave over
+    if (reservedBytes_ + freeBytes_ > budgetBytes_) trimLocked(budgetBytes_ - reservedBytes_);
+    return Reservation(this, bytes);
+}
+
+void BufferPool::unreserve(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        reservedBytes_ -= bytes;
+    }
+    released_.notify_all();
+}
+
+Uint8* BufferPool::acquire(size_t bytes, size_t& capacity) {
+    const size_t cls = sizeClass(bytes);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Same class, or the next ones up to a quarter larger
+        for (auto it = free_.lower_bound(cls); it != free_.end() && it->first <= cls + cls / 4; ++it) {
+            if (it->second.buffers.empty()) continue;
+            Uint8* data = it->second.buffers.back();
+            it->second.buffers.pop_back();
+            it->second.lastUsed = std::chrono::steady_clock::now();
+            capacity = it->first;
+            freeBytes_ -= capacity;
+            liveBytes_ += capacity;
+            ++hits_;
+            return data;
+        }
+    }
+
+    ++misses_;
+    Uint8* data = new (std::nothrow) Uint8[cls];
+    if (!data) {
+        // Out of memory: give back every idle buffer and try once more
+        trim();
+        data = new (std::nothrow) Uint8[cls];
+        if (!data) return nullptr;
+    }
+    capacity = cls;
+    std::lock_guard<std::mutex> lock(mutex_);
+    liveBytes_ += cls;
+    return data;
+}
+
+void BufferPool::recycle(Uint8* data, size_t capacity) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        liveBytes_ -= capacity;
+        // Without a budget the idle limit alone keeps a past peak from staying pooled
+        const bool keep = freeBytes_ + capacity <= idleLimitBytes_ &&
+                          (budgetBytes_ == 0 || reservedBytes_ + freeBytes_ + capacity <= budgetBytes_);
+        if (keep) {
+            FreeClass& freeClass = free_[capacity];
+            freeClass.buffers.push_back(data);
+            freeClass.lastUsed = std::chrono::steady_clock::now();
+            freeBytes_ += capacity;
+            return;
+        }
+    }
+    delete[] data;
+}
+
+void BufferPool::trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    trimLocked(0);
+}
+
+void BufferPool::trimIdle(std::chrono::steady_clock::duration maxAge) {
+    const auto cutoff = std::chrono::steady_clock::now() - maxAge;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = free_.begin(); it != free_.end();) {
+        if (it->second.lastUsed > cutoff) {
+            ++it;
+            continue;
+        }
+        for (Uint8* data : it->second.buffers) delete[] data;
+        freeBytes_ -= it->first * it->second.buffers.size();
+        it = free_.erase(it);
+    }
+}
+
+// Largest classes first: they are the rarest to be reused
+void BufferPool::trimLocked(size_t targetFreeBytes) {
+    for (auto it = free_.rbegin(); it != free_.rend() && freeBytes_ > targetFreeBytes; ++it) {
+        std::vector<Uint8*>& buffers = it->second.buffers;
+        while (!buffers.empty() && freeBytes_ > targetFreeBytes) {
+            delete[] buffers.back();
+            buffers.pop_back();
+            freeBytes_ -= it->first;
+        }
+    }
+}
+
+void BufferPool::appendMetrics(std::string& out) {
+    size_t reserved, freeBytes, live, budget, idleLimit;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idleLimit = idleLimitBytes_;
+        reserved = reservedBytes_;
+        freeBytes = freeBytes_;
+        live = liveBytes_;
+        budget = budgetBytes_;
+    }
+    appendMetric(out, "dicom_print_memory_budget_bytes", "gauge",
+                 "Global render memory budget (0 = unlimited).", (double)budget);
+    appendMetric(out, "dicom_print_memory_reserved_bytes", "gauge",
+                 "Memory reserved by running print jobs.", (double)reserved);
+    appendMetric(out, "dicom_print_buffer_pool_live_bytes", "gauge",
+                 "Pooled page and tile buffers in use.", (double)live);
+    appendMetric(out, "dicom_print_buffer_pool_free_bytes", "gauge",
+                 "Idle pooled buffers kept for reuse.", (double)freeBytes);
+    appendMetric(out, "dicom_print_buffer_pool_idle_limit_bytes", "gauge",
+                 "Cap on idle pooled buffers.", (double)idleLimit);
+    appendMetric(out, "dicom_print_buffer_pool_hits_total", "counter",
+                 "Buffer requests served from the pool.", (double)hits_.load());
+    appendMetric(out, "dicom_print_buffer_pool_misses_total", "counter",
+                 "Buffer requests that allocated new memory.", (double)misses_.load());
+    appendMetric(out, "dicom_print_memory_budget_waits_total", "counter",
+                 "Jobs that waited for memory budget.", (double)waits_.load());
+    appendMetric(out, "dicom_print_memory_budget_wait_seconds_total", "counter",
+                 "Time jobs spent waiting for memory budget.", waitMicros_.load() / 1e6);
+}
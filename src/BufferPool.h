@@ -0,0 +1,192 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/ofstd/oftypes.h>
+
+class BufferPool;
+
+/**
+ * @class PooledBytes
+ * @brief مخزن بايتات من BufferPool يعود إلى المجموعة عند الهدم بدلاً من تحريره
+ *
+ * allocate() لا يحفظ المحتوى السابق ولا يصفّر الذاكرة. التنسيق مضمون لأي نوع
+ * بسيط (Uint16 / Sint16 / Uint32).
+ */
+class PooledBytes {
+private:
+    Uint8* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+
+public:
+    PooledBytes() {}
+    explicit PooledBytes(size_t bytes) { allocate(bytes); }
+    ~PooledBytes() { release(); }
+
+    PooledBytes(PooledBytes&& other) noexcept { swap(other); }
+    PooledBytes& operator=(PooledBytes&& other) noexcept {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+    PooledBytes(const PooledBytes&) = delete;
+    PooledBytes& operator=(const PooledBytes&) = delete;
+
+    /**
+     * @brief تجهيز size بايت (يُعاد استخدام المخزن الحالي إن كان يكفي)
+     * @return false عند فشل الحجز (يصبح المخزن فارغاً)
+     */
+    bool allocate(size_t bytes);
+
+    /**
+     * @brief إعادة المخزن إلى المجموعة
+     */
+    void release();
+
+    void swap(PooledBytes& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+    }
+
+    Uint8* data() { return data_; }
+    const Uint8* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    template <class T> T* as() { return reinterpret_cast<T*>(data_); }
+    template <class T> const T* as() const { return reinterpret_cast<const T*>(data_); }
+};
+
+/**
+ * @class BufferPool
+ * @brief مجموعة مخازن الصفحات والمربعات المشتركة بين كل المهام مع حد ذاكرة عام
+ *
+ * الأحجام تُقرّب إلى فئات (8 فئات لكل ضعف) فتعيد المهام المتكررة استخدام نفس
+ * المخازن بدلاً من new/delete لكل صفحة ومربع. قبل بدء أي مهمة يُحجز تقديرها
+ * من الحد العام؛ المهمة التي تتجاوزه تنتظر حتى تنتهي مهام أخرى، فتبقى الذروة
+ * قريبة من الحد مهما زاد الحمل. المخازن الحرة تُحسب من الحد وتُحرَّر أولاً
+ * عند الحاجة إلى مكان.
+ *
+ * المخازن الحرة محدودة أيضاً بحد مستقل (setIdleLimit) حتى بدون حد عام، والفئات
+ * التي لم تُستخدم منذ مدة تُحرَّر بـ trimIdle() فلا تبقى ذروة حمل سابق محجوزة.
+ *
+ * الحد العام يغطي تقديرات المهام الجارية والمخازن الحرة فقط؛ ذاكرة الصفحات
+ * (PageCache) لها حدها الخاص، ونسخ Dataset المستلمة لا تُحسب منه.
+ */
+class BufferPool {
+public:
+    /**
+     * @class Reservation
+     * @brief حجز من الحد العام لمدة مهمة واحدة (يُعاد عند الهدم)
+     */
+    class Reservation {
+    private:
+        BufferPool* pool_ = nullptr;
+        size_t bytes_ = 0;
+
+    public:
+        Reservation() {}
+        Reservation(BufferPool* pool, size_t bytes) : pool_(pool), bytes_(bytes) {}
+        ~Reservation();
+        Reservation(Reservation&& other) noexcept : pool_(other.pool_), bytes_(other.bytes_) {
+            other.pool_ = nullptr;
+        }
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+        Reservation& operator=(Reservation&&) = delete;
+
+        size_t bytes() const { return bytes_; }
+    };
+
+private:
+    std::mutex mutex_;
+    std::condition_variable released_;
+    struct FreeClass {
+        std::vector<Uint8*> buffers;
+        std::chrono::steady_clock::time_point lastUsed; ///< آخر حجز أو إعادة في هذه الفئة
+    };
+
+    std::map<size_t, FreeClass> free_; ///< فئة الحجم → مخازن حرة
+    size_t budgetBytes_;   ///< 0 = بدون حد
+    size_t idleLimitBytes_; ///< أقصى حجم للمخازن الحرة
+    size_t reservedBytes_; ///< مجموع حجوزات المهام الجارية
+    size_t freeBytes_;     ///< المخازن الحرة المحفوظة للإعادة
+    size_t liveBytes_;     ///< المخازن المستخدمة حالياً
+
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> waits_;
+    std::atomic<uint64_t> waitMicros_;
+
+    BufferPool();
+
+public:
+    static BufferPool& instance();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+    ~BufferPool();
+
+    /**
+     * @brief تحديد الحد العام للذاكرة عند التشغيل، قبل أي حجز (0 = بدون حد، الافتراضي)
+     */
+    void setBudget(size_t bytes);
+    size_t budget();
+
+    /**
+     * @brief أقصى حجم للمخازن الحرة المحفوظة للإعادة، بحد عام أو بدونه (0 = لا تُحفظ)
+     */
+    void setIdleLimit(size_t bytes);
+
+    /**
+     * @brief حجز bytes من الحد، مع الانتظار حتى يتوفر المكان
+     *
+     * الحجز الأكبر من الحد كله يُقلَّص إلى الحد (ينفذ وحده)، و Reservation::bytes()
+     * تعيد الحجم بعد التقليص. بدون حد يعود فوراً.
+     */
+    Reservation reserve(size_t bytes);
+
+    /**
+     * @brief مخزن بحجم bytes على الأقل (فئة الحجم الأقرب)، nullptr عند الفشل
+     */
+    Uint8* acquire(size_t bytes, size_t& capacity);
+
+    /**
+     * @brief إعادة مخزن إلى المجموعة (يُحرَّر إذا لم يبقَ مكان ضمن الحد)
+     */
+    void recycle(Uint8* data, size_t capacity);
+
+    /**
+     * @brief تحرير كل المخازن الحرة
+     */
+    void trim();
+
+    /**
+     * @brief تحرير المخازن الحرة في الفئات التي لم تُستخدم منذ maxAge
+     */
+    void trimIdle(std::chrono::steady_clock::duration maxAge);
+
+    /**
+     * @brief عدادات المجموعة بصيغة Prometheus
+     */
+    void appendMetrics(std::string& out);
+
+private:
+    static size_t sizeClass(size_t bytes);
+    void trimLocked(size_t targetFreeBytes);
+    void unreserve(size_t bytes);
+};
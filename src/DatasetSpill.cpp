@@ -0,0 +1,182 @@
+// DatasetSpill.cpp
+#include "DatasetSpill.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+
+#include <dcmtk/dcmdata/dcostrmf.h>
+#include <dcmtk/dcmdata/dcxfer.h>
+#include <dcmtk/dcmnet/dimse.h>
+
+#include <zlib.h>
+
+namespace {
+
+// Values longer than this stay in the spill file until first accessed
+const Uint32 kLazyValueBytes = 64 * 1024;
+
+std::atomic<uint64_t> g_liveFiles(0);
+std::atomic<uint64_t> g_liveBytes(0);
+std::atomic<uint64_t> g_spilledTotal(0);
+
+// Unique across restarts and across processes sharing the directory
+std::string spillFileName() {
+    static const unsigned long long instance = (unsigned long long)
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    static std::atomic<unsigned long> counter(0);
+    char name[64];
+    std::snprintf(name, sizeof(name), "recv_%llx_%06lu.dcm", instance, ++counter);
+    return name;
+}
+
+// Deflated Explicit VR Little Endian is one raw deflate stream; DCMTK reads it
+// through an inflate filter and then cannot load values lazily, so the file is
+// inflated to plain Explicit VR Little Endian first, a buffer at a time
+bool inflateFile(const std::string& from, const std::string& to, uint64_t& bytes) {
+    bytes = 0;
+    FILE* in = std::fopen(from.c_str(), "rb");
+    if (!in) return false;
+    FILE* out = std::fopen(to.c_str(), "wb");
+    if (!out) {
+        std::fclose(in);
+        return false;
+    }
+
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    bool ok = inflateInit2(&zs, -MAX_WBITS) == Z_OK;
+    std::vector<Uint8> input(kLazyValueBytes), output(4 * kLazyValueBytes);
+    int status = Z_OK;
+    while (ok && status != Z_STREAM_END) {
+        zs.avail_in = (uInt)std::fread(input.data(), 1, input.size(), in);
+        zs.next_in = input.data();
+        if (zs.avail_in == 0) break; // truncated stream
+        do {
+            zs.next_out = output.data();
+            zs.avail_out = (uInt)output.size();
+            status = inflate(&zs, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+                ok = false;
+                break;
+            }
+            const size_t produced = output.size() - zs.avail_out;
+            if (std::fwrite(output.data(), 1, produced, out) != produced) ok = false;
+            bytes += produced;
+        } while (ok && status != Z_STREAM_END && zs.avail_out == 0);
+    }
+    ok = ok && status == Z_STREAM_END;
+    inflateEnd(&zs);
+    std::fclose(in);
+    if (std::fclose(out) != 0) ok = false;
+    return ok;
+}
+
+} // namespace
+
+// -----------------------------
+// SpillFile Implementation
+// -----------------------------
+SpillFile::SpillFile(const std::string& path) : path_(path), bytes_(0) {
+}
+
+SpillFile::~SpillFile() {
+    if (bytes_) {
+        --g_liveFiles;
+        g_liveBytes -= bytes_;
+    }
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+    if (ec) LOG_WARN << "⚠ Cannot remove spill file " << path_ << ": " << ec.message();
+}
+
+void SpillFile::setBytes(uint64_t bytes) {
+    if (!bytes_ && bytes) ++g_liveFiles;
+    g_liveBytes += bytes - bytes_;
+    bytes_ = bytes;
+}
+
+// -----------------------------
+// Reception
+// -----------------------------
+OFCondition receiveDatasetSpilled(T_ASC_Association* assoc, T_ASC_PresentationContextID& presID,
+                                  const ServerConfig& config, std::unique_ptr<DcmDataset>& dataset,
+                                  std::shared_ptr<SpillFile>& spill) {
+    spill.reset();
+    std::error_code ec;
+    std::filesystem::create_directories(config.spillDirectory, ec);
+    std::shared_ptr<SpillFile> file(
+        new SpillFile((std::filesystem::path(config.spillDirectory) / spillFileName()).string()));
+
+    // P-DATA goes to disk as it arrives; the heap never holds the whole dataset
+    OFCondition cond;
+    {
+        DcmOutputFileStream stream(file->path().c_str());
+        if (!stream.good()) {
+            LOG_ERROR << "❌ Cannot create spill file " << file->path() << ": " << stream.status().text();
+            return stream.status();
+        }
+        cond = DIMSE_receiveDataSetInFile(assoc, DIMSE_NONBLOCKING, config.dimseTimeout, &presID, &stream,
+                                          NULL, NULL);
+    }
+    if (cond.bad()) return cond;
+
+    T_ASC_PresentationContext context;
+    cond = ASC_findAcceptedPresentationContext(assoc->params, presID, &context);
+    if (cond.bad()) return cond;
+    E_TransferSyntax xfer = DcmXfer(context.acceptedTransferSyntax).getXfer();
+
+    const uint64_t bytes = (uint64_t)std::filesystem::file_size(file->path(), ec);
+    const bool keep = !ec && bytes >= (uint64_t)config.spillThresholdMB * 1024 * 1024;
+    uint64_t fileBytes = bytes;
+
+    // Values cannot stay on disk behind an inflate filter
+    if (keep && xfer == EXS_DeflatedLittleEndianExplicit) {
+        const std::string inflated = file->path() + ".inflate";
+        if (!inflateFile(file->path(), inflated, fileBytes)) {
+            std::filesystem::remove(inflated, ec);
+            LOG_ERROR << "❌ Cannot inflate spilled dataset " << file->path();
+            return EC_CorruptedData;
+        }
+        std::filesystem::rename(inflated, file->path(), ec);
+        if (ec) {
+            std::filesystem::remove(inflated, ec);
+            LOG_ERROR << "❌ Cannot replace spill file " << file->path() << ": " << ec.message();
+            return EC_IllegalCall;
+        }
+        xfer = EXS_LittleEndianExplicit;
+    }
+
+    dataset.reset(new DcmDataset());
+    cond = dataset->loadFile(file->path().c_str(), xfer, EGL_noChange, kLazyValueBytes);
+    if (cond.good() && !keep) cond = dataset->loadAllDataIntoMemory();
+    if (cond.bad()) {
+        LOG_ERROR << "❌ Cannot read spilled dataset " << file->path() << ": " << cond.text();
+        dataset.reset();
+        return cond;
+    }
+    Metrics::instance().addBytesReceived(bytes);
+
+    if (keep) {
+        file->setBytes(fileBytes);
+        ++g_spilledTotal;
+        spill = file;
+        LOG_DEBUG << "💾 Dataset of " << fileBytes / 1024 << " KB kept on disk: " << file->path();
+    }
+    return cond;
+}
+
+void appendSpillMetrics(std::string& out) {
+    appendMetric(out, "dicom_print_spilled_datasets_total", "counter",
+                 "Received datasets whose pixel data stayed in a spill file.", (double)g_spilledTotal.load());
+    appendMetric(out, "dicom_print_spill_files", "gauge", "Spill files currently on disk.",
+                 (double)g_liveFiles.load());
+    appendMetric(out, "dicom_print_spill_bytes", "gauge", "Bytes held in spill files.",
+                 (double)g_liveBytes.load());
+}
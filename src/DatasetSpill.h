@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmnet/assoc.h>
+#include <dcmtk/dcmdata/dcdatset.h>
+
+#include "ServerConfig.h"
+
+/**
+ * @class SpillFile
+ * @brief ملف مؤقت يحمل Dataset مستلماً؛ قيم البكسلات الكبيرة تُقرأ منه عند الحاجة
+ *
+ * يبقى الملف ما دامت أي نسخة من الـ Dataset (Image Box أو مهمة) تحتفظ به،
+ * ويُحذف مع آخر مرجع.
+ */
+class SpillFile {
+private:
+    std::string path_;
+    uint64_t bytes_;
+
+public:
+    explicit SpillFile(const std::string& path);
+    ~SpillFile();
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    const std::string& path() const { return path_; }
+    uint64_t bytes() const { return bytes_; }
+    void setBytes(uint64_t bytes);
+};
+
+/**
+ * @brief استلام Dataset عبر ملف في مجلد التفريغ بدلاً من الذاكرة
+ *
+ * الـ Dataset يُكتب كما يصل (P-DATA) إلى ملف ثم يُقرأ منه. إذا كان أصغر من
+ * spillThresholdMB يُحمّل كاملاً ويُحذف الملف؛ وإلا تبقى القيم الكبيرة
+ * (Pixel Data) في الملف ولا تُقرأ إلا عند العرض، فتبقى الذاكرة بحجم الخصائص فقط.
+ * الملف المستلم بصيغة Deflate يُفك إلى Explicit VR Little Endian أولاً، لأن DCMTK
+ * لا تؤجل قراءة القيم من خلال فك الضغط.
+ *
+ * @param spill يُملأ بالملف إذا بقيت قيم فيه (nullptr إذا حُمّل كاملاً)
+ */
+OFCondition receiveDatasetSpilled(T_ASC_Association* assoc, T_ASC_PresentationContextID& presID,
+                                  const ServerConfig& config, std::unique_ptr<DcmDataset>& dataset,
+                                  std::shared_ptr<SpillFile>& spill);
+
+/**
+ * @brief عدادات ملفات التفريغ بصيغة Prometheus
+ */
+void appendSpillMetrics(std::string& out);
@@ -0,0 +1,115 @@
+// FilmCompositor.cpp
+#include "FilmCompositor.h"
+#include "Logger.h"
+#include "ImageRenderer.h"
+#include "Metrics.h"
+#include <atomic>
+#include <cstring>
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+
+namespace {
+
+// A page is color as soon as one image box holds a color image
+bool isColorImage(DcmDataset& dataset) {
+    Uint16 samplesPerPixel = 1;
+    dataset.findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel);
+    if (samplesPerPixel > 1) return true;
+
+    OFString photometric;
+    if (dataset.findAndGetOFString(DCM_PhotometricInterpretation, photometric).good())
+        return photometric != "MONOCHROME1" && photometric != "MONOCHROME2" && !photometric.empty();
+    return false;
+}
+
+void fillRect(PageBuffer& page, const TileRect& rect, Uint8 gray) {
+    // Gray levels have equal channels, so one memset covers 8 and 24 bit pages
+    const size_t bytesPerPixel = page.bitsPerPixel() / 8;
+    for (unsigned long y = 0; y < rect.height; ++y) {
+        Uint8* row = page.data() + (rect.y + y) * page.stride() + rect.x * bytesPerPixel;
+        memset(row, gray, rect.width * bytesPerPixel);
+    }
+}
+
+// The tile's rectangle of the page, written by the renderer in place
+RenderTarget tileTarget(PageBuffer& page, const TileRect& tile) {
+    RenderTarget target;
+    target.color = page.bitsPerPixel() == 24;
+    target.bgr = page.bgr();
+    target.stride = page.stride();
+    target.data = page.data() + tile.y * page.stride() + tile.x * (target.color ? 3 : 1);
+    target.width = tile.width;
+    target.height = tile.height;
+    return target;
+}
+
+} // namespace
+
+// -----------------------------
+// FilmCompositor Implementation
+// -----------------------------
+FilmCompositor::FilmCompositor(ThreadPool& pool, unsigned dpi) : pool_(pool), dpi_(dpi) {
+}
+
+bool FilmCompositor::compose(const FilmBoxSpec& film,
+                             const std::vector<PageImage>& images,
+                             const RasterLayout& layout, PageBuffer& page) {
+    StageTimer compositeTimer(Stage::Composite);
+    FilmLayout filmLayout;
+    if (!computeFilmLayout(film, dpi_, filmLayout)) {
+        LOG_ERROR << "❌ Unsupported film: " << film.imageDisplayFormat << " / "
+                  << film.filmSizeID;
+        return false;
+    }
+    if (images.size() > filmLayout.tiles.size()) {
+        LOG_ERROR << "❌ " << images.size() << " images for " << filmLayout.tiles.size()
+                  << " image boxes (" << film.imageDisplayFormat << ")";
+        return false;
+    }
+
+    bool color = false;
+    for (const PageImage& image : images) {
+        if (image.dataset && isColorImage(*image.dataset)) { color = true; break; }
+    }
+
+    if (!page.allocate(filmLayout.pageWidth, filmLayout.pageHeight, color ? 24 : 8, layout)) {
+        LOG_ERROR << "❌ Cannot allocate page buffer " << filmLayout.pageWidth << "x"
+                  << filmLayout.pageHeight;
+        return false;
+    }
+
+    // Background first; tiles then overwrite their own disjoint rectangles
+    const Uint8 border = densityToGray(film.borderDensity, film.minDensity, film.maxDensity);
+    const Uint8 empty = densityToGray(film.emptyImageDensity, film.minDensity, film.maxDensity);
+    memset(page.data(), border, page.size());
+
+    std::atomic<bool> ok(true);
+    pool_.parallelFor(filmLayout.tiles.size(), [&](size_t index) {
+        const TileRect& tile = filmLayout.tiles[index];
+        const PageImage* image = index < images.size() ? &images[index] : nullptr;
+        if (!image || !image->dataset) {
+            fillRect(page, tile, empty);
+            return;
+        }
+
+        RenderOptions options;
+        options.magnificationType =
+            image->magnificationType.empty() ? film.magnificationType : image->magnificationType;
+        options.polarity = image->polarity;
+        options.presentationLutShape = image->presentationLutShape;
+
+        // Tiles never overlap, so each one is rendered straight into its own part of
+        // the page, centred in the box, with no per-tile buffer to copy from
+        StageTimer renderTimer(Stage::Render);
+        if (!renderImageToFit(*image->dataset, tileTarget(page, tile), options, lutCache_, &pool_)) {
+            LOG_ERROR << "❌ Image box " << index + 1 << " could not be rendered";
+            fillRect(page, tile, empty);
+            ok = false;
+        }
+    });
+
+    LOG_DEBUG << "🎞 Film " << film.imageDisplayFormat << " " << film.filmSizeID << " "
+              << film.filmOrientation << ": " << filmLayout.tiles.size() << " boxes, "
+              << page.width() << "x" << page.height() << (color ? " color" : " gray");
+    return ok;
+}
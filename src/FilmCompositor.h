@@ -0,0 +1,66 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcdatset.h>
+
+#include "FilmLayout.h"
+#include "GrayscaleLut.h"
+#include "OutputBackend.h"
+#include "PageBuffer.h"
+#include "ThreadPool.h"
+
+class SpillFile;
+
+/**
+ * @struct PageImage
+ * @brief صورة مربع واحد مع خصائص Image Box التي تؤثر على عرضها
+ */
+struct PageImage {
+    std::shared_ptr<DcmDataset> dataset; ///< وحدة البكسلات (nullptr = مربع فارغ)؛ مشتركة مع Image Box
+                                         ///< ولا تُعدل إلا بعد نسخها إذا كانت مشتركة
+    std::string polarity;                ///< REVERSE يعكس الرمادي
+    std::string magnificationType;       ///< فارغ = قيمة Film Box
+    std::string presentationLutShape;    ///< من Presentation LUT المرجعية (فارغ = IDENTITY)
+    std::string cacheKey;                ///< imageCacheKey من الفك المسبق (فارغ = يُحسب عند الطباعة)
+    std::shared_ptr<SpillFile> spill;    ///< يبقي ملف التفريغ الذي تُقرأ منه البكسلات حتى نهاية المهمة
+};
+
+/**
+ * @class FilmCompositor
+ * @brief تركيب صفحة واحدة من كل مربعات الصور في Film Box حسب تنسيق العرض
+ *
+ * تُملأ الصفحة بكثافة الحدود، ثم يُعرض كل مربع (تحويل + تحجيم) في خيط من
+ * مجموعة الخيوط ويُنسخ في موقعه مباشرة. المربعات لا تتداخل، لذلك تكتب كل
+ * الخيوط في نفس مخزن الصفحة دون أقفال، ويصبح زمن الصفحة قريباً من زمن أبطأ مربع.
+ */
+class FilmCompositor {
+private:
+    ThreadPool& pool_;
+    unsigned dpi_;
+    LutCache lutCache_; ///< جداول التحويل الرمادية المشتركة بين كل المهام
+
+public:
+    /**
+     * @param pool مجموعة الخيوط المشتركة لعرض المربعات
+     * @param dpi دقة الطابعة المستخدمة لحساب أبعاد الصفحة
+     */
+    FilmCompositor(ThreadPool& pool, unsigned dpi);
+
+    /**
+     * @brief تركيب الصفحة
+     * @param film خصائص Film Box
+     * @param images الصور بترتيب Image Box Position
+     * @param layout شكل الصفحة الذي يفضله المخرج
+     * @param page مخزن الصفحة الذي سيُملأ
+     * @return false إذا كان التنسيق غير مدعوم أو فشل عرض أي صورة
+     */
+    bool compose(const FilmBoxSpec& film,
+                 const std::vector<PageImage>& images,
+                 const RasterLayout& layout, PageBuffer& page);
+
+    const LutCache& lutCache() const { return lutCache_; }
+};
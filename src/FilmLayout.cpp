@@ -0,0 +1,182 @@
+// FilmLayout.cpp
+#include "FilmLayout.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+
+namespace {
+
+struct FilmSize {
+    const char* id;
+    double widthInch;  ///< portrait width
+    double heightInch; ///< portrait height
+};
+
+const double CM = 1.0 / 2.54;
+
+// Defined terms of Film Size ID (2010,0050)
+const FilmSize FILM_SIZES[] = {
+    { "8INX10IN",   8.0,  10.0 },
+    { "8_5INX11IN", 8.5,  11.0 },
+    { "10INX12IN",  10.0, 12.0 },
+    { "10INX14IN",  10.0, 14.0 },
+    { "11INX14IN",  11.0, 14.0 },
+    { "11INX17IN",  11.0, 17.0 },
+    { "14INX14IN",  14.0, 14.0 },
+    { "14INX17IN",  14.0, 17.0 },
+    { "24CMX24CM",  24 * CM, 24 * CM },
+    { "24CMX30CM",  24 * CM, 30 * CM },
+    { "A4",         21.0 * CM, 29.7 * CM },
+    { "A3",         29.7 * CM, 42.0 * CM },
+};
+
+// Split "1,2,3" into numbers; false on empty or non-positive entries
+bool parseCounts(const std::string& text, std::vector<unsigned>& counts) {
+    counts.clear();
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) end = text.size();
+        const std::string item = text.substr(start, end - start);
+        char* stop = nullptr;
+        const long value = std::strtol(item.c_str(), &stop, 10);
+        if (item.empty() || *stop != '\0' || value <= 0 || value > 64) return false;
+        counts.push_back((unsigned)value);
+        start = end + 1;
+    }
+    return !counts.empty();
+}
+
+// Split "TYPE\args" into its two parts
+bool splitFormat(const std::string& format, std::string& type, std::vector<unsigned>& counts) {
+    const size_t sep = format.find('\\');
+    if (sep == std::string::npos) return false;
+    type = format.substr(0, sep);
+    return parseCounts(format.substr(sep + 1), counts);
+}
+
+// Divide `length` into `parts` cells separated (and surrounded) by `gap`
+void divide(unsigned long length, unsigned parts, unsigned long gap,
+            std::vector<unsigned long>& offsets, unsigned long& cell) {
+    const unsigned long gaps = gap * (parts + 1);
+    cell = length > gaps ? (length - gaps) / parts : 1;
+    offsets.resize(parts);
+    for (unsigned i = 0; i < parts; ++i)
+        offsets[i] = gap + i * (cell + gap);
+}
+
+} // namespace
+
+void FilmBoxSpec::updateFrom(DcmItem& item) {
+    OFString value;
+    if (item.findAndGetOFStringArray(DCM_ImageDisplayFormat, value).good() && !value.empty())
+        imageDisplayFormat = value.c_str();
+    if (item.findAndGetOFString(DCM_FilmOrientation, value).good() && !value.empty())
+        filmOrientation = value.c_str();
+    if (item.findAndGetOFString(DCM_FilmSizeID, value).good() && !value.empty())
+        filmSizeID = value.c_str();
+    if (item.findAndGetOFString(DCM_MagnificationType, value).good() && !value.empty())
+        magnificationType = value.c_str();
+    if (item.findAndGetOFString(DCM_BorderDensity, value).good() && !value.empty())
+        borderDensity = value.c_str();
+    if (item.findAndGetOFString(DCM_EmptyImageDensity, value).good() && !value.empty())
+        emptyImageDensity = value.c_str();
+
+    Uint16 density = 0;
+    if (item.findAndGetUint16(DCM_MinDensity, density).good()) minDensity = density;
+    if (item.findAndGetUint16(DCM_MaxDensity, density).good()) maxDensity = density;
+}
+
+size_t imageBoxCount(const std::string& imageDisplayFormat) {
+    std::string type;
+    std::vector<unsigned> counts;
+    if (!splitFormat(imageDisplayFormat, type, counts)) return 0;
+
+    if (type == "STANDARD") {
+        if (counts.size() != 2) return 0;
+        return (size_t)counts[0] * counts[1];
+    }
+    if (type == "ROW" || type == "COL") {
+        size_t total = 0;
+        for (unsigned c : counts) total += c;
+        return total;
+    }
+    return 0; // SLIDE, SUPERSLIDE, CUSTOM are not supported
+}
+
+bool computeFilmLayout(const FilmBoxSpec& spec, unsigned dpi, FilmLayout& layout) {
+    const FilmSize* size = nullptr;
+    for (const FilmSize& candidate : FILM_SIZES) {
+        if (spec.filmSizeID == candidate.id) { size = &candidate; break; }
+    }
+    if (!size) return false;
+
+    double widthInch = size->widthInch;
+    double heightInch = size->heightInch;
+    if (spec.filmOrientation == "LANDSCAPE") std::swap(widthInch, heightInch);
+
+    layout.pageWidth = (unsigned long)(widthInch * dpi + 0.5);
+    layout.pageHeight = (unsigned long)(heightInch * dpi + 0.5);
+    layout.tiles.clear();
+
+    std::string type;
+    std::vector<unsigned> counts;
+    if (!splitFormat(spec.imageDisplayFormat, type, counts)) return false;
+
+    // About 1 mm of border between and around image boxes
+    const unsigned long gap = std::max(2u, dpi / 25);
+    std::vector<unsigned long> xs, ys;
+    unsigned long cellW = 0, cellH = 0;
+
+    if (type == "STANDARD" && counts.size() == 2) {
+        // STANDARD\C,R: C columns, R rows, row-major positions
+        divide(layout.pageWidth, counts[0], gap, xs, cellW);
+        divide(layout.pageHeight, counts[1], gap, ys, cellH);
+        for (unsigned r = 0; r < counts[1]; ++r) {
+            for (unsigned c = 0; c < counts[0]; ++c) {
+                TileRect tile;
+                tile.x = xs[c]; tile.y = ys[r]; tile.width = cellW; tile.height = cellH;
+                layout.tiles.push_back(tile);
+            }
+        }
+    } else if (type == "ROW") {
+        // ROW\a,b,...: one entry per row, each with its own number of columns
+        divide(layout.pageHeight, (unsigned)counts.size(), gap, ys, cellH);
+        for (size_t r = 0; r < counts.size(); ++r) {
+            divide(layout.pageWidth, counts[r], gap, xs, cellW);
+            for (unsigned c = 0; c < counts[r]; ++c) {
+                TileRect tile;
+                tile.x = xs[c]; tile.y = ys[r]; tile.width = cellW; tile.height = cellH;
+                layout.tiles.push_back(tile);
+            }
+        }
+    } else if (type == "COL") {
+        // COL\a,b,...: one entry per column, filled top to bottom
+        divide(layout.pageWidth, (unsigned)counts.size(), gap, xs, cellW);
+        for (size_t c = 0; c < counts.size(); ++c) {
+            divide(layout.pageHeight, counts[c], gap, ys, cellH);
+            for (unsigned r = 0; r < counts[c]; ++r) {
+                TileRect tile;
+                tile.x = xs[c]; tile.y = ys[r]; tile.width = cellW; tile.height = cellH;
+                layout.tiles.push_back(tile);
+            }
+        }
+    } else {
+        return false;
+    }
+    return !layout.tiles.empty();
+}
+
+Uint8 densityToGray(const std::string& density, unsigned minDensity, unsigned maxDensity) {
+    if (density.empty() || density == "BLACK") return 0;
+    if (density == "WHITE") return 255;
+
+    // Numeric value in hundredths of optical density: more density = darker
+    char* stop = nullptr;
+    const long od = std::strtol(density.c_str(), &stop, 10);
+    if (*stop != '\0' || maxDensity <= minDensity) return 0;
+    const long clamped = std::min<long>(std::max<long>(od, minDensity), maxDensity);
+    return (Uint8)(255 * (long)(maxDensity - clamped) / (long)(maxDensity - minDensity));
+}
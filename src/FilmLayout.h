@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcitem.h>
+
+/**
+ * @struct FilmBoxSpec
+ * @brief خصائص Film Box التي تحدد شكل الصفحة (تنسيق العرض، الحجم، الاتجاه، الكثافات)
+ *        القيم الافتراضية هي الافتراضات المعتادة للطابعة عند غياب الخاصية.
+ */
+struct FilmBoxSpec {
+    std::string imageDisplayFormat = "STANDARD\\1,1"; ///< (2010,0010)
+    std::string filmOrientation = "PORTRAIT";         ///< (2010,0040) PORTRAIT / LANDSCAPE
+    std::string filmSizeID = "14INX17IN";             ///< (2010,0050)
+    std::string magnificationType;                    ///< (2010,0060) فارغ = افتراضي الطابعة
+    std::string borderDensity = "BLACK";              ///< (2010,0100) BLACK / WHITE / كثافة ×100
+    std::string emptyImageDensity = "BLACK";          ///< (2010,0110)
+    unsigned minDensity = 20;                         ///< (2010,0120) بالمئات من OD
+    unsigned maxDensity = 300;                        ///< (2010,0130)
+
+    /**
+     * @brief قراءة الخصائص الموجودة من Dataset (الغائبة تبقى على الافتراضي)
+     */
+    void updateFrom(DcmItem& item);
+};
+
+/**
+ * @struct TileRect
+ * @brief موقع مربع صورة (Image Box) داخل الصفحة بالبكسل
+ */
+struct TileRect {
+    unsigned long x = 0;
+    unsigned long y = 0;
+    unsigned long width = 0;
+    unsigned long height = 0;
+};
+
+/**
+ * @struct FilmLayout
+ * @brief أبعاد الصفحة ومواقع المربعات بترتيب Image Box Position (1..n)
+ */
+struct FilmLayout {
+    unsigned long pageWidth = 0;
+    unsigned long pageHeight = 0;
+    std::vector<TileRect> tiles;
+};
+
+/**
+ * @brief عدد مربعات الصور في تنسيق العرض (0 إذا كان التنسيق غير مدعوم)
+ */
+size_t imageBoxCount(const std::string& imageDisplayFormat);
+
+/**
+ * @brief حساب أبعاد الصفحة ومواقع المربعات
+ * @param spec خصائص Film Box
+ * @param dpi دقة الطابعة (نقطة لكل بوصة)
+ * @param layout الناتج
+ * @return false إذا كان تنسيق العرض أو حجم الفيلم غير مدعوم
+ */
+bool computeFilmLayout(const FilmBoxSpec& spec, unsigned dpi, FilmLayout& layout);
+
+/**
+ * @brief تحويل قيمة كثافة DICOM (BLACK / WHITE / OD×100) إلى مستوى رمادي 8bit
+ */
+Uint8 densityToGray(const std::string& density, unsigned minDensity, unsigned maxDensity);
@@ -0,0 +1,342 @@
+// GdiOutputBackend.cpp
+#include "GdiOutputBackend.h"
+#include "Logger.h"
+#include "BufferPool.h"
+#include "PixelKernels.h"
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <windows.h>
+
+namespace {
+
+// An idle handle older than this is checked with GetPrinter before reuse
+const std::chrono::seconds kHealthCheckAfter(30);
+
+} // namespace
+
+/**
+ * @struct PrinterConnection
+ * @brief مقبض طابعة مفتوح مع DC الخاص بها، يستخدمه مستند واحد في كل مرة
+ */
+struct PrinterConnection {
+    std::string printerName;       ///< الاسم المطلوب (فارغ = الافتراضية)
+    std::string deviceName;        ///< الاسم الفعلي بعد تحديد الطابعة الافتراضية
+    HANDLE printer = NULL;
+    HDC dc = NULL;
+    int dpiX = 0;
+    int dpiY = 0;
+    bool dpiWarned = false;        ///< تحذير اختلاف الدقة مرة واحدة لكل مقبض
+    std::chrono::steady_clock::time_point lastUsed;
+
+    ~PrinterConnection() {
+        if (dc) DeleteDC(dc);
+        if (printer) ClosePrinter(printer);
+    }
+};
+
+namespace {
+
+std::unique_ptr<PrinterConnection> openConnection(const std::string& printerName) {
+    std::unique_ptr<PrinterConnection> connection(new PrinterConnection());
+    connection->printerName = printerName;
+    connection->deviceName = printerName;
+    if (connection->deviceName.empty()) {
+        char defaultName[256];
+        DWORD size = sizeof(defaultName);
+        if (!GetDefaultPrinterA(defaultName, &size)) {
+            LOG_ERROR << "❌ No default printer configured";
+            return nullptr;
+        }
+        connection->deviceName = defaultName;
+    }
+
+    if (!OpenPrinterA(const_cast<LPSTR>(connection->deviceName.c_str()), &connection->printer, NULL)) {
+        LOG_ERROR << "❌ Failed to open printer: " << connection->deviceName;
+        connection->printer = NULL;
+        return nullptr;
+    }
+    connection->dc = CreateDCA("WINSPOOL", connection->deviceName.c_str(), NULL, NULL);
+    if (!connection->dc) {
+        LOG_ERROR << "❌ Failed to create printer DC for " << connection->deviceName;
+        return nullptr;
+    }
+    connection->dpiX = GetDeviceCaps(connection->dc, LOGPIXELSX);
+    connection->dpiY = GetDeviceCaps(connection->dc, LOGPIXELSY);
+    connection->lastUsed = std::chrono::steady_clock::now();
+    LOG_INFO << "🖨 Opened printer " << connection->deviceName << " (" << connection->dpiX << "x"
+             << connection->dpiY << " dpi)";
+    return connection;
+}
+
+// The spooler answers GetPrinter for a live handle; a failure means the handle is stale
+bool checkConnection(PrinterConnection& connection) {
+    DWORD needed = 0;
+    GetPrinterA(connection.printer, 2, NULL, 0, &needed);
+    if (needed == 0) return false;
+    std::vector<BYTE> buffer(needed);
+    if (!GetPrinterA(connection.printer, 2, buffer.data(), needed, &needed)) return false;
+
+    const PRINTER_INFO_2A* info = reinterpret_cast<const PRINTER_INFO_2A*>(buffer.data());
+    if (info->Status & (PRINTER_STATUS_OFFLINE | PRINTER_STATUS_ERROR | PRINTER_STATUS_NOT_AVAILABLE)) {
+        // Still usable: the Windows spooler holds the job until the printer is back
+        LOG_WARN << "⚠️ Printer " << connection.deviceName << " reports status 0x" << std::hex
+                 << info->Status << std::dec << ", jobs will wait in the Windows spooler";
+    }
+    return true;
+}
+
+/**
+ * @brief Draw one page raster on the printer DC. Supports 8-bit grayscale and 24-bit RGB.
+ */
+bool drawPage(PrinterConnection& connection, const PageRaster& page, const PageInfo& info) {
+    HDC hDC = connection.dc;
+    const Uint8* buffer = page.data;
+    const unsigned long width = page.width;
+    const unsigned long height = page.height;
+    const int bitsPerPixel = page.bitsPerPixel;
+
+    // The page is already resampled to film size at the configured DPI. Map it to the
+    // same physical size on the device; when --dpi matches the printer this is 1:1.
+    int destWidth = (int)width;
+    int destHeight = (int)height;
+    const int deviceDpiX = connection.dpiX;
+    const int deviceDpiY = connection.dpiY;
+    if (info.dpi && deviceDpiX > 0 && deviceDpiY > 0 &&
+        ((unsigned)deviceDpiX != info.dpi || (unsigned)deviceDpiY != info.dpi)) {
+        destWidth = MulDiv((int)width, deviceDpiX, (int)info.dpi);
+        destHeight = MulDiv((int)height, deviceDpiY, (int)info.dpi);
+        SetStretchBltMode(hDC, HALFTONE);
+        SetBrushOrgEx(hDC, 0, 0, NULL);
+        if (!connection.dpiWarned) {
+            LOG_WARN << "⚠️ Page is " << info.dpi << " dpi but printer is " << deviceDpiX << "x" << deviceDpiY
+                     << " dpi; use --dpi " << deviceDpiX << " to avoid device scaling";
+            connection.dpiWarned = true;
+        }
+    }
+
+    BOOL result = FALSE;
+
+    if (bitsPerPixel == 8) {
+        // 8-bit grayscale: need BITMAPINFO with palette (256 entries)
+        struct {
+            BITMAPINFOHEADER bmiHeader;
+            RGBQUAD bmiColors[256];
+        } bmi;
+        ZeroMemory(&bmi, sizeof(bmi));
+        bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        bmi.bmiHeader.biWidth = (LONG)width;
+        bmi.bmiHeader.biHeight = -(LONG)height; // top-down
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 8;
+        bmi.bmiHeader.biCompression = BI_RGB;
+        bmi.bmiHeader.biSizeImage = 0;
+
+        for (int i = 0; i < 256; ++i) {
+            bmi.bmiColors[i].rgbBlue = (BYTE)i;
+            bmi.bmiColors[i].rgbGreen = (BYTE)i;
+            bmi.bmiColors[i].rgbRed = (BYTE)i;
+            bmi.bmiColors[i].rgbReserved = 0;
+        }
+
+        // DIB scanlines are padded to 4 bytes; repack only if the page stride differs
+        const size_t dibStride = PixelKernels::dibStride(width);
+        PooledBytes paddedBuffer;
+        const Uint8* bits = buffer;
+        if (page.stride != dibStride) {
+            if (paddedBuffer.allocate(dibStride * height))
+                PixelKernels::convertStride(buffer, page.stride, paddedBuffer.data(), dibStride, width, height);
+            bits = paddedBuffer.data();
+        }
+
+        // StretchDIBits - it accepts 8-bit buffer with palette
+        int ret = !bits ? GDI_ERROR : StretchDIBits(hDC,
+                                0, 0, destWidth, destHeight,
+                                0, 0, (int)width, (int)height,
+                                bits,
+                                (BITMAPINFO*)&bmi,
+                                DIB_RGB_COLORS,
+                                SRCCOPY);
+        if (ret == GDI_ERROR) {
+            LOG_ERROR << "❌ StretchDIBits failed for 8-bit image";
+            result = FALSE;
+        } else {
+            result = TRUE;
+        }
+    } else if (bitsPerPixel == 24) {
+        // 24-bit: Windows expects BGR and each scanline padded to 4 bytes
+        const int bytesPerPixel = 3;
+        int rowBytes = (int)(width * bytesPerPixel);
+        int dstStride = ((rowBytes + 3) / 4) * 4; // padded to 4 bytes
+        size_t paddedSize = (size_t)dstStride * height;
+
+        // Top-down DIB (negative height below), so rows keep their order.
+        // A page rendered in the preferred layout (BGR, DWORD rows) is passed
+        // straight through; anything else is converted once.
+        PooledBytes paddedBuffer;
+        const Uint8* bits = buffer;
+        if (!page.bgr) {
+            if (paddedBuffer.allocate(paddedSize))
+                PixelKernels::swizzleRGBtoBGR(buffer, page.stride, paddedBuffer.data(), dstStride, width, height);
+            bits = paddedBuffer.data();
+        } else if (page.stride != (size_t)dstStride) {
+            if (paddedBuffer.allocate(paddedSize))
+                PixelKernels::convertStride(buffer, page.stride, paddedBuffer.data(), dstStride, rowBytes, height);
+            bits = paddedBuffer.data();
+        }
+
+        BITMAPINFOHEADER bih;
+        ZeroMemory(&bih, sizeof(bih));
+        bih.biSize = sizeof(BITMAPINFOHEADER);
+        bih.biWidth = (LONG)width;
+        bih.biHeight = -(LONG)height; // top-down
+        bih.biPlanes = 1;
+        bih.biBitCount = 24;
+        bih.biCompression = BI_RGB;
+        bih.biSizeImage = (DWORD)paddedSize;
+
+        // StretchDIBits expects a BITMAPINFO pointer; we can pass pointer to header
+        int ret = !bits ? GDI_ERROR : StretchDIBits(hDC,
+                                0, 0, destWidth, destHeight,
+                                0, 0, (int)width, (int)height,
+                                bits,
+                                (BITMAPINFO*)&bih,
+                                DIB_RGB_COLORS,
+                                SRCCOPY);
+        if (ret == GDI_ERROR) {
+            LOG_ERROR << "❌ StretchDIBits failed for 24-bit image";
+            result = FALSE;
+        } else {
+            result = TRUE;
+        }
+    } else {
+        LOG_ERROR << "❌ Unsupported bitsPerPixel: " << bitsPerPixel;
+        result = FALSE;
+    }
+    return result != FALSE;
+}
+
+} // namespace
+
+// -----------------------------
+// GdiDocument: one StartDoc/EndDoc on a pooled printer DC
+// -----------------------------
+class GdiDocument : public OutputDocument {
+private:
+    GdiOutputBackend& backend_;
+    std::unique_ptr<PrinterConnection> connection_;
+    unsigned long jobId_;
+    unsigned pages_;
+    bool open_;
+    bool healthy_;     ///< false = the DC failed and is closed instead of pooled
+
+public:
+    GdiDocument(GdiOutputBackend& backend, std::unique_ptr<PrinterConnection> connection, unsigned long jobId)
+        : backend_(backend), connection_(std::move(connection)), jobId_(jobId), pages_(0), open_(false),
+          healthy_(true) {}
+
+    ~GdiDocument() override {
+        if (open_) {
+            LOG_WARN << "⚠️ Print document for job #" << jobId_ << " aborted after " << pages_ << " pages";
+            healthy_ = AbortDoc(connection_->dc) > 0 && healthy_;
+        }
+        backend_.releaseConnection(std::move(connection_), healthy_);
+    }
+
+    bool start() {
+        const std::string docName = "DICOM Print job #" + std::to_string(jobId_);
+        DOCINFOA docInfo;
+        ZeroMemory(&docInfo, sizeof(docInfo));
+        docInfo.cbSize = sizeof(docInfo);
+        docInfo.lpszDocName = docName.c_str();
+        if (StartDocA(connection_->dc, &docInfo) <= 0) {
+            LOG_ERROR << "❌ Failed to start print doc on " << connection_->deviceName;
+            healthy_ = false;
+            return false;
+        }
+        open_ = true;
+        return true;
+    }
+
+    bool printPage(const PageRaster& page, const PageInfo& info) override {
+        if (!open_) return false;
+        if (StartPage(connection_->dc) <= 0) {
+            LOG_ERROR << "❌ Failed to start page " << info.pageNumber;
+            healthy_ = false;
+            return false;
+        }
+        const bool drawn = drawPage(*connection_, page, info);
+        if (EndPage(connection_->dc) <= 0) {
+            LOG_ERROR << "❌ Failed to end page " << info.pageNumber;
+            healthy_ = false;
+            return false;
+        }
+        if (drawn) ++pages_;
+        return drawn;
+    }
+
+    bool finish() override {
+        if (!open_) return false;
+        open_ = false;
+        if (EndDoc(connection_->dc) <= 0) {
+            LOG_ERROR << "❌ Failed to end print doc for job #" << jobId_;
+            healthy_ = false;
+            return false;
+        }
+        LOG_INFO << "✅ " << pages_ << (pages_ == 1 ? " page" : " pages") << " sent to printer "
+                 << connection_->deviceName;
+        return true;
+    }
+};
+
+// -----------------------------
+// GdiOutputBackend Implementation
+// -----------------------------
+GdiOutputBackend::GdiOutputBackend() {
+}
+
+GdiOutputBackend::~GdiOutputBackend() {
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    idle_.clear();
+}
+
+std::unique_ptr<PrinterConnection> GdiOutputBackend::acquireConnection(const std::string& printerName) {
+    std::unique_ptr<PrinterConnection> connection;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex_);
+        std::vector<std::unique_ptr<PrinterConnection>>& idle = idle_[printerName];
+        if (!idle.empty()) {
+            connection = std::move(idle.back());
+            idle.pop_back();
+        }
+    }
+
+    if (connection && std::chrono::steady_clock::now() - connection->lastUsed > kHealthCheckAfter &&
+        !checkConnection(*connection)) {
+        LOG_WARN << "⚠️ Printer handle for " << connection->deviceName << " is stale, reopening";
+        connection.reset();
+    }
+    if (!connection) connection = openConnection(printerName);
+    return connection;
+}
+
+void GdiOutputBackend::releaseConnection(std::unique_ptr<PrinterConnection> connection, bool healthy) {
+    if (!connection || !healthy) return; // closed by the destructor, reopened next time
+    connection->lastUsed = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    idle_[connection->printerName].push_back(std::move(connection));
+}
+
+std::unique_ptr<OutputDocument> GdiOutputBackend::openDocument(const PageInfo& info) {
+    std::unique_ptr<PrinterConnection> connection = acquireConnection(info.printerName);
+    if (!connection) return nullptr;
+
+    std::unique_ptr<GdiDocument> document(new GdiDocument(*this, std::move(connection), info.jobId));
+    if (!document->start()) return nullptr;
+    return std::unique_ptr<OutputDocument>(document.release());
+}
+
+bool GdiOutputBackend::printPage(const PageRaster& page, const PageInfo& info) {
+    std::unique_ptr<OutputDocument> document = openDocument(info);
+    return document && document->printPage(page, info) && document->finish();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "OutputBackend.h"
+
+struct PrinterConnection;
+
+/**
+ * @class GdiOutputBackend
+ * @brief إرسال الصفحات إلى طابعة ويندوز عبر GDI (StretchDIBits)
+ *
+ * يحتفظ بمقابض الطابعات و DC مفتوحة لكل طابعة ويعيد استخدامها بين المهام
+ * (فتح الطابعة وإنشاء DC يكلف عشرات إلى مئات الميلي ثانية). المقبض الخامل
+ * لفترة يُفحص قبل استخدامه ويُعاد فتحه إذا لم يعد صالحاً. كل مهمة تُرسل
+ * كمستند واحد (StartDoc) بكل صفحاتها ونسخها.
+ */
+class GdiOutputBackend : public OutputBackend {
+private:
+    std::mutex poolMutex_;
+    std::map<std::string, std::vector<std::unique_ptr<PrinterConnection>>> idle_; ///< اسم الطابعة → مقابض خاملة
+
+    friend class GdiDocument;
+
+public:
+    GdiOutputBackend();
+    ~GdiOutputBackend() override;
+
+    const char* name() const override { return "gdi"; }
+
+    /**
+     * @brief DIB: أسطر محاذاة إلى 4 بايت وترتيب B G R
+     */
+    RasterLayout preferredLayout() const override {
+        RasterLayout layout;
+        layout.rowAlignment = 4;
+        layout.bgr = true;
+        return layout;
+    }
+
+    /**
+     * @brief صفحة واحدة كمستند مستقل
+     */
+    bool printPage(const PageRaster& page, const PageInfo& info) override;
+
+    std::unique_ptr<OutputDocument> openDocument(const PageInfo& info) override;
+
+private:
+    /**
+     * @brief مقبض خامل للطابعة (بعد فحصه) أو مقبض جديد، nullptr عند الفشل
+     */
+    std::unique_ptr<PrinterConnection> acquireConnection(const std::string& printerName);
+
+    /**
+     * @brief إعادة المقبض إلى المجموعة، أو إغلاقه إذا فشل أثناء الاستخدام
+     */
+    void releaseConnection(std::unique_ptr<PrinterConnection> connection, bool healthy);
+};
@@ -0,0 +1,102 @@
+// GrayscaleLut.cpp
+#include "GrayscaleLut.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+
+template <class T>
+void hashCombine(size_t& seed, const T& value) {
+    seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+} // namespace
+
+bool GrayscaleLutKey::operator==(const GrayscaleLutKey& other) const {
+    return bitsAllocated == other.bitsAllocated && bitsStored == other.bitsStored &&
+           highBit == other.highBit && isSigned == other.isSigned &&
+           slope == other.slope && intercept == other.intercept &&
+           center == other.center && width == other.width && invert == other.invert;
+}
+
+size_t GrayscaleLutKeyHash::operator()(const GrayscaleLutKey& key) const {
+    size_t seed = 0;
+    hashCombine(seed, key.bitsAllocated);
+    hashCombine(seed, key.bitsStored);
+    hashCombine(seed, key.highBit);
+    hashCombine(seed, key.isSigned);
+    hashCombine(seed, key.slope);
+    hashCombine(seed, key.intercept);
+    hashCombine(seed, key.center);
+    hashCombine(seed, key.width);
+    hashCombine(seed, key.invert);
+    return seed;
+}
+
+int storedValue(Uint32 raw, int bitsStored, int highBit, bool isSigned) {
+    const int shift = highBit + 1 - bitsStored;
+    const Uint32 mask = (bitsStored >= 32) ? 0xFFFFFFFFu : ((1u << bitsStored) - 1);
+    const Uint32 value = (raw >> shift) & mask;
+    if (isSigned && (value & (1u << (bitsStored - 1))))
+        return (int)value - (1 << bitsStored); // sign extension
+    return (int)value;
+}
+
+std::vector<Uint8> buildGrayscaleLut(const GrayscaleLutKey& key) {
+    const size_t entries = key.bitsAllocated <= 8 ? 256 : 65536;
+    std::vector<Uint8> lut(entries);
+
+    // Linear VOI function, PS3.3 C.11.2.1.2
+    const double c = key.center - 0.5;
+    const double w = std::max(key.width, 1.0) - 1.0;
+    const double lower = c - w / 2.0;
+    const double upper = c + w / 2.0;
+
+    for (size_t raw = 0; raw < entries; ++raw) {
+        const double modality = storedValue((Uint32)raw, key.bitsStored, key.highBit, key.isSigned) *
+                                key.slope + key.intercept;
+        double y;
+        if (modality <= lower) y = 0.0;
+        else if (modality > upper) y = 255.0;
+        else y = (w > 0.0) ? ((modality - c) / w + 0.5) * 255.0 : 255.0;
+
+        Uint8 out = (Uint8)std::lround(y);
+        if (key.invert) out = (Uint8)(255 - out);
+        lut[raw] = out;
+    }
+    return lut;
+}
+
+// -----------------------------
+// LutCache Implementation
+// -----------------------------
+LutCache::LutCache(size_t capacity) : capacity_(capacity ? capacity : 1), hits_(0), misses_(0) {
+}
+
+LutCache::LutPtr LutCache::get(const GrayscaleLutKey& key) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            ++hits_;
+            return it->second->second;
+        }
+    }
+    ++misses_;
+
+    // Build outside the lock; a concurrent miss on the same key just builds twice
+    LutPtr lut = std::make_shared<const std::vector<Uint8>>(buildGrayscaleLut(key));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.find(key) == index_.end()) {
+        entries_.emplace_front(key, lut);
+        index_[key] = entries_.begin();
+        if (entries_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+    return lut;
+}
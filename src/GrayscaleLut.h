@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/ofstd/oftypes.h>
+
+/**
+ * @struct GrayscaleLutKey
+ * @brief كل ما يحدد جدول التحويل: شكل البكسل المخزن، Rescale Slope/Intercept، نافذة VOI الخطية،
+ *        والعكس الناتج عن Presentation LUT Shape / Polarity / MONOCHROME1
+ */
+struct GrayscaleLutKey {
+    int bitsAllocated = 16;   ///< 8 أو 16
+    int bitsStored = 12;
+    int highBit = 11;
+    bool isSigned = false;    ///< Pixel Representation = 1
+    double slope = 1.0;       ///< Rescale Slope
+    double intercept = 0.0;   ///< Rescale Intercept
+    double center = 0.0;      ///< Window Center (بوحدات Modality)
+    double width = 1.0;       ///< Window Width
+    bool invert = false;      ///< الناتج النهائي معكوس (255 - v)
+
+    bool operator==(const GrayscaleLutKey& other) const;
+};
+
+struct GrayscaleLutKeyHash {
+    size_t operator()(const GrayscaleLutKey& key) const;
+};
+
+/**
+ * @brief بناء جدول مفهرس بالكلمة الخام كما هي في الذاكرة (256 أو 65536 مدخل)
+ *
+ * الجدول يدمج استخراج البتات المخزنة وامتداد الإشارة و Rescale Slope/Intercept
+ * ونافذة VOI الخطية والعكس، فيصبح التحويل لكل بكسل قراءة واحدة: out = lut[raw].
+ */
+std::vector<Uint8> buildGrayscaleLut(const GrayscaleLutKey& key);
+
+/**
+ * @brief القيمة المخزنة (بعد استخراج البتات وامتداد الإشارة) لكلمة خام
+ */
+int storedValue(Uint32 raw, int bitsStored, int highBit, bool isSigned);
+
+/**
+ * @class LutCache
+ * @brief ذاكرة مؤقتة (LRU) لجداول التحويل، آمنة للاستخدام من عدة خيوط
+ *
+ * الطباعات المتكررة بنفس الإعدادات (نفس الجهاز ونفس النافذة) تتجاوز بناء الجدول.
+ */
+class LutCache {
+public:
+    typedef std::shared_ptr<const std::vector<Uint8>> LutPtr;
+
+private:
+    typedef std::list<std::pair<GrayscaleLutKey, LutPtr>> EntryList;
+
+    std::mutex mutex_;
+    EntryList entries_; ///< الأحدث استخداماً في المقدمة
+    std::unordered_map<GrayscaleLutKey, EntryList::iterator, GrayscaleLutKeyHash> index_;
+    size_t capacity_;
+    std::atomic<unsigned long> hits_;
+    std::atomic<unsigned long> misses_;
+
+public:
+    /**
+     * @param capacity أقصى عدد جداول محفوظة (الجدول 16bit = 64KB)
+     */
+    explicit LutCache(size_t capacity = 64);
+
+    LutCache(const LutCache&) = delete;
+    LutCache& operator=(const LutCache&) = delete;
+
+    /**
+     * @brief الحصول على الجدول، أو بناؤه وحفظه إذا لم يكن موجوداً
+     */
+    LutPtr get(const GrayscaleLutKey& key);
+
+    unsigned long hits() const { return hits_.load(); }
+    unsigned long misses() const { return misses_.load(); }
+};
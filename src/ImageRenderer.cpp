@@ -0,0 +1,264 @@
+// ImageRenderer.cpp
+#include "ImageRenderer.h"
+#include "Logger.h"
+#include "PixelKernels.h"
+#include "RenderKernels.h"
+#include "Resampler.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcpixel.h>
+#include <dcmtk/dcmdata/dcxfer.h>
+#include <dcmtk/dcmimgle/dcmimage.h>
+
+namespace {
+
+// Aspect-preserving fit; NONE keeps the native size unless it overflows
+void fitSize(unsigned long srcWidth, unsigned long srcHeight,
+             unsigned long maxWidth, unsigned long maxHeight, const std::string& magnificationType,
+             unsigned long& width, unsigned long& height) {
+    double scale = std::min((double)maxWidth / srcWidth, (double)maxHeight / srcHeight);
+    if (magnificationType == "NONE") scale = std::min(scale, 1.0);
+    width = std::max(1UL, std::min(maxWidth, (unsigned long)(srcWidth * scale + 0.5)));
+    height = std::max(1UL, std::min(maxHeight, (unsigned long)(srcHeight * scale + 0.5)));
+}
+
+// Output is inverted once for each of: MONOCHROME1, INVERSE shape, REVERSE polarity
+bool presentationInverts(const RenderOptions& options) {
+    return (options.presentationLutShape == "INVERSE") != (options.polarity == "REVERSE");
+}
+
+// One native-size row into the page row format: gray is replicated on colour
+// pages, RGB swapped on BGR pages. Only width pixels are written.
+void storeRow(const Uint8* src, Uint8* dst, unsigned long width, int channels, const RenderTarget& box) {
+    if (channels == 1 && box.color) {
+        for (unsigned long i = width; i-- > 0;) {
+            const Uint8 value = src[i];
+            dst[3 * i] = value;
+            dst[3 * i + 1] = value;
+            dst[3 * i + 2] = value;
+        }
+    } else if (channels == 3 && box.bgr) {
+        PixelKernels::swizzleRGBtoBGR(src, (size_t)width * 3, dst, (size_t)width * 3, width, 1);
+    } else if (src != dst) {
+        memcpy(dst, src, (size_t)width * channels);
+    }
+}
+
+// First page pixel of an image of the fitted size, centred in its box
+Uint8* fittedOrigin(const RenderTarget& box, unsigned long width, unsigned long height) {
+    const size_t bytesPerPixel = box.color ? 3 : 1;
+    return box.data + (box.height - height) / 2 * box.stride + (box.width - width) / 2 * bytesPerPixel;
+}
+
+// Writes a native-size 8-bit image into the middle of its box in the page, as is
+// or scaled; the resampler writes the page rows directly
+bool fitToTile(const PooledBytes& native, unsigned long srcWidth, unsigned long srcHeight, int channels,
+               const RenderTarget& box, const RenderOptions& options, ThreadPool* pool) {
+    if (channels == 3 && !box.color) {
+        LOG_ERROR << "❌ Colour image on a grayscale page";
+        return false;
+    }
+    unsigned long width = 0, height = 0;
+    fitSize(srcWidth, srcHeight, box.width, box.height, options.magnificationType, width, height);
+    Uint8* dst = fittedOrigin(box, width, height);
+
+    if (width == srcWidth && height == srcHeight) {
+        const size_t srcStride = (size_t)srcWidth * channels;
+        for (unsigned long y = 0; y < height; ++y)
+            storeRow(native.data() + y * srcStride, dst + y * box.stride, width, channels, box);
+        return true;
+    }
+
+    if (!resample8(native.data(), srcWidth, srcHeight, (size_t)srcWidth * channels,
+                   dst, width, height, box.stride,
+                   channels, resampleFilterFor(options.magnificationType), pool)) {
+        LOG_ERROR << "❌ Scaling to " << width << "x" << height << " failed";
+        return false;
+    }
+    // Gray on a colour page or RGB on a BGR page: widen or swap each row in place
+    // (right to left, so a gray pixel is read before its row is overwritten)
+    if ((channels == 1 && box.color) || (channels == 3 && box.bgr)) {
+        for (unsigned long y = 0; y < height; ++y) {
+            Uint8* row = dst + y * box.stride;
+            storeRow(row, row, width, channels, box);
+        }
+    }
+    return true;
+}
+
+// -----------------------------
+// Specialized kernel paths
+// -----------------------------
+// Exactly one frame of stored values (no DicomImage, no min/max scan yet)
+bool readFrame(DcmDataset& dataset, const PixelFormat& format, PooledBytes& raw) {
+    DcmElement* element = nullptr;
+    if (dataset.findAndGetElement(DCM_PixelData, element).bad()) return false;
+    DcmPixelData* pixelData = static_cast<DcmPixelData*>(element);
+    const size_t sampleCount = (size_t)format.rows * format.columns * format.samplesPerPixel;
+    Uint32 frameSize = 0;
+    if (pixelData->getUncompressedFrameSize(&dataset, frameSize).bad() ||
+        frameSize < sampleCount * (format.bitsAllocated / 8)) {
+        LOG_ERROR << "❌ Pixel data too short for " << format.columns << "x" << format.rows;
+        return false;
+    }
+    if (!raw.allocate(((size_t)frameSize + 1) / 2 * 2)) {
+        LOG_ERROR << "❌ Out of memory for " << frameSize << " bytes of pixel data";
+        return false;
+    }
+    Uint32 startFragment = 0;
+    OFString colorModel;
+    OFCondition cond = pixelData->getUncompressedFrame(&dataset, 0, startFragment, raw.data(), frameSize, colorModel);
+    if (cond.bad()) {
+        LOG_ERROR << "❌ Pixel data decode failed: " << cond.text();
+        return false;
+    }
+    return true;
+}
+
+bool renderGrayscale(DcmDataset& dataset, const PixelFormat& format, const RenderKernel& kernel,
+                     const RenderTarget& box, const RenderOptions& options, LutCache& lutCache,
+                     ThreadPool* pool) {
+    GrayscaleLutKey key;
+    key.bitsAllocated = format.bitsAllocated;
+    key.bitsStored = format.bitsStored;
+    key.highBit = format.highBit;
+    key.isSigned = format.isSigned;
+
+    Float64 number = 0.0;
+    if (dataset.findAndGetFloat64(DCM_RescaleSlope, number).good() && number != 0.0) key.slope = number;
+    if (dataset.findAndGetFloat64(DCM_RescaleIntercept, number).good()) key.intercept = number;
+    key.invert = (format.photometric == Photometric::Monochrome1) != presentationInverts(options);
+
+    PooledBytes raw;
+    if (!readFrame(dataset, format, raw)) return false;
+    const size_t pixelCount = (size_t)format.rows * format.columns;
+
+    Float64 center = 0.0, width = 0.0;
+    if (dataset.findAndGetFloat64(DCM_WindowCenter, center).good() &&
+        dataset.findAndGetFloat64(DCM_WindowWidth, width).good() && width >= 1.0) {
+        key.center = center;
+        key.width = width;
+    } else {
+        // Histogram of raw words: one increment per pixel, then min/max from the bins
+        std::vector<Uint32> histogram((size_t)1 << format.bitsAllocated, 0);
+        kernel.histogram(raw.data(), pixelCount, histogram.data());
+
+        int minValue = 0, maxValue = 0;
+        bool first = true;
+        for (size_t word = 0; word < histogram.size(); ++word) {
+            if (!histogram[word]) continue;
+            const int stored = storedValue((Uint32)word, key.bitsStored, key.highBit, key.isSigned);
+            if (first || stored < minValue) minValue = stored;
+            if (first || stored > maxValue) maxValue = stored;
+            first = false;
+        }
+        double low = minValue * key.slope + key.intercept;
+        double high = maxValue * key.slope + key.intercept;
+        if (low > high) std::swap(low, high);
+        key.center = (low + high + 1.0) / 2.0;
+        key.width = high - low + 1.0;
+    }
+
+    // One table lookup per pixel does the whole grayscale pipeline
+    LutCache::LutPtr lut = lutCache.get(key);
+
+    // At native size the lookup writes the page rows directly (widened on colour pages)
+    unsigned long fitWidth = 0, fitHeight = 0;
+    fitSize(format.columns, format.rows, box.width, box.height, options.magnificationType, fitWidth, fitHeight);
+    if (fitWidth == format.columns && fitHeight == format.rows) {
+        Uint8* dst = fittedOrigin(box, fitWidth, fitHeight);
+        const size_t srcStride = (size_t)format.columns * (format.bitsAllocated / 8);
+        for (unsigned long y = 0; y < fitHeight; ++y) {
+            Uint8* row = dst + y * box.stride;
+            kernel.mapGray(raw.data() + y * srcStride, lut->data(), row, fitWidth);
+            storeRow(row, row, fitWidth, 1, box);
+        }
+        return true;
+    }
+
+    PooledBytes display;
+    if (!display.allocate(pixelCount)) return false;
+    kernel.mapGray(raw.data(), lut->data(), display.data(), pixelCount);
+
+    return fitToTile(display, format.columns, format.rows, 1, box, options, pool);
+}
+
+bool renderColor(DcmDataset& dataset, const PixelFormat& format, const RenderKernel& kernel,
+                 const RenderTarget& box, const RenderOptions& options, ThreadPool* pool) {
+    PooledBytes raw;
+    if (!readFrame(dataset, format, raw)) return false;
+    const size_t pixelCount = (size_t)format.rows * format.columns;
+
+    // Colour is printed as stored: no VOI window and no polarity, as with DicomImage
+    PooledBytes native;
+    if (!native.allocate(pixelCount * 3)) return false;
+    kernel.toRGB(raw.data(), native.data(), pixelCount);
+
+    return fitToTile(native, format.columns, format.rows, 3, box, options, pool);
+}
+
+// -----------------------------
+// Generic path (palette, YBR 4:2:2, 1/32-bit...)
+// -----------------------------
+bool renderWithDicomImage(DcmDataset& dataset, const RenderTarget& box, const RenderOptions& options,
+                          ThreadPool* pool) {
+    // Partial access: only the first frame is loaded and decompressed
+    DicomImage dcmImage(&dataset, EXS_Unknown, CIF_UsePartialAccessToPixelData, 0, 1);
+    if (dcmImage.getStatus() != EIS_Normal) {
+        LOG_ERROR << "❌ Error reading DICOM Image (status=" << dcmImage.getStatus() << ")";
+        return false;
+    }
+
+    // The stored VOI first (a window with its VOI LUT Function, else a VOI LUT
+    // table), automatic windowing otherwise; the Modality LUT is DicomImage's own
+    if (dcmImage.getWindowCount() > 0)
+        dcmImage.setWindow(0UL);
+    else if (dcmImage.getVoiLutCount() > 0)
+        dcmImage.setVoiLut(0UL);
+    else
+        dcmImage.setMinMaxWindow();
+
+    // Native-size 8-bit output; scaling is done by our own resampler, not DicomImage
+    const unsigned long srcWidth = dcmImage.getWidth();
+    const unsigned long srcHeight = dcmImage.getHeight();
+    const int channels = dcmImage.isMonochrome() ? 1 : 3;
+    PooledBytes native;
+    if (!native.allocate((size_t)srcWidth * srcHeight * channels)) {
+        LOG_ERROR << "❌ Out of memory for a " << srcWidth << "x" << srcHeight << " image";
+        return false;
+    }
+    if (!dcmImage.getOutputData(native.data(), native.size(), 8)) {
+        LOG_ERROR << "❌ getOutputData failed";
+        return false;
+    }
+
+    // DicomImage already presents MONOCHROME1 the right way up
+    if (channels == 1 && presentationInverts(options))
+        PixelKernels::invert8(native.data(), native.data(), native.size());
+
+    return fitToTile(native, srcWidth, srcHeight, channels, box, options, pool);
+}
+
+} // namespace
+
+bool renderImageToFit(DcmDataset& dataset, const RenderTarget& box, const RenderOptions& options,
+                      LutCache& lutCache, ThreadPool* pool) {
+    if (!box.data || box.width == 0 || box.height == 0) return false;
+
+    // The pixel module picks one specialized kernel; nothing inside the loops branches on it
+    PixelFormat format;
+    const RenderKernel* kernel = readPixelFormat(dataset, format) ? selectRenderKernel(format) : nullptr;
+    // Compressed colour can decode to another layout than its attributes describe
+    if (kernel && kernel->color && DcmXfer(dataset.getOriginalXfer()).isEncapsulated()) kernel = nullptr;
+
+    if (kernel) {
+        LOG_TRACE << "Render kernel " << kernel->name << " for " << format.columns << "x" << format.rows;
+        if (kernel->color) return renderColor(dataset, format, *kernel, box, options, pool);
+        return renderGrayscale(dataset, format, *kernel, box, options, lutCache, pool);
+    }
+    return renderWithDicomImage(dataset, box, options, pool);
+}
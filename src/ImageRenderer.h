@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcdatset.h>
+
+#include "BufferPool.h"
+#include "GrayscaleLut.h"
+
+class ThreadPool;
+
+/**
+ * @struct RenderTarget
+ * @brief مستطيل المربع داخل الصفحة، يكتب العرض فيه مباشرة بطول سطر الصفحة
+ *
+ * المربعات لا تتداخل، فيمكن عرض عدة مربعات من نفس الصفحة في خيوط مختلفة.
+ */
+struct RenderTarget {
+    Uint8* data = nullptr;      ///< أول بكسل في المربع
+    size_t stride = 0;          ///< طول سطر الصفحة بالبايت
+    unsigned long width = 0;    ///< عرض المربع بالبكسل
+    unsigned long height = 0;   ///< ارتفاع المربع بالبكسل
+    bool color = false;         ///< صفحة 24bit (الصور الرمادية تُكرر في القنوات الثلاث)
+    bool bgr = false;           ///< ترتيب قنوات الصفحة الملونة B G R
+};
+
+/**
+ * @struct RenderOptions
+ * @brief خصائص Film Box / Image Box التي تؤثر على عرض الصورة
+ */
+struct RenderOptions {
+    std::string magnificationType;    ///< REPLICATE / BILINEAR / CUBIC / NONE / فارغ
+    std::string polarity;             ///< NORMAL / REVERSE
+    std::string presentationLutShape; ///< IDENTITY / INVERSE / LIN OD / فارغ
+};
+
+/**
+ * @brief تحويل صورة DICOM إلى 8bit/24bit وتصغيرها/تكبيرها لتناسب مربعاً
+ *        مع الحفاظ على نسبة الأبعاد
+ *
+ * صيغة البكسلات تختار نواة مخصصة مرة واحدة (RenderKernels). الصور الرمادية
+ * (8/16bit) تمر بمرحلة واحدة مدمجة: القيمة المخزنة → جدول واحد يجمع Rescale Slope /
+ * Intercept ونافذة VOI الخطية و Presentation LUT Shape و Polarity و MONOCHROME1،
+ * والجداول تُحفظ في LutCache. الصور الملونة RGB / YBR_FULL بعمق 8bit تُحول مباشرة
+ * إلى R G B. الترميزات الأخرى، والصور ذات Modality/VOI LUT Sequence أو VOI LUT
+ * Function غير LINEAR، تمر عبر DicomImage.
+ * التحجيم إلى أبعاد المربع يتم بـ resample8 حسب Magnification Type، ويكتب الناتج
+ * في وسط المربع داخل الصفحة مباشرة دون مخزن وسيط؛ ما حوله من المربع لا يتغير.
+ *
+ * @param dataset بيانات الصورة
+ * @param box مستطيل المربع في الصفحة
+ * @param options طريقة التحجيم والقطبية وشكل Presentation LUT
+ * @param lutCache ذاكرة جداول التحويل المشتركة
+ * @param pool خيوط التحجيم (nullptr = في الخيط الحالي)
+ * @return false عند فشل قراءة الصورة أو تحويلها
+ */
+bool renderImageToFit(DcmDataset& dataset, const RenderTarget& box, const RenderOptions& options,
+                      LutCache& lutCache, ThreadPool* pool);
@@ -0,0 +1,317 @@
+// Logger.cpp
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+
+namespace {
+
+const char* LEVEL_NAMES[] = { "TRACE", "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+const size_t kRingCapacity = 4096;   // records per thread before dropping
+const int kDrainIntervalMs = 20;
+
+struct LogEntry {
+    int64_t timeMicros = 0;          // wall clock, for the timestamp and ordering
+    LogLevel level = LogLevel::Info;
+    LogContext context;
+    unsigned threadId = 0;
+    std::string text;
+};
+
+int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void formatLine(const LogEntry& entry, std::string& line) {
+    const time_t seconds = (time_t)(entry.timeMicros / 1000000);
+    tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char prefix[64];
+    const size_t n = strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &local);
+    snprintf(prefix + n, sizeof(prefix) - n, ".%03d %s [t%u", (int)(entry.timeMicros / 1000 % 1000),
+             LEVEL_NAMES[(int)entry.level], entry.threadId);
+
+    line = prefix;
+    if (entry.context.associationId) line += " a" + std::to_string(entry.context.associationId);
+    if (entry.context.jobId) line += " j" + std::to_string(entry.context.jobId);
+    line += "] ";
+    line += entry.text;
+    line += '\n';
+}
+
+} // namespace
+
+// -----------------------------
+// LogRing: single producer (the owning thread), single consumer (the writer)
+// -----------------------------
+class LogRing {
+private:
+    std::vector<LogEntry> slots_;
+    std::atomic<size_t> head_; // next slot the producer writes
+    std::atomic<size_t> tail_; // next slot the consumer reads
+
+public:
+    const unsigned threadId;
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> orphaned; // owning thread has exited
+
+    explicit LogRing(unsigned id)
+        : slots_(kRingCapacity), head_(0), tail_(0), threadId(id), dropped(0), orphaned(false) {}
+
+    bool push(LogEntry& entry) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= slots_.size()) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots_[head % slots_.size()] = std::move(entry);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    void drain(std::vector<LogEntry>& out) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        for (size_t i = tail; i != head; ++i) out.push_back(std::move(slots_[i % slots_.size()]));
+        tail_.store(head, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+};
+
+namespace {
+
+// Marks the ring orphaned when its thread exits so the writer can retire it
+struct ThreadRingHandle {
+    std::shared_ptr<LogRing> ring;
+    ~ThreadRingHandle() {
+        if (ring) ring->orphaned = true;
+    }
+};
+
+thread_local ThreadRingHandle t_ring;
+thread_local LogContext t_context;
+
+} // namespace
+
+bool parseLogLevel(const std::string& name, LogLevel& level) {
+    const char* names[] = { "trace", "debug", "info", "warn", "error", "off" };
+    for (int i = 0; i <= (int)LogLevel::Off; ++i) {
+        if (name == names[i]) {
+            level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// -----------------------------
+// Logger Implementation
+// -----------------------------
+std::atomic<int> Logger::threshold_((int)LogLevel::Info);
+
+Logger::Logger() : nextThreadId_(1), running_(false), retiredDropped_(0) {
+}
+
+Logger::~Logger() {
+    stop();
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+LogContext& Logger::context() {
+    return t_context;
+}
+
+LogRing& Logger::threadRing() {
+    if (!t_ring.ring) {
+        t_ring.ring = std::make_shared<LogRing>(nextThreadId_++);
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        rings_.push_back(t_ring.ring);
+    }
+    return *t_ring.ring;
+}
+
+bool Logger::start(const ServerConfig& config) {
+    LogLevel level = LogLevel::Info;
+    parseLogLevel(config.logLevel, level);
+    setLevel(level);
+
+    bool ok = true;
+    {
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        console_ = config.logConsole;
+        filePath_ = config.logFile;
+        maxFileBytes_ = (uint64_t)config.logMaxSizeMB * 1024 * 1024;
+        maxFiles_ = config.logMaxFiles;
+        if (!filePath_.empty()) {
+            file_ = fopen(filePath_.c_str(), "ab");
+            if (file_) {
+                fseek(file_, 0, SEEK_END);
+                fileBytes_ = (uint64_t)ftell(file_);
+            } else {
+                console_ = true; // never lose the log entirely
+                ok = false;
+            }
+        }
+    }
+    if (!ok) std::cerr << "❌ Cannot open log file " << config.logFile << std::endl;
+
+    running_ = true;
+    writer_ = std::thread(&Logger::writerLoop, this);
+    return ok;
+}
+
+void Logger::stop() {
+    if (!running_.exchange(false)) return;
+    wake_.notify_one();
+    if (writer_.joinable()) writer_.join();
+    drain(); // records pushed while the writer was exiting
+
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+    console_ = true;
+}
+
+void Logger::submit(LogLevel level, std::string&& text) {
+    LogEntry entry;
+    entry.timeMicros = nowMicros();
+    entry.level = level;
+    entry.context = t_context;
+    entry.text = std::move(text);
+
+    LogRing& ring = threadRing();
+    entry.threadId = ring.threadId;
+
+    // No writer yet (startup) or any more (shutdown): write straight through
+    if (!running_.load(std::memory_order_acquire)) {
+        std::string line;
+        formatLine(entry, line);
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        writeLine(level, line);
+        return;
+    }
+    ring.push(entry);
+    if (level >= LogLevel::Error) wake_.notify_one(); // errors show up promptly
+}
+
+uint64_t Logger::dropped() {
+    std::lock_guard<std::mutex> lock(ringsMutex_);
+    uint64_t total = retiredDropped_.load();
+    for (const std::shared_ptr<LogRing>& ring : rings_) total += ring->dropped.load();
+    return total;
+}
+
+void Logger::writerLoop() {
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wake_.wait_for(lock, std::chrono::milliseconds(kDrainIntervalMs));
+        }
+        drain();
+    }
+    drain(); // whatever was logged before stop()
+}
+
+bool Logger::drain() {
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        rings = rings_;
+    }
+
+    std::vector<LogEntry> entries;
+    for (const std::shared_ptr<LogRing>& ring : rings) ring->drain(entries);
+
+    // Retire rings of exited threads once they are empty; their drops stay counted
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        auto retired = std::remove_if(rings_.begin(), rings_.end(), [](const std::shared_ptr<LogRing>& ring) {
+            return ring->orphaned && ring->empty();
+        });
+        for (auto it = retired; it != rings_.end(); ++it) retiredDropped_ += (*it)->dropped.load();
+        rings_.erase(retired, rings_.end());
+
+        dropped = retiredDropped_.load();
+        for (const std::shared_ptr<LogRing>& ring : rings_) dropped += ring->dropped.load();
+    }
+
+    if (entries.empty() && dropped == droppedReported_) return false;
+
+    // Interleave the threads by time; stable keeps each thread's own order
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const LogEntry& a, const LogEntry& b) { return a.timeMicros < b.timeMicros; });
+
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    std::string line;
+    for (const LogEntry& entry : entries) {
+        formatLine(entry, line);
+        writeLine(entry.level, line);
+    }
+    if (dropped != droppedReported_) {
+        LogEntry note;
+        note.timeMicros = nowMicros();
+        note.level = LogLevel::Warn;
+        note.text = "⚠ " + std::to_string(dropped - droppedReported_) + " log records dropped (ring full)";
+        formatLine(note, line);
+        writeLine(note.level, line);
+        droppedReported_ = dropped;
+    }
+    if (console_) {
+        fflush(stdout);
+        fflush(stderr);
+    }
+    if (file_) fflush(file_);
+    return true;
+}
+
+// Caller holds outputMutex_
+void Logger::writeLine(LogLevel level, const std::string& line) {
+    if (console_) fwrite(line.data(), 1, line.size(), level >= LogLevel::Warn ? stderr : stdout);
+    if (!file_) return;
+
+    if (maxFileBytes_ && fileBytes_ + line.size() > maxFileBytes_ && fileBytes_ > 0) rotate();
+    if (!file_) return;
+    fwrite(line.data(), 1, line.size(), file_);
+    fileBytes_ += line.size();
+}
+
+// log → log.1 → log.2 ... the oldest beyond maxFiles_ is deleted
+void Logger::rotate() {
+    fclose(file_);
+    file_ = nullptr;
+
+    if (maxFiles_ == 0) {
+        std::remove(filePath_.c_str());
+    } else {
+        std::remove((filePath_ + "." + std::to_string(maxFiles_)).c_str());
+        for (unsigned i = maxFiles_; i > 1; --i)
+            std::rename((filePath_ + "." + std::to_string(i - 1)).c_str(),
+                        (filePath_ + "." + std::to_string(i)).c_str());
+        std::rename(filePath_.c_str(), (filePath_ + ".1").c_str());
+    }
+
+    file_ = fopen(filePath_.c_str(), "wb");
+    fileBytes_ = 0;
+    if (!file_) {
+        console_ = true;
+        const char message[] = "❌ Cannot reopen log file after rotation\n";
+        fwrite(message, 1, sizeof(message) - 1, stderr);
+    }
+}
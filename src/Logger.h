@@ -0,0 +1,171 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ServerConfig.h"
+
+/**
+ * @brief مستويات السجل (Off يعطل كل شيء)
+ */
+enum class LogLevel {
+    Trace = 0,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+/**
+ * @brief تحويل اسم المستوى (trace/debug/info/warn/error/off)
+ * @return false إذا كان الاسم غير معروف
+ */
+bool parseLogLevel(const std::string& name, LogLevel& level);
+
+/**
+ * @struct LogContext
+ * @brief معرفات تُرفق بكل سجل يكتبه الخيط (0 = غير محدد)
+ */
+struct LogContext {
+    unsigned long associationId = 0;
+    unsigned long jobId = 0;
+};
+
+class LogRing;
+
+/**
+ * @class Logger
+ * @brief سجل غير متزامن: كل خيط يكتب في حلقة خاصة به (منتج واحد / مستهلك واحد)
+ *        دون أقفال، وخيط كاتب واحد يفرغ كل الحلقات ويرتبها زمنياً ثم يكتبها في
+ *        الشاشة و/أو ملف مع التدوير حسب الحجم.
+ *
+ * المستوى المعطل يكلف قراءة atomic واحدة ولا يُنشأ النص أصلاً. إذا امتلأت حلقة
+ * خيط ما يُسقط السجل ويُعد، ولا ينتظر الخيط أبداً. قبل start() وبعد stop()
+ * تُكتب السجلات مباشرة في الشاشة.
+ */
+class Logger {
+private:
+    static std::atomic<int> threshold_; ///< أدنى مستوى مفعل
+
+    std::mutex ringsMutex_;                    ///< يحمي القائمة فقط (تسجيل خيط جديد)
+    std::vector<std::shared_ptr<LogRing>> rings_;
+    std::atomic<unsigned> nextThreadId_;
+
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> retiredDropped_;     ///< السجلات المُسقطة من خيوط انتهت
+    std::thread writer_;
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::mutex outputMutex_;                   ///< الكتابة (الكاتب أو الكتابة المباشرة)
+
+    bool console_ = true;
+    std::string filePath_;
+    FILE* file_ = nullptr;
+    uint64_t fileBytes_ = 0;
+    uint64_t maxFileBytes_ = 0;                ///< 0 = بدون تدوير
+    unsigned maxFiles_ = 0;
+    uint64_t droppedReported_ = 0;             ///< آخر عدد سجلات مُسقطة تم الإبلاغ عنه
+
+    Logger();
+
+public:
+    ~Logger();
+
+    static Logger& instance();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    static bool enabled(LogLevel level) {
+        return (int)level >= threshold_.load(std::memory_order_relaxed);
+    }
+    static void setLevel(LogLevel level) { threshold_.store((int)level, std::memory_order_relaxed); }
+
+    /**
+     * @brief تطبيق إعدادات السجل وتشغيل خيط الكتابة
+     * @return false إذا تعذر فتح ملف السجل (يبقى السجل على الشاشة)
+     */
+    bool start(const ServerConfig& config);
+
+    /**
+     * @brief تفريغ كل ما تبقى وإيقاف خيط الكتابة
+     */
+    void stop();
+
+    /**
+     * @brief إضافة سجل من الخيط الحالي (تستخدمه LogRecord)
+     */
+    void submit(LogLevel level, std::string&& text);
+
+    /**
+     * @brief معرفات الخيط الحالي (تُضبط عبر LogScope)
+     */
+    static LogContext& context();
+
+    uint64_t dropped();
+
+private:
+    LogRing& threadRing();
+    void writerLoop();
+    bool drain();
+    void writeLine(LogLevel level, const std::string& line);
+    void rotate();
+};
+
+/**
+ * @class LogScope
+ * @brief ضبط معرف الاتصال و/أو المهمة للخيط الحالي حتى نهاية النطاق
+ */
+class LogScope {
+private:
+    LogContext saved_;
+
+public:
+    explicit LogScope(const LogContext& context) : saved_(Logger::context()) { Logger::context() = context; }
+    ~LogScope() { Logger::context() = saved_; }
+
+    LogScope(const LogScope&) = delete;
+    LogScope& operator=(const LogScope&) = delete;
+};
+
+/**
+ * @class LogRecord
+ * @brief سجل واحد يُبنى بـ << ويُرسل عند الهدم (لا يُستخدم مباشرة، بل عبر LOG_*)
+ */
+class LogRecord {
+private:
+    LogLevel level_;
+    std::ostringstream stream_;
+
+public:
+    explicit LogRecord(LogLevel level) : level_(level) {}
+    ~LogRecord() { Logger::instance().submit(level_, stream_.str()); }
+
+    std::ostream& stream() { return stream_; }
+};
+
+/**
+ * @brief يحول سلسلة << إلى تعبير void حتى يعمل الماكرو داخل if/else دون أقواس
+ */
+struct LogVoidify {
+    void operator&(std::ostream&) {}
+};
+
+// النص بعد الماكرو لا يُقيَّم إطلاقاً إذا كان المستوى معطلاً
+#define DICOM_LOG(level) \
+    !Logger::enabled(level) ? (void)0 : LogVoidify() & LogRecord(level).stream()
+
+#define LOG_TRACE DICOM_LOG(LogLevel::Trace)
+#define LOG_DEBUG DICOM_LOG(LogLevel::Debug)
+#define LOG_INFO DICOM_LOG(LogLevel::Info)
+#define LOG_WARN DICOM_LOG(LogLevel::Warn)
+#define LOG_ERROR DICOM_LOG(LogLevel::Error)
@@ -0,0 +1,134 @@
+// Metrics.cpp
+#include "Metrics.h"
+#include <cstdio>
+
+namespace {
+
+const char* STAGE_NAMES[] = {
+    "association_setup", "dataset_receive", "decode", "render", "composite", "spool"
+};
+
+void appendNumber(std::string& out, double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.15g", value);
+    out += text;
+}
+
+} // namespace
+
+// -----------------------------
+// LatencyHistogram Implementation
+// -----------------------------
+const double LatencyHistogram::kBounds[LatencyHistogram::kBuckets] = {
+    0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0
+};
+
+LatencyHistogram::LatencyHistogram() : count_(0), sumMicros_(0) {
+    for (std::atomic<uint64_t>& bucket : buckets_) bucket = 0;
+}
+
+void LatencyHistogram::record(uint64_t micros) {
+    const double seconds = micros / 1e6;
+    size_t i = 0;
+    while (i < kBuckets && seconds > kBounds[i]) ++i;
+    buckets_[i].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sumMicros_.fetch_add(micros, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::render(const std::string& name, const std::string& labels, std::string& out) const {
+    const std::string prefix = labels.empty() ? std::string() : labels + ",";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= kBuckets; ++i) {
+        cumulative += buckets_[i].load(std::memory_order_relaxed);
+        std::string le = "+Inf";
+        if (i < kBuckets) {
+            le.clear();
+            appendNumber(le, kBounds[i]);
+        }
+        appendSample(out, name + "_bucket", prefix + "le=\"" + le + "\"", (double)cumulative);
+    }
+    appendSample(out, name + "_sum", labels, sumMicros_.load(std::memory_order_relaxed) / 1e6);
+    appendSample(out, name + "_count", labels, (double)count_.load(std::memory_order_relaxed));
+}
+
+// -----------------------------
+// Metrics Implementation
+// -----------------------------
+Metrics::Metrics()
+    : associationsAccepted_(0), associationsRejected_(0), jobsSubmitted_(0), jobsRejected_(0),
+      jobsCompleted_(0), jobsFailed_(0), bytesReceived_(0) {
+}
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+void Metrics::dimseResponse(const char* command, Uint16 status) {
+    std::lock_guard<std::mutex> lock(dimseMutex_);
+    ++dimseResponses_[std::make_pair(std::string(command), status)];
+}
+
+void Metrics::renderPrometheus(std::string& out) {
+    appendHeader(out, "dicom_print_stage_duration_seconds", "histogram",
+                 "Time spent in each pipeline stage.");
+    for (size_t i = 0; i < (size_t)Stage::Count; ++i)
+        stages_[i].render("dicom_print_stage_duration_seconds",
+                          std::string("stage=\"") + STAGE_NAMES[i] + "\"", out);
+
+    appendHeader(out, "dicom_print_associations_total", "counter", "Associations by outcome.");
+    appendSample(out, "dicom_print_associations_total", "result=\"accepted\"",
+                 (double)associationsAccepted_.load());
+    appendSample(out, "dicom_print_associations_total", "result=\"rejected\"",
+                 (double)associationsRejected_.load());
+
+    appendHeader(out, "dicom_print_jobs_total", "counter", "Print jobs by outcome.");
+    appendSample(out, "dicom_print_jobs_total", "result=\"submitted\"", (double)jobsSubmitted_.load());
+    appendSample(out, "dicom_print_jobs_total", "result=\"rejected\"", (double)jobsRejected_.load());
+    appendSample(out, "dicom_print_jobs_total", "result=\"completed\"", (double)jobsCompleted_.load());
+    appendSample(out, "dicom_print_jobs_total", "result=\"failed\"", (double)jobsFailed_.load());
+
+    appendMetric(out, "dicom_print_received_bytes_total", "counter",
+                 "Dataset bytes received in DIMSE messages.", (double)bytesReceived_.load());
+
+    appendHeader(out, "dicom_print_dimse_responses_total", "counter",
+                 "DIMSE responses sent, by command and status.");
+    std::lock_guard<std::mutex> lock(dimseMutex_);
+    for (const auto& entry : dimseResponses_) {
+        char status[8];
+        std::snprintf(status, sizeof(status), "0x%04X", entry.first.second);
+        appendSample(out, "dicom_print_dimse_responses_total",
+                     "command=\"" + entry.first.first + "\",status=\"" + status + "\"",
+                     (double)entry.second);
+    }
+}
+
+void appendHeader(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void appendSample(std::string& out, const std::string& name, const std::string& labels, double value) {
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    appendNumber(out, value);
+    out += '\n';
+}
+
+void appendMetric(std::string& out, const char* name, const char* type, const char* help, double value) {
+    appendHeader(out, name, type, help);
+    appendSample(out, name, std::string(), value);
+}
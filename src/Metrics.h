@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/ofstd/oftypes.h>
+
+/**
+ * @brief مراحل خط المعالجة التي يُقاس زمنها
+ */
+enum class Stage {
+    AssociationSetup = 0, ///< التفاوض وقبول الاتصال
+    DatasetReceive,       ///< استلام Dataset من الشبكة
+    Decode,               ///< فك ضغط صورة واحدة
+    Render,               ///< تحويل وتحجيم مربع صورة واحد
+    Composite,            ///< تركيب صفحة Film Box كاملة
+    Spool,                ///< إرسال صفحة إلى المخرج
+    Count
+};
+
+/**
+ * @class LatencyHistogram
+ * @brief مدرج تكراري بحدود ثابتة (ثوانٍ)؛ التسجيل عمليتا atomic دون أقفال
+ */
+class LatencyHistogram {
+public:
+    static const size_t kBuckets = 14; ///< + الخانة الأخيرة (+Inf)
+    static const double kBounds[kBuckets];
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets + 1];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sumMicros_;
+
+public:
+    LatencyHistogram();
+
+    void record(uint64_t micros);
+
+    /**
+     * @brief إضافة المدرج بصيغة Prometheus (التكرارات تراكمية)
+     */
+    void render(const std::string& name, const std::string& labels, std::string& out) const;
+};
+
+/**
+ * @class Metrics
+ * @brief عدادات ومدرجات الخادم (نسخة واحدة مشتركة بين كل الخيوط)
+ */
+class Metrics {
+private:
+    LatencyHistogram stages_[(size_t)Stage::Count];
+
+    std::atomic<uint64_t> associationsAccepted_;
+    std::atomic<uint64_t> associationsRejected_;
+    std::atomic<uint64_t> jobsSubmitted_;
+    std::atomic<uint64_t> jobsRejected_;
+    std::atomic<uint64_t> jobsCompleted_;
+    std::atomic<uint64_t> jobsFailed_;
+    std::atomic<uint64_t> bytesReceived_;
+
+    std::mutex dimseMutex_;
+    std::map<std::pair<std::string, Uint16>, uint64_t> dimseResponses_; ///< (الأمر، الحالة) → العدد
+
+    Metrics();
+
+public:
+    static Metrics& instance();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    void recordStage(Stage stage, uint64_t micros) { stages_[(size_t)stage].record(micros); }
+
+    void associationAccepted() { ++associationsAccepted_; }
+    void associationRejected() { ++associationsRejected_; }
+    void jobSubmitted() { ++jobsSubmitted_; }
+    void jobRejected() { ++jobsRejected_; }
+    void jobFinished(bool ok) { ++(ok ? jobsCompleted_ : jobsFailed_); }
+    void addBytesReceived(uint64_t bytes) { bytesReceived_ += bytes; }
+
+    /**
+     * @brief عدّ رد DIMSE حسب الأمر وحالة الرد (الفشل يظهر بحالته)
+     */
+    void dimseResponse(const char* command, Uint16 status);
+
+    /**
+     * @brief كل العدادات والمدرجات بصيغة Prometheus النصية
+     */
+    void renderPrometheus(std::string& out);
+};
+
+/**
+ * @class StageTimer
+ * @brief قياس زمن مرحلة من الإنشاء حتى الهدم
+ */
+class StageTimer {
+private:
+    Stage stage_;
+    std::chrono::steady_clock::time_point start_;
+
+public:
+    explicit StageTimer(Stage stage) : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+    ~StageTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        Metrics::instance().recordStage(
+            stage_, (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+};
+
+/**
+ * @brief سطرا HELP و TYPE لمقياس Prometheus
+ */
+void appendHeader(std::string& out, const char* name, const char* type, const char* help);
+
+/**
+ * @brief قيمة واحدة لمقياس Prometheus مع وسومها (labels فارغة = بدون وسوم)
+ */
+void appendSample(std::string& out, const std::string& name, const std::string& labels, double value);
+
+/**
+ * @brief إضافة عداد أو مقياس واحد بصيغة Prometheus (HELP + TYPE + القيمة)
+ */
+void appendMetric(std::string& out, const char* name, const char* type, const char* help, double value);
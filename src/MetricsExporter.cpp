@@ -0,0 +1,177 @@
+// MetricsExporter.cpp
+#include "MetricsExporter.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET SocketHandle;
+#define CLOSE_SOCKET closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define INVALID_SOCKET (-1)
+#define CLOSE_SOCKET close
+#endif
+
+namespace {
+
+const size_t kMaxRequestBytes = 4096;
+
+void sendAll(SocketHandle socket, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const int n = (int)send(socket, data.data() + sent, (int)(data.size() - sent), 0);
+        if (n <= 0) return;
+        sent += (size_t)n;
+    }
+}
+
+} // namespace
+
+// -----------------------------
+// MetricsExporter Implementation
+// -----------------------------
+MetricsExporter::MetricsExporter(const ServerConfig& config, Renderer render)
+    : config_(config), render_(render), stopping_(false) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start() {
+    if (config_.metricsPort == 0 && config_.metricsFile.empty()) return true;
+
+    SocketHandle listenSocket = INVALID_SOCKET;
+    if (config_.metricsPort != 0) {
+        listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listenSocket == INVALID_SOCKET) {
+            LOG_ERROR << "❌ Cannot create metrics socket";
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+        // Local scrape endpoint only
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons((unsigned short)config_.metricsPort);
+        if (bind(listenSocket, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenSocket, 8) != 0) {
+            LOG_ERROR << "❌ Cannot listen for metrics on 127.0.0.1:" << config_.metricsPort;
+            CLOSE_SOCKET(listenSocket);
+            return false;
+        }
+        LOG_INFO << "📈 Metrics on http://127.0.0.1:" << config_.metricsPort << "/metrics";
+    }
+    if (!config_.metricsFile.empty())
+        LOG_INFO << "📈 Metrics written to " << config_.metricsFile << " every "
+                 << config_.metricsIntervalSec << " s";
+
+    stopping_ = false;
+    thread_ = std::thread(&MetricsExporter::run, this, (intptr_t)listenSocket);
+    return true;
+}
+
+void MetricsExporter::stop() {
+    stopping_ = true;
+    if (thread_.joinable()) thread_.join();
+}
+
+void MetricsExporter::run(intptr_t handle) {
+    const SocketHandle listenSocket = (SocketHandle)handle;
+    auto nextDump = std::chrono::steady_clock::now();
+
+    while (!stopping_) {
+        if (!config_.metricsFile.empty() && std::chrono::steady_clock::now() >= nextDump) {
+            writeFile();
+            nextDump = std::chrono::steady_clock::now() + std::chrono::seconds(config_.metricsIntervalSec);
+        }
+
+        // One-second slices so stop() and the file timer are honoured
+        if (listenSocket == INVALID_SOCKET) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            continue;
+        }
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listenSocket, &readable);
+        timeval timeout = { 1, 0 };
+        if (select((int)listenSocket + 1, &readable, NULL, NULL, &timeout) <= 0) continue;
+
+        SocketHandle client = accept(listenSocket, NULL, NULL);
+        if (client == INVALID_SOCKET) continue;
+        serveClient((intptr_t)client);
+        CLOSE_SOCKET(client);
+    }
+
+    if (listenSocket != INVALID_SOCKET) CLOSE_SOCKET(listenSocket);
+    if (!config_.metricsFile.empty()) writeFile(); // final snapshot
+}
+
+void MetricsExporter::serveClient(intptr_t handle) {
+    const SocketHandle client = (SocketHandle)handle;
+
+    // A slow or silent client must not hold the exporter for long
+#ifdef _WIN32
+    DWORD timeoutMs = 2000;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeoutMs, sizeof(timeoutMs));
+#else
+    timeval timeout = { 2, 0 };
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+
+    std::string request;
+    char buffer[1024];
+    while (request.size() < kMaxRequestBytes && request.find("\r\n\r\n") == std::string::npos) {
+        const int n = (int)recv(client, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        request.append(buffer, (size_t)n);
+    }
+
+    std::string status = "200 OK";
+    std::string body;
+    if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0) {
+        render_(body);
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    std::string response = "HTTP/1.0 " + status + "\r\n"
+                           "Content-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n";
+    sendAll(client, response);
+    sendAll(client, body);
+}
+
+void MetricsExporter::writeFile() {
+    std::string body;
+    render_(body);
+
+    // Write then rename so a reader never sees a half-written file
+    const std::string temporary = config_.metricsFile + ".tmp";
+    {
+        std::ofstream file(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file) {
+            LOG_ERROR << "❌ Cannot write metrics file " << temporary;
+            return;
+        }
+        file << body;
+    }
+#ifdef _WIN32
+    std::remove(config_.metricsFile.c_str()); // rename does not replace on Windows
+#endif
+    if (std::rename(temporary.c_str(), config_.metricsFile.c_str()) != 0)
+        LOG_ERROR << "❌ Cannot replace metrics file " << config_.metricsFile;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "ServerConfig.h"
+
+/**
+ * @class MetricsExporter
+ * @brief نشر المقاييس بصيغة Prometheus عبر HTTP محلي (127.0.0.1) و/أو كتابتها
+ *        في ملف كل فترة زمنية
+ *
+ * خيط واحد يخدم الطلبات واحداً تلو الآخر؛ المقاييس صغيرة والطلبات نادرة.
+ */
+class MetricsExporter {
+public:
+    typedef std::function<void(std::string&)> Renderer;
+
+private:
+    const ServerConfig& config_;
+    Renderer render_;              ///< يكتب كل المقاييس في النص
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+
+public:
+    /**
+     * @param render دالة تكتب المقاييس (تُستدعى من خيط المُصدِّر)
+     */
+    MetricsExporter(const ServerConfig& config, Renderer render);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /**
+     * @brief تشغيل الخيط إذا كان المنفذ أو الملف محدداً في الإعدادات
+     * @return false إذا تعذر فتح منفذ HTTP
+     */
+    bool start();
+
+    void stop();
+
+private:
+    void run(intptr_t listenSocket);
+    void serveClient(intptr_t clientSocket);
+    void writeFile();
+};
@@ -0,0 +1,73 @@
+// OutputBackend.cpp
+#include "OutputBackend.h"
+#include "Logger.h"
+#include "RasterFileBackend.h"
+#include "RasterStreamBackend.h"
+#ifdef _WIN32
+#include "GdiOutputBackend.h"
+#endif
+
+// -----------------------------
+// Default document: one printPage() call per page
+// -----------------------------
+namespace {
+
+class PageByPageDocument : public OutputDocument {
+private:
+    OutputBackend& backend_;
+
+public:
+    explicit PageByPageDocument(OutputBackend& backend) : backend_(backend) {}
+
+    bool printPage(const PageRaster& page, const PageInfo& info) override {
+        return backend_.printPage(page, info);
+    }
+    bool finish() override { return true; }
+};
+
+} // namespace
+
+std::unique_ptr<OutputDocument> OutputBackend::openDocument(const PageInfo& info) {
+    (void)info;
+    return std::unique_ptr<OutputDocument>(new PageByPageDocument(*this));
+}
+
+// -----------------------------
+// Null sink
+// -----------------------------
+bool NullOutputBackend::printPage(const PageRaster& page, const PageInfo& info) {
+    (void)info;
+    return page.data != nullptr && page.width > 0 && page.height > 0;
+}
+
+// -----------------------------
+// Factory
+// -----------------------------
+std::unique_ptr<OutputBackend> createOutputBackend(const ServerConfig& config, ThreadPool* pool) {
+    std::unique_ptr<OutputBackend> backend;
+
+    if (config.outputBackend == "null") {
+        backend.reset(new NullOutputBackend());
+    } else if (config.outputBackend == "file") {
+        backend.reset(new RasterFileBackend(config.spoolDirectory, config.rasterFileFormat));
+    } else if (config.outputBackend == "stream") {
+        RasterStreamBackend::Format format;
+        if (parseStreamFormat(config.streamFormat, format))
+            backend.reset(new RasterStreamBackend(format, config.spoolDirectory, config.streamDevice,
+                                                  config.streamTimeoutSec, pool));
+        else
+            LOG_ERROR << "❌ Unknown stream format: " << config.streamFormat;
+    } else if (config.outputBackend == "gdi") {
+#ifdef _WIN32
+        backend.reset(new GdiOutputBackend());
+#else
+        LOG_ERROR << "❌ The GDI printer backend is only available on Windows";
+#endif
+    } else {
+        LOG_ERROR << "❌ Unknown output backend: " << config.outputBackend;
+    }
+
+    if (backend)
+        LOG_INFO << "🖨 Output backend: " << backend->name();
+    return backend;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/ofstd/oftypes.h>
+
+#include "ServerConfig.h"
+
+class ThreadPool;
+
+/**
+ * @struct PageRaster
+ * @brief صفحة جاهزة للطباعة: 8bit رمادي أو 24bit ملون مع طول السطر
+ */
+struct PageRaster {
+    const Uint8* data = nullptr; ///< بداية أول سطر
+    unsigned long width = 0;     ///< العرض بالبكسل
+    unsigned long height = 0;    ///< الارتفاع بالبكسل
+    size_t stride = 0;           ///< عدد البايتات بين بداية سطر والذي يليه
+    int bitsPerPixel = 8;        ///< 8 = رمادي، 24 = ملون
+    bool bgr = false;            ///< ترتيب القنوات للصور الملونة: B G R بدلاً من R G B
+
+    size_t rowBytes() const { return (size_t)width * (bitsPerPixel / 8); }
+};
+
+/**
+ * @struct RasterLayout
+ * @brief الشكل الذي يفضله المخرج للصفحة، حتى يكتب العرض فيه مباشرة دون نسخ إضافية
+ */
+struct RasterLayout {
+    size_t rowAlignment = 1; ///< محاذاة طول السطر بالبايت (4 لـ DIB)
+    bool bgr = false;        ///< ترتيب القنوات المطلوب للصور الملونة
+};
+
+/**
+ * @struct PageInfo
+ * @brief معلومات تعريفية عن الصفحة (للتسمية والتوجيه)
+ */
+struct PageInfo {
+    std::string printerName; ///< الطابعة المستهدفة (فارغ = الافتراضية)
+    unsigned long jobId = 0; ///< رقم مهمة الطباعة
+    unsigned pageNumber = 1; ///< رقم الصفحة داخل المهمة
+    unsigned dpi = 0;        ///< دقة الصفحة المركبة (0 = غير معروفة)
+};
+
+/**
+ * @class OutputDocument
+ * @brief مستند واحد في المخرج يضم كل صفحات المهمة ونسخها (مهمة طباعة واحدة في الطابعة)
+ *
+ * يُستخدم من خيط واحد. الهدم دون finish() يلغي المستند.
+ */
+class OutputDocument {
+public:
+    virtual ~OutputDocument() = default;
+
+    /**
+     * @brief إضافة صفحة إلى المستند
+     * @return false عند الفشل (يبقى على المستدعي عدم إكمال المستند)
+     */
+    virtual bool printPage(const PageRaster& page, const PageInfo& info) = 0;
+
+    /**
+     * @brief إغلاق المستند وإرساله
+     */
+    virtual bool finish() = 0;
+};
+
+/**
+ * @class OutputBackend
+ * @brief واجهة مجردة لإخراج الصفحات (طابعة ويندوز، ملفات، أو لا شيء)
+ *
+ * يجب أن تكون التطبيقات آمنة للاستدعاء من عدة خيوط طباعة في نفس الوقت.
+ */
+class OutputBackend {
+public:
+    virtual ~OutputBackend() = default;
+
+    /**
+     * @brief اسم المخرج (للسجلات)
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief شكل الصفحة المفضل؛ الصفحات بهذا الشكل تُخرج دون نسخ أو تحويل
+     */
+    virtual RasterLayout preferredLayout() const { return RasterLayout(); }
+
+    /**
+     * @brief إخراج صفحة واحدة
+     * @return false عند الفشل
+     */
+    virtual bool printPage(const PageRaster& page, const PageInfo& info) = 0;
+
+    /**
+     * @brief بدء مستند لصفحات مهمة واحدة
+     *
+     * التطبيق الافتراضي يمرر كل صفحة إلى printPage() على حدة. قد يحجز المستند
+     * الجهاز حتى finish()، لذا يُفتح بعد تركيب الصفحة الأولى لا قبله.
+     * @return nullptr إذا تعذر بدء المستند
+     */
+    virtual std::unique_ptr<OutputDocument> openDocument(const PageInfo& info);
+
+    /**
+     * @brief مقاييس المخرج بصيغة Prometheus (لا شيء افتراضياً)
+     */
+    virtual void appendMetrics(std::string& out) { (void)out; }
+};
+
+/**
+ * @class NullOutputBackend
+ * @brief مخرج يتجاهل الصفحات - لقياس سرعة خط المعالجة دون طابعة
+ */
+class NullOutputBackend : public OutputBackend {
+public:
+    const char* name() const override { return "null"; }
+    bool printPage(const PageRaster& page, const PageInfo& info) override;
+};
+
+/**
+ * @brief إنشاء المخرج المحدد في الإعدادات (gdi / file / stream / null)
+ * @param pool خيوط يستخدمها المخرج لترميز الصفحات بالتوازي (اختياري)
+ * @return nullptr إذا كان المخرج غير مدعوم على هذا النظام
+ */
+std::unique_ptr<OutputBackend> createOutputBackend(const ServerConfig& config, ThreadPool* pool = nullptr);
@@ -0,0 +1,34 @@
+// PageBuffer.cpp
+#include "PageBuffer.h"
+
+PageBuffer::PageBuffer()
+    : width_(0), height_(0), stride_(0), bitsPerPixel_(8), bgr_(false) {
+}
+
+bool PageBuffer::allocate(unsigned long width, unsigned long height, int bitsPerPixel,
+                          const RasterLayout& layout) {
+    const size_t align = layout.rowAlignment ? layout.rowAlignment : 1;
+    const size_t rowBytes = (size_t)width * (bitsPerPixel / 8);
+    const size_t stride = (rowBytes + align - 1) / align * align;
+    const size_t needed = stride * height;
+
+    if (!storage_.allocate(needed)) return false;
+
+    width_ = width;
+    height_ = height;
+    stride_ = stride;
+    bitsPerPixel_ = bitsPerPixel;
+    bgr_ = (bitsPerPixel == 24) && layout.bgr;
+    return true;
+}
+
+PageRaster PageBuffer::raster() const {
+    PageRaster page;
+    page.data = storage_.data();
+    page.width = width_;
+    page.height = height_;
+    page.stride = stride_;
+    page.bitsPerPixel = bitsPerPixel_;
+    page.bgr = bgr_;
+    return page;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+
+#include "BufferPool.h"
+#include "OutputBackend.h"
+
+/**
+ * @class PageBuffer
+ * @brief مخزن صفحة بطول سطر يطابق شكل المخرج، يكتب فيه العرض مباشرة
+ *        ثم يُمرر إلى المخرج دون نسخ. يُعاد استخدام الذاكرة إذا كانت كافية،
+ *        وتأتي من BufferPool وتعود إليه عند الهدم.
+ */
+class PageBuffer {
+private:
+    PooledBytes storage_;              ///< الذاكرة (غير مهيأة عمداً لتجنب التصفير)
+    unsigned long width_;
+    unsigned long height_;
+    size_t stride_;
+    int bitsPerPixel_;
+    bool bgr_;
+
+public:
+    PageBuffer();
+
+    PageBuffer(const PageBuffer&) = delete;
+    PageBuffer& operator=(const PageBuffer&) = delete;
+
+    /**
+     * @brief تجهيز الصفحة بالأبعاد والشكل المطلوب
+     * @param layout شكل المخرج (محاذاة السطر وترتيب القنوات)
+     * @return false عند فشل حجز الذاكرة
+     */
+    bool allocate(unsigned long width, unsigned long height, int bitsPerPixel,
+                  const RasterLayout& layout);
+
+    Uint8* data() { return storage_.data(); }
+    const Uint8* data() const { return storage_.data(); }
+    size_t size() const { return stride_ * height_; }
+    size_t stride() const { return stride_; }
+    size_t rowBytes() const { return (size_t)width_ * (bitsPerPixel_ / 8); }
+    unsigned long width() const { return width_; }
+    unsigned long height() const { return height_; }
+    int bitsPerPixel() const { return bitsPerPixel_; }
+    bool bgr() const { return bgr_; }
+
+    /**
+     * @brief عرض الصفحة كـ PageRaster للمخرج (بدون نسخ)
+     */
+    PageRaster raster() const;
+};
@@ -0,0 +1,217 @@
+// PageCache.cpp
+#include "PageCache.h"
+#include "Sha256.h"
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcpixel.h>
+#include <dcmtk/dcmdata/dcpixseq.h>
+#include <dcmtk/dcmdata/dcpxitem.h>
+#include <dcmtk/dcmdata/dcsequen.h>
+
+namespace {
+
+// Length-prefixed fields, so "AB","C" and "A","BC" never produce the same key
+class KeyWriter {
+private:
+    std::string& out_;
+
+public:
+    explicit KeyWriter(std::string& out) : out_(out) {}
+
+    void number(uint64_t value) { out_.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+    void bytes(const void* data, size_t length) {
+        number(length);
+        out_.append(static_cast<const char*>(data), length);
+    }
+    void string(const std::string& value) { bytes(value.data(), value.size()); }
+};
+
+// Everything outside the pixel bytes that changes how the image is rendered
+const DcmTagKey kRenderTags[] = {
+    DCM_Rows, DCM_Columns, DCM_SamplesPerPixel, DCM_PhotometricInterpretation, DCM_PlanarConfiguration,
+    DCM_BitsAllocated, DCM_BitsStored, DCM_HighBit, DCM_PixelRepresentation, DCM_NumberOfFrames,
+    DCM_RescaleSlope, DCM_RescaleIntercept, DCM_RescaleType, DCM_WindowCenter, DCM_WindowWidth,
+    DCM_VOILUTFunction,
+};
+
+// LUTs sent as tables; their items are written out element by element
+const DcmTagKey kRenderSequences[] = {
+    DCM_ModalityLUTSequence, DCM_VOILUTSequence, DCM_PresentationLUTSequence,
+};
+
+void writeItem(DcmItem& item, KeyWriter& key) {
+    key.number(item.card());
+    for (unsigned long i = 0; i < item.card(); ++i) {
+        DcmElement* element = item.getElement(i);
+        const DcmTag& tag = element->getTag();
+        key.number((uint64_t)tag.getGroup() << 16 | tag.getElement());
+        if (element->ident() == EVR_SQ) {
+            DcmSequenceOfItems* sequence = static_cast<DcmSequenceOfItems*>(element);
+            key.number(sequence->card());
+            for (unsigned long j = 0; j < sequence->card(); ++j) writeItem(*sequence->getItem(j), key);
+        } else {
+            OFString value;
+            element->getOFStringArray(value);
+            key.string(value.c_str());
+        }
+    }
+}
+
+// SHA-256 of the pixel data as received: compressed fragments or the native array
+bool pixelDigest(DcmDataset& dataset, Uint8 digest[Sha256::kDigestBytes]) {
+    DcmElement* element = nullptr;
+    if (dataset.findAndGetElement(DCM_PixelData, element).bad() || !element) return false;
+    DcmPixelData* pixelData = static_cast<DcmPixelData*>(element);
+
+    Sha256 sha;
+    DcmPixelSequence* sequence = nullptr;
+    if (pixelData->getEncapsulatedRepresentation(dataset.getOriginalXfer(), nullptr, sequence).good() &&
+        sequence) {
+        for (unsigned long i = 0; i < sequence->card(); ++i) {
+            DcmPixelItem* item = nullptr;
+            Uint8* fragment = nullptr;
+            if (sequence->getItem(item, i).bad() || !item) return false;
+            if (item->getLength() && item->getUint8Array(fragment).bad()) return false;
+            const uint64_t length = item->getLength();
+            sha.update(&length, sizeof(length));
+            sha.update(fragment, (size_t)length);
+        }
+    } else {
+        Uint8* pixels = nullptr;
+        if (pixelData->getUint8Array(pixels).bad() || !pixels) return false;
+        const uint64_t length = pixelData->getLength();
+        sha.update(&length, sizeof(length));
+        sha.update(pixels, (size_t)length);
+    }
+    sha.finish(digest);
+    return true;
+}
+
+} // namespace
+
+bool imageCacheKey(DcmDataset& dataset, std::string& key) {
+    key.clear();
+    KeyWriter writer(key);
+    for (const DcmTagKey& tag : kRenderTags) {
+        OFString value;
+        if (dataset.findAndGetOFStringArray(tag, value).good()) {
+            writer.number(1);
+            writer.string(value.c_str());
+        } else {
+            writer.number(0);
+        }
+    }
+    for (const DcmTagKey& tag : kRenderSequences) {
+        DcmSequenceOfItems* sequence = nullptr;
+        if (dataset.findAndGetSequence(tag, sequence).good() && sequence) {
+            writer.number(sequence->card());
+            for (unsigned long i = 0; i < sequence->card(); ++i) writeItem(*sequence->getItem(i), writer);
+        } else {
+            writer.number(0);
+        }
+    }
+    writer.number((uint64_t)dataset.getOriginalXfer());
+
+    Uint8 digest[Sha256::kDigestBytes];
+    if (!pixelDigest(dataset, digest)) {
+        key.clear();
+        return false;
+    }
+    writer.bytes(digest, sizeof(digest));
+    return true;
+}
+
+PageRaster CachedPage::raster() const {
+    PageRaster page;
+    page.data = pixels.data();
+    page.width = width;
+    page.height = height;
+    page.stride = stride;
+    page.bitsPerPixel = bitsPerPixel;
+    page.bgr = bgr;
+    return page;
+}
+
+bool pageCacheKey(const FilmBoxSpec& film, const std::vector<PageImage>& images,
+                  unsigned dpi, const RasterLayout& layout, std::string& key) {
+    key.clear();
+    KeyWriter writer(key);
+    writer.string(film.imageDisplayFormat);
+    writer.string(film.filmOrientation);
+    writer.string(film.filmSizeID);
+    writer.string(film.magnificationType);
+    writer.string(film.borderDensity);
+    writer.string(film.emptyImageDensity);
+    writer.number(film.minDensity);
+    writer.number(film.maxDensity);
+    writer.number(dpi);
+    writer.number(layout.rowAlignment);
+    writer.number(layout.bgr);
+
+    writer.number(images.size());
+    std::string imageKey;
+    for (const PageImage& image : images) {
+        writer.string(image.polarity);
+        writer.string(image.magnificationType);
+        writer.string(image.presentationLutShape);
+        if (!image.dataset) {
+            writer.number(0); // empty image box
+            continue;
+        }
+        writer.number(1);
+        // Taken by decode-ahead when possible, before it rewrote the dataset
+        if (image.cacheKey.empty() && !imageCacheKey(*image.dataset, imageKey)) return false;
+        writer.string(image.cacheKey.empty() ? imageKey : image.cacheKey);
+    }
+    return true;
+}
+
+// -----------------------------
+// PageCache Implementation
+// -----------------------------
+PageCache::PageCache(size_t capacityBytes)
+    : capacityBytes_(capacityBytes), usedBytes_(0), hits_(0), misses_(0), evictions_(0) {
+}
+
+PageCache::PagePtr PageCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++misses_;
+        return PagePtr();
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    ++hits_;
+    return it->second->second;
+}
+
+void PageCache::insert(const std::string& key, const PageBuffer& page) {
+    const size_t bytes = page.size();
+    if (!enabled() || bytes == 0 || bytes > capacityBytes_) return;
+
+    // Copy outside the lock; pages are tens of MB
+    std::shared_ptr<CachedPage> copy = std::make_shared<CachedPage>();
+    copy->pixels.assign(page.data(), page.data() + bytes);
+    copy->width = page.width();
+    copy->height = page.height();
+    copy->stride = page.stride();
+    copy->bitsPerPixel = page.bitsPerPixel();
+    copy->bgr = page.bgr();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.find(key) != index_.end()) return; // another worker rendered it first
+    entries_.emplace_front(key, copy);
+    index_[key] = entries_.begin();
+    usedBytes_ += bytes;
+    while (usedBytes_ > capacityBytes_ && entries_.size() > 1) {
+        usedBytes_ -= entries_.back().second->pixels.size();
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+        ++evictions_;
+    }
+}
+
+size_t PageCache::usedBytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return usedBytes_;
+}
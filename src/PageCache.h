@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "FilmCompositor.h"
+#include "OutputBackend.h"
+#include "PageBuffer.h"
+
+/**
+ * @struct CachedPage
+ * @brief نسخة ثابتة من صفحة مركبة، تُرسل إلى المخرج مباشرة عند التطابق
+ */
+struct CachedPage {
+    std::vector<Uint8> pixels;
+    unsigned long width = 0;
+    unsigned long height = 0;
+    size_t stride = 0;
+    int bitsPerPixel = 8;
+    bool bgr = false;
+
+    PageRaster raster() const;
+};
+
+/**
+ * @brief مفتاح صورة واحدة: خصائص العرض كما هي (النافذة، Rescale، جداول Modality /
+ *        VOI / Presentation LUT...) و SHA-256 لبيانات البكسل كما استُلمت
+ *
+ * يجب أن يُحسب قبل أي فك ترميز للـ Dataset، لأن فك الترميز يغير Transfer Syntax
+ * و Photometric Interpretation فيختلف المفتاح لنفس الصورة.
+ * @return false إذا تعذر قراءة بيانات البكسل
+ */
+bool imageCacheKey(DcmDataset& dataset, std::string& key);
+
+/**
+ * @brief مفتاح المحتوى للصفحة: مفاتيح كل الصور (PageImage::cacheKey أو تُحسب الآن)
+ *        وكل ما يؤثر على العرض (Polarity، Magnification، Presentation LUT، خصائص
+ *        Film Box، الدقة وشكل المخرج). المفتاح كاملاً يُقارن عند البحث وليس بصمته فقط.
+ * @param key الناتج
+ * @return false إذا تعذر قراءة بيانات بكسل أي صورة (لا تُخزن الصفحة)
+ */
+bool pageCacheKey(const FilmBoxSpec& film, const std::vector<PageImage>& images,
+                  unsigned dpi, const RasterLayout& layout, std::string& key);
+
+/**
+ * @class PageCache
+ * @brief ذاكرة مؤقتة (LRU) للصفحات المركبة محدودة بالحجم، آمنة لعدة خيوط
+ *
+ * إعادة طباعة نفس الفيلم (فقدان نسخة، نسخة للطبيب المحيل، أو عدة نسخ كجلسات
+ * منفصلة) تتجاوز فك الضغط والتحويل والتحجيم والتركيب بالكامل.
+ */
+class PageCache {
+public:
+    typedef std::shared_ptr<const CachedPage> PagePtr;
+
+private:
+    typedef std::list<std::pair<std::string, PagePtr>> EntryList;
+
+    std::mutex mutex_;
+    EntryList entries_; ///< الأحدث استخداماً في المقدمة
+    std::unordered_map<std::string, EntryList::iterator> index_; ///< المفتاح كاملاً، فالتطابق لا يكون بالصدفة
+    size_t capacityBytes_;
+    size_t usedBytes_;
+    std::atomic<unsigned long> hits_;
+    std::atomic<unsigned long> misses_;
+    std::atomic<unsigned long> evictions_;
+
+public:
+    /**
+     * @param capacityBytes الحد الأقصى للحجم (0 = معطلة)
+     */
+    explicit PageCache(size_t capacityBytes);
+
+    PageCache(const PageCache&) = delete;
+    PageCache& operator=(const PageCache&) = delete;
+
+    bool enabled() const { return capacityBytes_ > 0; }
+
+    /**
+     * @brief البحث عن صفحة (nullptr إذا لم توجد)
+     */
+    PagePtr find(const std::string& key);
+
+    /**
+     * @brief نسخ صفحة مركبة إلى الذاكرة المؤقتة مع إخراج الأقدم عند تجاوز الحد
+     *        الصفحات الأكبر من الحد كله لا تُخزن
+     */
+    void insert(const std::string& key, const PageBuffer& page);
+
+    unsigned long hits() const { return hits_.load(); }
+    unsigned long misses() const { return misses_.load(); }
+    unsigned long evictions() const { return evictions_.load(); }
+    size_t usedBytes();
+    size_t capacityBytes() const { return capacityBytes_; }
+};
@@ -0,0 +1,173 @@
+// PixelDecoder.cpp
+#include "PixelDecoder.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include <atomic>
+#include <string>
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcpixel.h>
+#include <dcmtk/dcmdata/dcxfer.h>
+
+namespace {
+
+// Pixel data element and the size of one uncompressed frame, if the dataset
+// is encapsulated or holds more than one frame; nullptr when nothing to do.
+DcmPixelData* framePixelData(DcmDataset& dataset, Uint32& frameSize) {
+    DcmElement* element = nullptr;
+    if (dataset.findAndGetElement(DCM_PixelData, element).bad() || !element) return nullptr;
+
+    Sint32 frames = 1;
+    dataset.findAndGetSint32(DCM_NumberOfFrames, frames);
+    if (!DcmXfer(dataset.getOriginalXfer()).isEncapsulated() && frames <= 1) return nullptr;
+
+    DcmPixelData* pixelData = static_cast<DcmPixelData*>(element);
+    if (pixelData->getUncompressedFrameSize(&dataset, frameSize).bad() || frameSize == 0)
+        return nullptr;
+    return pixelData;
+}
+
+bool reserve(std::atomic<size_t>& used, size_t budget, size_t bytes) {
+    size_t current = used.load();
+    do {
+        if (current + bytes > budget) return false;
+    } while (!used.compare_exchange_weak(current, current + bytes));
+    return true;
+}
+
+} // namespace
+
+bool needsDecode(DcmDataset& dataset) {
+    Uint32 frameSize = 0;
+    return framePixelData(dataset, frameSize) != nullptr;
+}
+
+bool decodeFirstFrame(DcmDataset& dataset, size_t maxBytes, size_t& decodedBytes) {
+    decodedBytes = 0;
+    Uint32 frameSize = 0;
+    DcmPixelData* pixelData = framePixelData(dataset, frameSize);
+    if (!pixelData) return true; // already a single native frame
+    if (frameSize > maxBytes) return false;
+
+    Uint16 bitsAllocated = 8;
+    dataset.findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+    Uint16 samplesPerPixel = 1;
+    dataset.findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel);
+
+    // Codecs write colour either in the layout PlanarConfiguration asks for or always
+    // by pixel; asking for colour-by-pixel up front gives the same layout from both
+    const bool encapsulated = DcmXfer(dataset.getOriginalXfer()).isEncapsulated();
+    Uint16 planarConfiguration = 0;
+    dataset.findAndGetUint16(DCM_PlanarConfiguration, planarConfiguration);
+    const bool byPlane = encapsulated && samplesPerPixel > 1 && planarConfiguration != 0;
+    if (byPlane) dataset.putAndInsertUint16(DCM_PlanarConfiguration, 0);
+
+    // Only frame 0 is ever printed, so the other frames of a cine are never decoded
+    std::vector<Uint16> frame((frameSize + 1) / 2);
+    Uint32 startFragment = 0;
+    OFString colorModel;
+    OFCondition cond = pixelData->getUncompressedFrame(&dataset, 0, startFragment, frame.data(),
+                                                       frameSize, colorModel);
+    if (cond.bad()) {
+        if (byPlane) dataset.putAndInsertUint16(DCM_PlanarConfiguration, planarConfiguration);
+        LOG_ERROR << "❌ Frame decode failed: " << cond.text();
+        return false;
+    }
+
+    // Replace the encapsulated/multi-frame pixel data with the single native frame
+    if (bitsAllocated > 8)
+        cond = dataset.putAndInsertUint16Array(DCM_PixelData, frame.data(), frameSize / 2);
+    else
+        cond = dataset.putAndInsertUint8Array(DCM_PixelData, reinterpret_cast<const Uint8*>(frame.data()),
+                                              frameSize);
+    if (cond.bad()) {
+        LOG_ERROR << "❌ Cannot store decoded frame: " << cond.text();
+        return false;
+    }
+    if (!colorModel.empty()) dataset.putAndInsertString(DCM_PhotometricInterpretation, colorModel.c_str());
+    dataset.putAndInsertString(DCM_NumberOfFrames, "1");
+    // Native frames keep the layout they were stored in; monochrome has no planes
+    if (samplesPerPixel > 1 && encapsulated)
+        dataset.putAndInsertUint16(DCM_PlanarConfiguration, 0);
+    else if (samplesPerPixel == 1)
+        dataset.findAndDeleteElement(DCM_PlanarConfiguration);
+    dataset.updateOriginalXfer();
+
+    decodedBytes = frameSize;
+    return true;
+}
+
+// -----------------------------
+// DecodeAhead Implementation
+// -----------------------------
+DecodeAhead::DecodeAhead(std::shared_future<std::string> done, std::shared_ptr<std::atomic<size_t>> used,
+                         size_t bytes)
+    : done_(std::move(done)), used_(std::move(used)), bytes_(bytes) {
+}
+
+DecodeAhead::~DecodeAhead() {
+    *used_ -= bytes_;
+}
+
+// -----------------------------
+// PixelDecoder Implementation
+// -----------------------------
+PixelDecoder::PixelDecoder(ThreadPool& pool, size_t jobBudgetBytes, size_t aheadBudgetBytes)
+    : pool_(pool), jobBudget_(jobBudgetBytes), aheadBudget_(aheadBudgetBytes),
+      aheadUsed_(std::make_shared<std::atomic<size_t>>(0)) {
+}
+
+std::shared_ptr<DecodeAhead> PixelDecoder::decodeAhead(const std::shared_ptr<DcmDataset>& dataset,
+                                                      const KeyFunction& key) {
+    Uint32 frameSize = 0;
+    if (!aheadBudget_ || !dataset || !framePixelData(*dataset, frameSize)) return nullptr;
+    if (!reserve(*aheadUsed_, aheadBudget_, frameSize)) {
+        LOG_DEBUG << "🗜 Decode-ahead budget full, image left for print time";
+        return nullptr;
+    }
+
+    // The task holds the dataset, so replacing or deleting the image box meanwhile is safe
+    std::shared_ptr<std::promise<std::string>> done = std::make_shared<std::promise<std::string>>();
+    std::shared_ptr<DecodeAhead> ahead =
+        std::make_shared<DecodeAhead>(done->get_future().share(), aheadUsed_, frameSize);
+    pool_.post([dataset, done, frameSize, key] {
+        // The key describes the image as received, so it is taken before decoding
+        std::string imageKey;
+        if (key && !key(*dataset, imageKey)) imageKey.clear();
+        size_t bytes = 0;
+        {
+            StageTimer timer(Stage::Decode);
+            decodeFirstFrame(*dataset, frameSize, bytes);
+        }
+        done->set_value(imageKey);
+    });
+    return ahead;
+}
+
+size_t PixelDecoder::decodeAll(const std::vector<DcmDataset*>& datasets) {
+    std::atomic<size_t> used(0);
+    std::atomic<size_t> decoded(0);
+    std::atomic<size_t> deferred(0);
+
+    pool_.parallelFor(datasets.size(), [&](size_t index) {
+        DcmDataset* dataset = datasets[index];
+        Uint32 frameSize = 0;
+        if (!dataset || !framePixelData(*dataset, frameSize)) return;
+
+        // Over budget: leave it compressed, the renderer decodes one frame on demand
+        if (!reserve(used, jobBudget_, frameSize)) {
+            ++deferred;
+            return;
+        }
+        size_t bytes = 0;
+        StageTimer timer(Stage::Decode);
+        if (decodeFirstFrame(*dataset, frameSize, bytes)) ++decoded;
+        used -= frameSize - bytes;
+    });
+
+    if (decoded || deferred)
+        LOG_DEBUG << "🗜 Decoded " << decoded << "/" << datasets.size() << " images ("
+                  << used.load() / 1024 << " KB)"
+                  << (deferred ? ", " + std::to_string(deferred.load()) + " deferred over budget" : "");
+    return decoded;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcdatset.h>
+
+#include "ThreadPool.h"
+
+/**
+ * @brief فك ضغط الإطار الأول فقط واستبدال بيانات البكسل به (Little Endian Explicit)
+ *
+ * الصور المضغوطة (JPEG / JPEG-LS / RLE) أو متعددة الإطارات تصبح إطاراً واحداً
+ * غير مضغوط، فلا يحتاج العرض لاحقاً إلى فك أي شيء. الصور العادية ذات الإطار
+ * الواحد لا تتغير.
+ *
+ * @param dataset الصورة (تُعدل في مكانها)
+ * @param maxBytes أقصى حجم مسموح للإطار الناتج
+ * @param decodedBytes حجم الإطار الناتج (0 إذا لم يكن هناك ما يُفك)
+ * @return false إذا فشل الفك أو تجاوز الإطار maxBytes (تبقى الصورة كما هي)
+ */
+bool decodeFirstFrame(DcmDataset& dataset, size_t maxBytes, size_t& decodedBytes);
+
+/**
+ * @brief هل ستعدل decodeFirstFrame هذه الصورة (مضغوطة أو متعددة الإطارات)
+ */
+bool needsDecode(DcmDataset& dataset);
+
+/**
+ * @class DecodeAhead
+ * @brief فك ضغط صورة Image Box في الخلفية بمجرد استلامها، بينما يستلم الاتصال
+ *        المربع التالي
+ *
+ * يحجز حجم الإطار من حد الفك المسبق المشترك ويحرره عند حذفه (مع Image Box
+ * أو عند استبدال صورته).
+ */
+class DecodeAhead {
+private:
+    std::shared_future<std::string> done_; ///< القيمة: مفتاح الصورة قبل الفك
+
+    std::shared_ptr<std::atomic<size_t>> used_; ///< عداد الحد المشترك
+    size_t bytes_;
+
+public:
+    DecodeAhead(std::shared_future<std::string> done, std::shared_ptr<std::atomic<size_t>> used, size_t bytes);
+    ~DecodeAhead();
+
+    DecodeAhead(const DecodeAhead&) = delete;
+    DecodeAhead& operator=(const DecodeAhead&) = delete;
+
+    /**
+     * @brief انتظار انتهاء الفك قبل قراءة الصورة أو نسخها
+     */
+    void wait() const { done_.wait(); }
+
+    /**
+     * @brief مفتاح الصورة كما استُلمت، مأخوذ في نفس المهمة قبل الفك (ينتظر انتهاءها)
+     * @return فارغ إذا لم يُطلب مفتاح أو تعذر حسابه
+     */
+    const std::string& cacheKey() const { return done_.get(); }
+};
+
+/**
+ * @class PixelDecoder
+ * @brief مرحلة فك الضغط: كل صور المهمة (كل المربعات في كل الصفحات) تُفك
+ *        بالتوازي في مجموعة خيوط العرض قبل تركيب الصفحة الأولى
+ *
+ * الذاكرة الناتجة محدودة لكل مهمة؛ الصور التي لا يتسع لها الحد تبقى مضغوطة
+ * ويُفك إطارها الأول فقط عند عرض المربع.
+ */
+class PixelDecoder {
+public:
+    /// يحسب مفتاح الصورة قبل أن يعدلها الفك (مثل imageCacheKey)
+    typedef std::function<bool(DcmDataset&, std::string&)> KeyFunction;
+
+private:
+    ThreadPool& pool_;
+    size_t jobBudget_; ///< أقصى حجم للإطارات المفكوكة لكل مهمة (بايت)
+    size_t aheadBudget_; ///< أقصى حجم للإطارات المفكوكة مسبقاً في كل الاتصالات (بايت)
+    std::shared_ptr<std::atomic<size_t>> aheadUsed_;
+
+public:
+    /**
+     * @param pool مجموعة الخيوط المشتركة
+     * @param jobBudgetBytes حد الذاكرة لكل مهمة
+     * @param aheadBudgetBytes حد ذاكرة الفك المسبق عند الاستلام (0 = معطل)
+     */
+    PixelDecoder(ThreadPool& pool, size_t jobBudgetBytes, size_t aheadBudgetBytes = 0);
+
+    /**
+     * @brief فك ضغط مجموعة صور بالتوازي
+     * @param datasets صور المهمة بترتيب الطباعة (الأولى تأخذ الأولوية في الذاكرة)
+     * @return عدد الصور التي فُكت مسبقاً
+     */
+    size_t decodeAll(const std::vector<DcmDataset*>& datasets);
+
+    /**
+     * @brief بدء فك ضغط صورة في مجموعة الخيوط دون انتظار
+     *
+     * لا يجوز الوصول إلى dataset قبل wait(). الصور غير المضغوطة ذات الإطار
+     * الواحد أو التي لا يتسع لها الحد تُترك كما هي لتُفك عند الطباعة.
+     *
+     * @param key إن وُجد يُحسب في نفس المهمة قبل الفك، فلا يكلف خيط الاتصال شيئاً
+     * @return nullptr إذا لم يبدأ فك
+     */
+    std::shared_ptr<DecodeAhead> decodeAhead(const std::shared_ptr<DcmDataset>& dataset,
+                                             const KeyFunction& key = KeyFunction());
+};
@@ -0,0 +1,227 @@
+// PixelKernels.cpp
+#include "PixelKernels.h"
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PK_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang need the target attribute to emit AVX2/SSSE3 code in a file
+// compiled for the baseline ISA; MSVC accepts the intrinsics directly.
+#if defined(PK_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PK_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PK_TARGET(isa)
+#endif
+
+namespace PixelKernels {
+
+// -----------------------------
+// Scalar reference versions
+// -----------------------------
+namespace scalar {
+
+void invert8(const uint8_t* src, uint8_t* dst, size_t count) {
+    for (size_t i = 0; i < count; ++i) dst[i] = (uint8_t)(255 - src[i]);
+}
+
+static inline void swizzleRow(const uint8_t* src, uint8_t* dst, size_t width) {
+    for (size_t x = 0; x < width; ++x) {
+        // src: R G B  -> dst: B G R
+        const uint8_t r = src[x * 3 + 0];
+        const uint8_t g = src[x * 3 + 1];
+        const uint8_t b = src[x * 3 + 2];
+        dst[x * 3 + 0] = b;
+        dst[x * 3 + 1] = g;
+        dst[x * 3 + 2] = r;
+    }
+}
+
+void swizzleRGBtoBGR(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                     size_t width, size_t height) {
+    const size_t rowBytes = width * 3;
+    for (size_t y = 0; y < height; ++y) {
+        uint8_t* dstRow = dst + y * dstStride;
+        swizzleRow(src + y * srcStride, dstRow, width);
+        if (dstStride > rowBytes) memset(dstRow + rowBytes, 0, dstStride - rowBytes);
+    }
+}
+
+} // namespace scalar
+
+#ifdef PK_X86
+// -----------------------------
+// SSE2 / SSSE3
+// -----------------------------
+namespace sse {
+
+PK_TARGET("sse2")
+void invert8(const uint8_t* src, uint8_t* dst, size_t count) {
+    const __m128i ones = _mm_set1_epi8((char)0xFF);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(v, ones)); // 255 - v == v ^ 0xFF
+    }
+    scalar::invert8(src + i, dst + i, count - i);
+}
+
+// Swap R/B of 4 pixels (12 bytes); bytes 12..15 pass through unchanged so the
+// overlapping 16-byte store of the next step is harmless (also in place).
+PK_TARGET("ssse3")
+static void swizzleRow(const uint8_t* src, uint8_t* dst, size_t width) {
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12, 13, 14, 15);
+    const size_t rowBytes = width * 3;
+    size_t x = 0;
+    for (; x * 3 + 16 <= rowBytes; x += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + x * 3));
+        _mm_storeu_si128((__m128i*)(dst + x * 3), _mm_shuffle_epi8(v, mask));
+    }
+    scalar::swizzleRGBtoBGR(src + x * 3, 0, dst + x * 3, 0, width - x, 1);
+}
+
+} // namespace sse
+
+// -----------------------------
+// AVX2
+// -----------------------------
+namespace avx2 {
+
+PK_TARGET("avx2")
+void invert8(const uint8_t* src, uint8_t* dst, size_t count) {
+    const __m256i ones = _mm256_set1_epi8((char)0xFF);
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(v, ones));
+    }
+    sse::invert8(src + i, dst + i, count - i);
+}
+
+// 8 pixels per step: each 128-bit lane holds 4 pixels (pshufb is per lane)
+PK_TARGET("avx2")
+static void swizzleRow(const uint8_t* src, uint8_t* dst, size_t width) {
+    const __m256i mask = _mm256_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12, 13, 14, 15,
+                                          2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12, 13, 14, 15);
+    const size_t rowBytes = width * 3;
+    size_t x = 0;
+    for (; x * 3 + 28 <= rowBytes; x += 8) {
+        const uint8_t* s = src + x * 3;
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)s)),
+            _mm_loadu_si128((const __m128i*)(s + 12)), 1);
+        v = _mm256_shuffle_epi8(v, mask);
+        // Low lane first: the high lane store overwrites its 4 pass-through bytes
+        _mm_storeu_si128((__m128i*)(dst + x * 3), _mm256_castsi256_si128(v));
+        _mm_storeu_si128((__m128i*)(dst + x * 3 + 12), _mm256_extracti128_si256(v, 1));
+    }
+    sse::swizzleRow(src + x * 3, dst + x * 3, width - x);
+}
+
+} // namespace avx2
+
+// -----------------------------
+// CPU detection
+// -----------------------------
+static IsaLevel detectIsa() {
+#ifdef _MSC_VER
+    int info[4] = {0, 0, 0, 0};
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool ssse3 = (info[2] & (1 << 9)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx) {
+        // The OS must save the YMM state, otherwise AVX2 code faults
+        const bool ymmEnabled = (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        avx2 = ymmEnabled && (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    const bool sse2 = __builtin_cpu_supports("sse2");
+    const bool ssse3 = __builtin_cpu_supports("ssse3");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2 && ssse3) return IsaLevel::AVX2;
+    if (ssse3) return IsaLevel::SSSE3;
+    if (sse2) return IsaLevel::SSE2;
+    return IsaLevel::Scalar;
+}
+#else
+static IsaLevel detectIsa() { return IsaLevel::Scalar; }
+#endif // PK_X86
+
+// -----------------------------
+// Dispatch
+// -----------------------------
+static const IsaLevel g_supportedIsa = detectIsa();
+static std::atomic<IsaLevel> g_activeIsa(g_supportedIsa);
+
+IsaLevel activeIsa() {
+    return g_activeIsa.load(std::memory_order_relaxed);
+}
+
+const char* activeIsaName() {
+    switch (activeIsa()) {
+        case IsaLevel::AVX2:  return "AVX2";
+        case IsaLevel::SSSE3: return "SSSE3";
+        case IsaLevel::SSE2:  return "SSE2";
+        default:              return "scalar";
+    }
+}
+
+void setMaxIsa(IsaLevel level) {
+    g_activeIsa = (level < g_supportedIsa) ? level : g_supportedIsa;
+}
+
+void invert8(const uint8_t* src, uint8_t* dst, size_t count) {
+#ifdef PK_X86
+    const IsaLevel isa = activeIsa();
+    if (isa >= IsaLevel::AVX2) return avx2::invert8(src, dst, count);
+    if (isa >= IsaLevel::SSE2) return sse::invert8(src, dst, count);
+#endif
+    scalar::invert8(src, dst, count);
+}
+
+void swizzleRGBtoBGR(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                     size_t width, size_t height) {
+#ifdef PK_X86
+    const IsaLevel isa = activeIsa();
+    if (isa >= IsaLevel::SSSE3) {
+        const size_t rowBytes = width * 3;
+        for (size_t y = 0; y < height; ++y) {
+            uint8_t* dstRow = dst + y * dstStride;
+            if (isa >= IsaLevel::AVX2) avx2::swizzleRow(src + y * srcStride, dstRow, width);
+            else sse::swizzleRow(src + y * srcStride, dstRow, width);
+            if (dstStride > rowBytes) memset(dstRow + rowBytes, 0, dstStride - rowBytes);
+        }
+        return;
+    }
+#endif
+    scalar::swizzleRGBtoBGR(src, srcStride, dst, dstStride, width, height);
+}
+
+void convertStride(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                   size_t rowBytes, size_t height) {
+    // memcpy is already vectorized by the C runtime; one call if rows are dense
+    if (srcStride == rowBytes && dstStride == rowBytes) {
+        memcpy(dst, src, rowBytes * height);
+        return;
+    }
+    for (size_t y = 0; y < height; ++y) {
+        uint8_t* dstRow = dst + y * dstStride;
+        memcpy(dstRow, src + y * srcStride, rowBytes);
+        if (dstStride > rowBytes) memset(dstRow + rowBytes, 0, dstStride - rowBytes);
+    }
+}
+
+} // namespace PixelKernels
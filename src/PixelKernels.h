@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief نوى تحويل البكسلات (عكس الرمادي، تبديل R/B، تحويل طول السطر)
+ *
+ * لكل نواة نسخة عادية (scalar) ونسخ SSE2/SSSE3/AVX2 يتم اختيارها مرة واحدة
+ * عند التشغيل حسب قدرات المعالج. جميع النسخ تعطي نتائج متطابقة بايتاً ببايت.
+ */
+namespace PixelKernels {
+
+/**
+ * @brief مستويات تعليمات المعالج المدعومة
+ */
+enum class IsaLevel {
+    Scalar = 0,
+    SSE2 = 1,  ///< العكس فقط؛ تبديل القنوات يحتاج SSSE3
+    SSSE3 = 2,
+    AVX2 = 3
+};
+
+/**
+ * @brief المستوى المستخدم حالياً (الأعلى المدعوم ما لم يُحدد غير ذلك)
+ */
+IsaLevel activeIsa();
+
+/**
+ * @brief اسم المستوى المستخدم (للسجلات)
+ */
+const char* activeIsaName();
+
+/**
+ * @brief تحديد أقصى مستوى مسموح (لاختبار المقارنة أو تعطيل SIMD)
+ *        لا يمكن تجاوز ما يدعمه المعالج فعلياً
+ */
+void setMaxIsa(IsaLevel level);
+
+/**
+ * @brief عكس قيم 8bit (255 - v)، يسمح بأن يكون src == dst
+ */
+void invert8(const uint8_t* src, uint8_t* dst, size_t count);
+
+/**
+ * @brief تحويل صورة RGB إلى BGR مع تغيير طول السطر (مثل حشو DIB إلى 4 بايت)
+ *        بايتات الحشو في نهاية كل سطر تُملأ بالصفر. يسمح بـ src == dst إذا
+ *        كان srcStride == dstStride.
+ */
+void swizzleRGBtoBGR(const uint8_t* src, size_t srcStride,
+                     uint8_t* dst, size_t dstStride,
+                     size_t width, size_t height);
+
+/**
+ * @brief نسخ أسطر بطول rowBytes من طول سطر إلى آخر مع تصفير الحشو
+ */
+void convertStride(const uint8_t* src, size_t srcStride,
+                   uint8_t* dst, size_t dstStride,
+                   size_t rowBytes, size_t height);
+
+/**
+ * @brief طول سطر DIB لويندوز: مقرّب إلى مضاعفات 4 بايت
+ */
+inline size_t dibStride(size_t rowBytes) { return (rowBytes + 3) & ~size_t(3); }
+
+namespace scalar {
+// النسخ المرجعية المستخدمة للتحقق من تطابق نسخ SIMD
+void invert8(const uint8_t* src, uint8_t* dst, size_t count);
+void swizzleRGBtoBGR(const uint8_t* src, size_t srcStride, uint8_t* dst, size_t dstStride,
+                     size_t width, size_t height);
+} // namespace scalar
+
+} // namespace PixelKernels
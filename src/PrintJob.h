@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "FilmCompositor.h"
+#include "FilmLayout.h"
+
+/**
+ * @brief Print Priority من Film Session (2000,0020)
+ */
+enum class PrintPriority {
+    Low = 0,
+    Med = 1,
+    High = 2
+};
+
+/**
+ * @brief تحويل HIGH / MED / LOW (أي قيمة أخرى = MED)
+ */
+PrintPriority parsePrintPriority(const std::string& value);
+
+/**
+ * @struct FilmPage
+ * @brief صفحة واحدة في المهمة: خصائص Film Box وصور مربعاته
+ */
+struct FilmPage {
+    FilmBoxSpec film;                     ///< خصائص Film Box (التنسيق، الحجم، الكثافات)
+    std::vector<PageImage> images;        ///< الصور بترتيب Image Box Position
+};
+
+/**
+ * @struct PrintJob
+ * @brief مهمة طباعة في الطابور: صفحات Film Box وبيانات التتبع والتوجيه
+ */
+struct PrintJob {
+    unsigned long id = 0;                 ///< رقم المهمة الداخلي
+    std::string jobUID;                   ///< Print Job SOP Instance UID المرسل للعميل
+    std::string callingAE;                ///< عنوان AE للجهاز المرسل
+    std::string printerName;              ///< الطابعة المستهدفة (يحددها PrintScheduler، فارغ = الافتراضية)
+    unsigned copies = 1;                  ///< Number of Copies من Film Session
+    PrintPriority priority = PrintPriority::Med; ///< Print Priority من Film Session
+    std::string mediumType;               ///< Medium Type من Film Session (فارغ = غير محدد)
+    std::vector<FilmPage> pages;          ///< صفحة لكل Film Box
+    std::chrono::steady_clock::time_point enqueuedAt; ///< وقت الإدخال في الطابور
+    size_t printerIndex = 0;              ///< رقم الطابعة داخل PrintScheduler
+
+    /**
+     * @brief عدد الأوراق المطبوعة (الصفحات × النسخ)
+     */
+    unsigned long sheets() const { return (unsigned long)pages.size() * copies; }
+};
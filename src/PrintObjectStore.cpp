@@ -0,0 +1,53 @@
+// PrintObjectStore.cpp
+#include "PrintObjectStore.h"
+#include <functional>
+#include <mutex>
+
+// -----------------------------
+// PrintObjectStore Implementation
+// -----------------------------
+PrintObjectStore::PrintObjectStore() : objectCount_(0), nextAssociationId_(1) {
+}
+
+PrintObjectStore::Shard& PrintObjectStore::shardFor(const std::string& uid) {
+    return shards_[std::hash<std::string>()(uid) % SHARD_COUNT];
+}
+
+const PrintObjectStore::Shard& PrintObjectStore::shardFor(const std::string& uid) const {
+    return shards_[std::hash<std::string>()(uid) % SHARD_COUNT];
+}
+
+bool PrintObjectStore::insert(const std::shared_ptr<PrintObject>& object) {
+    Shard& shard = shardFor(object->sopInstanceUID);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (!shard.objects.emplace(object->sopInstanceUID, object).second) return false;
+    ++objectCount_;
+    return true;
+}
+
+std::shared_ptr<PrintObject> PrintObjectStore::findAny(const std::string& uid) const {
+    const Shard& shard = shardFor(uid);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.objects.find(uid);
+    return it != shard.objects.end() ? it->second : nullptr;
+}
+
+size_t PrintObjectStore::eraseTree(const std::string& uid) {
+    // Children live in other shards: detach the parent first, then walk its
+    // children without holding any lock across shards.
+    std::shared_ptr<PrintObject> object;
+    {
+        Shard& shard = shardFor(uid);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.objects.find(uid);
+        if (it == shard.objects.end()) return 0;
+        object = std::move(it->second);
+        shard.objects.erase(it);
+    }
+    --objectCount_;
+
+    size_t erased = 1;
+    for (const std::string& child : object->children)
+        erased += eraseTree(child);
+    return erased;
+}
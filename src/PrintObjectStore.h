@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcdatset.h>
+
+#include "FilmLayout.h"
+
+class SpillFile;
+class DecodeAhead;
+
+/**
+ * @brief أنواع كائنات Basic Print Management
+ */
+enum class PrintObjectType {
+    FilmSession,
+    FilmBox,
+    ImageBox,
+    PresentationLut
+};
+
+/**
+ * @struct PrintObject
+ * @brief الأساس المشترك لكل كائنات الطباعة: المعرّف والصنف والاتصال المالك
+ *
+ * الكائن يُعدَّل فقط من خيط الاتصال الذي أنشأه، لذلك لا يحتاج قفلاً خاصاً؛
+ * القفل في المخزن يحمي الفهرس فقط.
+ */
+struct PrintObject {
+    const PrintObjectType type;
+    std::string sopInstanceUID;          ///< مفتاح البحث في المخزن
+    std::string sopClassUID;
+    unsigned long associationId = 0;     ///< الاتصال المالك (الكائنات لا تُشارك بين الاتصالات)
+    std::vector<std::string> children;   ///< الكائنات التابعة التي تُحذف معه
+
+    virtual ~PrintObject() = default;
+
+protected:
+    explicit PrintObject(PrintObjectType objectType) : type(objectType) {}
+};
+
+/**
+ * @struct FilmSessionObject
+ * @brief Basic Film Session: عدد النسخ والأولوية والوسط؛ أبناؤه هم Film Boxes
+ */
+struct FilmSessionObject : PrintObject {
+    static constexpr PrintObjectType TYPE = PrintObjectType::FilmSession;
+    unsigned numberOfCopies = 1;
+    std::string printPriority = "MED";
+    std::string mediumType = "PAPER";
+    std::string filmDestination = "MAGAZINE";
+    std::string label;
+
+    FilmSessionObject() : PrintObject(TYPE) {}
+};
+
+/**
+ * @struct FilmBoxObject
+ * @brief Basic Film Box: خصائص الصفحة؛ أبناؤه هم Image Boxes بترتيب Image Box Position
+ */
+struct FilmBoxObject : PrintObject {
+    static constexpr PrintObjectType TYPE = PrintObjectType::FilmBox;
+    std::string filmSessionUID;
+    FilmBoxSpec spec;
+    std::string presentationLutUID;      ///< Referenced Presentation LUT (اختياري)
+
+    FilmBoxObject() : PrintObject(TYPE) {}
+};
+
+/**
+ * @struct ImageBoxObject
+ * @brief Basic Grayscale/Color Image Box: موقعه في الفيلم وبيانات الصورة المستلمة
+ */
+struct ImageBoxObject : PrintObject {
+    static constexpr PrintObjectType TYPE = PrintObjectType::ImageBox;
+    std::string filmBoxUID;
+    Uint16 position = 0;                 ///< Image Box Position (1..n)
+    std::string polarity;                ///< NORMAL / REVERSE (فارغ = NORMAL)
+    std::string magnificationType;       ///< يتجاوز قيمة Film Box إذا لم يكن فارغاً
+    std::shared_ptr<DcmDataset> image;   ///< وحدة البكسلات (nullptr = فارغ)
+    std::shared_ptr<SpillFile> spill;    ///< ملف التفريغ الذي تُقرأ منه بكسلات image (nullptr = في الذاكرة)
+    std::shared_ptr<DecodeAhead> decodeAhead; ///< فك image الجاري في الخلفية مع مفتاحها (nullptr = لا شيء)
+
+    ImageBoxObject() : PrintObject(TYPE) {}
+};
+
+/**
+ * @struct PresentationLutObject
+ * @brief Presentation LUT: إما شكل (IDENTITY / INVERSE / LIN OD) أو جدول LUT كامل
+ */
+struct PresentationLutObject : PrintObject {
+    static constexpr PrintObjectType TYPE = PrintObjectType::PresentationLut;
+    std::string shape;                   ///< Presentation LUT Shape (فارغ إذا أُرسل جدول)
+    std::unique_ptr<DcmDataset> attributes; ///< البيانات كما استُلمت (Presentation LUT Sequence)
+
+    PresentationLutObject() : PrintObject(TYPE) {}
+};
+
+/**
+ * @class PrintObjectStore
+ * @brief مخزن كائنات الطباعة في الذاكرة مفهرس بـ SOP Instance UID
+ *
+ * الفهرس مقسّم إلى أجزاء (shards) لكل منها قفل قراءة/كتابة، فالبحث في مسارات
+ * N-SET / N-ACTION / N-DELETE يأخذ قفل قراءة على جزء واحد فقط، والاتصالات
+ * المتزامنة لا تتسلسل على قفل واحد.
+ */
+class PrintObjectStore {
+private:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<PrintObject>> objects;
+    };
+
+    Shard shards_[SHARD_COUNT];
+    std::atomic<size_t> objectCount_;
+    std::atomic<unsigned long> nextAssociationId_;
+
+public:
+    PrintObjectStore();
+
+    PrintObjectStore(const PrintObjectStore&) = delete;
+    PrintObjectStore& operator=(const PrintObjectStore&) = delete;
+
+    /**
+     * @brief رقم فريد لكل اتصال يُستخدم لتحديد ملكية الكائنات
+     */
+    unsigned long nextAssociationId() { return nextAssociationId_++; }
+
+    /**
+     * @brief إضافة كائن
+     * @return false إذا كان المعرّف موجوداً مسبقاً
+     */
+    bool insert(const std::shared_ptr<PrintObject>& object);
+
+    /**
+     * @brief البحث عن كائن من نوع محدد يملكه الاتصال المعطى
+     * @return nullptr إذا لم يوجد أو كان من نوع آخر أو يملكه اتصال آخر
+     */
+    template <class T>
+    std::shared_ptr<T> find(const std::string& uid, unsigned long associationId) const {
+        std::shared_ptr<PrintObject> object = findAny(uid);
+        if (!object || object->type != T::TYPE || object->associationId != associationId)
+            return nullptr;
+        return std::static_pointer_cast<T>(object);
+    }
+
+    /**
+     * @brief حذف كائن مع كل الكائنات التابعة له
+     * @return عدد الكائنات المحذوفة (0 إذا لم يوجد)
+     */
+    size_t eraseTree(const std::string& uid);
+
+    /**
+     * @brief عدد الكائنات المخزنة حالياً
+     */
+    size_t size() const { return objectCount_.load(); }
+
+private:
+    std::shared_ptr<PrintObject> findAny(const std::string& uid) const;
+    Shard& shardFor(const std::string& uid);
+    const Shard& shardFor(const std::string& uid) const;
+};
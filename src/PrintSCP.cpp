@@ -1,214 +1,147 @@
 // PrintSCP.cpp
 #include "PrintSCP.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <dcmtk/dcmdata/dctk.h>
-#include <dcmtk/dcmimgle/dcmimage.h>
-#include <windows.h>
+#include <dcmtk/dcmdata/dcuid.h>
 #include <vector>
-#include <iostream>
-#include <mutex>
+#include <cstdlib>
 #include <cstring>
 
 // -----------------------------
 // PrintSCP Implementation
 // -----------------------------
-PrintSCP::PrintSCP() : currentAssociation_(nullptr) {
-    std::cout << "🔄 تهيئة Print SCP..." << std::endl;
+PrintSCP::PrintSCP(const ServerConfig& config, PrintSpooler& spooler, PrintObjectStore& store,
+                   const std::atomic<bool>* stopRequested)
+    : config_(config), spooler_(spooler), store_(store), currentAssociation_(nullptr),
+      associationId_(0), stopRequested_(stopRequested) {
+    LOG_DEBUG << "🔄 تهيئة Print SCP...";
 }
 
 PrintSCP::~PrintSCP() {
-    std::cout << "🧹 تنظيف Print SCP..." << std::endl;
+    LOG_DEBUG << "🧹 تنظيف Print SCP...";
 }
 
-/**
- * @brief Helper: send image buffer to Windows printer. Supports 8-bit grayscale and 24-bit RGB.
- * bitsPerPixel: 8 or 24
- */
-bool PrintSCP::sendToPrinter(const Uint8* buffer,
-                             unsigned long width,
-                             unsigned long height,
-                             const std::string& printerName,
-                             int bitsPerPixel) {
-    // Open target printer (NULL = default)
-    HANDLE hPrinter = NULL;
-    if (!OpenPrinterA(printerName.empty() ? NULL : printerName.c_str(), &hPrinter, NULL)) {
-        std::cerr << "❌ Failed to open printer: " << printerName << " (using default?)" << std::endl;
-        return false;
-    }
+// -----------------------------
+// handleAssociation
+// -----------------------------
+OFCondition PrintSCP::handleAssociation(T_ASC_Association* assoc) {
+    currentAssociation_ = assoc;
+    associationId_ = store_.nextAssociationId();
 
-    DOC_INFO_1A docInfo;
-    ZeroMemory(&docInfo, sizeof(docInfo));
-    docInfo.pDocName = (LPSTR)"DICOM Print";
-    docInfo.pOutputFile = NULL;
-    docInfo.pDatatype = (LPSTR)"RAW";
+    // Every record logged while serving carries the association ID
+    LogContext context;
+    context.associationId = associationId_;
+    LogScope scope(context);
 
-    if (StartDocPrinterA(hPrinter, 1, (LPBYTE)&docInfo) == 0) {
-        std::cerr << "❌ Failed to start print doc" << std::endl;
-        ClosePrinter(hPrinter);
-        return false;
-    }
+    OFCondition cond = serveAssociation(assoc);
 
-    if (!StartPagePrinter(hPrinter)) {
-        std::cerr << "❌ Failed to start page" << std::endl;
-        EndDocPrinter(hPrinter);
-        ClosePrinter(hPrinter);
-        return false;
-    }
+    // Print objects never outlive the association that created them
+    releaseOwnedObjects();
+    currentAssociation_ = nullptr;
+    return cond;
+}
 
-    // Create device context for the printer
-    HDC hDC = CreateDCA("WINSPOOL", printerName.empty() ? NULL : printerName.c_str(), NULL, NULL);
-    if (!hDC) {
-        std::cerr << "❌ Failed to create printer DC" << std::endl;
-        EndPagePrinter(hPrinter);
-        EndDocPrinter(hPrinter);
-        ClosePrinter(hPrinter);
-        return false;
-    }
+void PrintSCP::releaseOwnedObjects() {
+    size_t released = 0;
+    for (const std::string& uid : ownedRoots_)
+        released += store_.eraseTree(uid);
+    ownedRoots_.clear();
+    filmSessionUID_.clear();
+    if (released)
+        LOG_INFO << "🧹 تحرير " << released << " كائن طباعة (المتبقي " << store_.size() << ")";
+}
 
-    BOOL result = FALSE;
-
-    if (bitsPerPixel == 8) {
-        // 8-bit grayscale: need BITMAPINFO with palette (256 entries)
-        size_t bmiSize = sizeof(BITMAPINFOHEADER) + 256 * sizeof(RGBQUAD);
-        BITMAPINFO* pbmi = (BITMAPINFO*)malloc(bmiSize);
-        if (!pbmi) {
-            std::cerr << "❌ Memory allocation failed for BITMAPINFO (8-bit)" << std::endl;
-            DeleteDC(hDC);
-            EndPagePrinter(hPrinter);
-            EndDocPrinter(hPrinter);
-            ClosePrinter(hPrinter);
-            return false;
-        }
-        ZeroMemory(pbmi, bmiSize);
-        pbmi->bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-        pbmi->bmiHeader.biWidth = (LONG)width;
-        pbmi->bmiHeader.biHeight = -(LONG)height; // top-down
-        pbmi->bmiHeader.biPlanes = 1;
-        pbmi->bmiHeader.biBitCount = 8;
-        pbmi->bmiHeader.biCompression = BI_RGB;
-        pbmi->bmiHeader.biSizeImage = 0;
-
-        for (int i = 0; i < 256; ++i) {
-            pbmi->bmiColors[i].rgbBlue = (BYTE)i;
-            pbmi->bmiColors[i].rgbGreen = (BYTE)i;
-            pbmi->bmiColors[i].rgbRed = (BYTE)i;
-            pbmi->bmiColors[i].rgbReserved = 0;
-        }
+OFCondition PrintSCP::serveAssociation(T_ASC_Association* assoc) {
+    OFCondition cond = EC_Normal;
+    T_DIMSE_Message msg;
+    T_ASC_PresentationContextID presID;
 
-        // StretchDIBits - it accepts 8-bit buffer with palette
-        int ret = StretchDIBits(hDC,
-                                0, 0, (int)width, (int)height,
-                                0, 0, (int)width, (int)height,
-                                buffer,
-                                pbmi,
-                                DIB_RGB_COLORS,
-                                SRCCOPY);
-        if (ret == GDI_ERROR) {
-            std::cerr << "❌ StretchDIBits failed for 8-bit image" << std::endl;
-            result = FALSE;
-        } else {
-            result = TRUE;
+    // The receive blocks on the association socket (select inside DUL) for at
+    // most pollInterval seconds, so a message is handled as soon as it arrives
+    // and an idle association only wakes up to check the stop flag.
+    const int waitSlice = std::max(1, std::min(config_.pollInterval, config_.idleTimeout));
+    auto lastActivity = std::chrono::steady_clock::now();
+
+    while (true) {
+        if (stopRequested_ && stopRequested_->load()) {
+            LOG_INFO << "🛑 إيقاف الخادم: إنهاء الاتصال الجاري";
+            ASC_abortAssociation(assoc);
+            return EC_Normal;
         }
-        free(pbmi);
-    } else if (bitsPerPixel == 24) {
-        // 24-bit RGB: Windows expects BGR and each scanline padded to 4 bytes
-        const int bytesPerPixel = 3;
-        int srcStride = (int)(width * bytesPerPixel);
-        int dstStride = ((srcStride + 3) / 4) * 4; // padded to 4 bytes
-        size_t paddedSize = (size_t)dstStride * height;
-
-        std::vector<BYTE> paddedBuffer(paddedSize);
-        // Fill paddedBuffer row by row (Windows uses bottom-up unless height negative; we used top-down by negative height in header, so keep order top-down)
-        for (unsigned long y = 0; y < height; ++y) {
-            const Uint8* srcRow = buffer + (y * srcStride);
-            BYTE* dstRow = paddedBuffer.data() + (y * dstStride);
-            // Copy and swap R<->B to make BGR
-            for (unsigned long x = 0; x < width; ++x) {
-                // src: R G B  -> dst: B G R
-                dstRow[x * 3 + 0] = srcRow[x * 3 + 2];
-                dstRow[x * 3 + 1] = srcRow[x * 3 + 1];
-                dstRow[x * 3 + 2] = srcRow[x * 3 + 0];
+
+        cond = DIMSE_receiveCommand(assoc, DIMSE_NONBLOCKING, waitSlice, &presID, &msg, NULL);
+
+        if (cond == DIMSE_NODATAAVAILABLE) {
+            const auto idle = std::chrono::steady_clock::now() - lastActivity;
+            if (idle >= std::chrono::seconds(config_.idleTimeout)) {
+                LOG_INFO << "⏱ انتهت مهلة الخمول (" << config_.idleTimeout
+                         << " ث) - إغلاق الاتصال";
+                ASC_abortAssociation(assoc);
+                return EC_Normal;
             }
-            // remaining padding bytes are already zero-initialized by vector
+            continue;
         }
-
-        BITMAPINFOHEADER bih;
-        ZeroMemory(&bih, sizeof(bih));
-        bih.biSize = sizeof(BITMAPINFOHEADER);
-        bih.biWidth = (LONG)width;
-        bih.biHeight = -(LONG)height; // top-down
-        bih.biPlanes = 1;
-        bih.biBitCount = 24;
-        bih.biCompression = BI_RGB;
-        bih.biSizeImage = (DWORD)paddedSize;
-
-        // StretchDIBits expects a BITMAPINFO pointer; we can pass pointer to header
-        int ret = StretchDIBits(hDC,
-                                0, 0, (int)width, (int)height,
-                                0, 0, (int)width, (int)height,
-                                paddedBuffer.data(),
-                                (BITMAPINFO*)&bih,
-                                DIB_RGB_COLORS,
-                                SRCCOPY);
-        if (ret == GDI_ERROR) {
-            std::cerr << "❌ StretchDIBits failed for 24-bit image" << std::endl;
-            result = FALSE;
-        } else {
-            result = TRUE;
+        if (cond == DUL_PEERREQUESTEDRELEASE) {
+            LOG_INFO << "👋 طلب إنهاء الاتصال من العميل";
+            return ASC_acknowledgeRelease(assoc);
+        }
+        if (cond == DUL_PEERABORTEDASSOCIATION) {
+            LOG_WARN << "⚠ قام العميل بإلغاء الاتصال";
+            return EC_Normal;
+        }
+        if (cond.bad()) {
+            LOG_ERROR << "❌ Error in DIMSE_receiveCommand: " << cond.text();
+            return cond;
         }
-    } else {
-        std::cerr << "❌ Unsupported bitsPerPixel: " << bitsPerPixel << std::endl;
-        result = FALSE;
-    }
 
-    // Cleanup GDI and printer
-    DeleteDC(hDC);
-    EndPagePrinter(hPrinter);
-    EndDocPrinter(hPrinter);
-    ClosePrinter(hPrinter);
+        switch (msg.CommandField) {
+            case DIMSE_N_CREATE_RQ:
+                LOG_DEBUG << "🖨 استلام طلب N-CREATE";
+                cond = handleNCreateRequest(msg.msg.NCreateRQ, presID);
+                break;
+            case DIMSE_N_ACTION_RQ:
+                LOG_DEBUG << "⚡ استلام طلب N-ACTION";
+                cond = handleNActionRequest(msg.msg.NActionRQ, presID);
+                break;
+            case DIMSE_N_SET_RQ:
+                LOG_DEBUG << "✏ استلام طلب N-SET";
+                cond = handleNSetRequest(msg.msg.NSetRQ, presID);
+                break;
+            case DIMSE_N_DELETE_RQ:
+                LOG_DEBUG << "🗑 استلام طلب N-DELETE";
+                cond = handleNDeleteRequest(msg.msg.NDeleteRQ, presID);
+                break;
+            default:
+                LOG_WARN << "❌ أمر DIMSE غير معروف: " << msg.CommandField;
+                break;
+        }
+        if (cond.bad()) return cond;
 
-    if (result)
-        std::cout << "✅ Image successfully sent to printer" << std::endl;
-    return result != FALSE;
+        lastActivity = std::chrono::steady_clock::now();
+    }
 }
 
-// -----------------------------
-// handleAssociation
-// -----------------------------
-OFCondition PrintSCP::handleAssociation(T_ASC_Association* assoc) {
-    currentAssociation_ = assoc;
-    OFCondition cond = EC_Normal;
-    T_DIMSE_Message msg;
-    T_ASC_PresentationContextID presID;
-
-    while (cond.good()) {
-        cond = DIMSE_receiveCommand(assoc, DIMSE_NONBLOCKING, 30, &presID, &msg, NULL);
-
-        if (cond.good()) {
-            switch (msg.CommandField) {
-                case DIMSE_N_CREATE_RQ:
-                    std::cout << "🖨 استلام طلب N-CREATE" << std::endl;
-                    cond = handleNCreateRequest(msg.msg.NCreateRQ, presID);
-                    break;
-                case DIMSE_N_ACTION_RQ:
-                    std::cout << "⚡ استلام طلب N-ACTION" << std::endl;
-                    cond = handleNActionRequest(msg.msg.NActionRQ, presID);
-                    break;
-                case DIMSE_N_DELETE_RQ:
-                    std::cout << "🗑 استلام طلب N-DELETE" << std::endl;
-                    cond = handleNDeleteRequest(msg.msg.NDeleteRQ, presID);
-                    break;
-                default:
-                    std::cout << "❌ أمر DIMSE غير معروف: " << msg.CommandField << std::endl;
-                    break;
-            }
-        } else if (cond == DIMSE_NODATAAVAILABLE) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            cond = EC_Normal;
-        }
+OFCondition PrintSCP::receiveDataset(T_ASC_PresentationContextID presID,
+                                     std::unique_ptr<DcmDataset>& dataset,
+                                     std::shared_ptr<SpillFile>* spill) {
+    StageTimer timer(Stage::DatasetReceive);
+    OFCondition cond;
+    if (spill && config_.spillThresholdMB > 0) {
+        // Image data: through a file so pixel data can stay on disk until printed
+        cond = receiveDatasetSpilled(currentAssociation_, presID, config_, dataset, *spill);
+    } else {
+        DcmDataset* received = nullptr;
+        cond = DIMSE_receiveDataSetInMemory(currentAssociation_, DIMSE_NONBLOCKING, config_.dimseTimeout, &presID, &received, NULL, NULL);
+        dataset.reset(received);
+        if (cond.good() && dataset)
+            Metrics::instance().addBytesReceived(dataset->getLength(dataset->getOriginalXfer()));
     }
-
+    if (cond.good() && !dataset) cond = EC_IllegalParameter;
+    if (cond.bad()) LOG_ERROR << "❌ لم يتم استلام Dataset: " << cond.text();
     return cond;
 }
 
@@ -217,82 +150,283 @@ OFCondition PrintSCP::handleAssociation(T_ASC_Association* assoc) {
 // -----------------------------
 OFCondition PrintSCP::handleNCreateRequest(const T_DIMSE_N_CreateRQ& req,
                                            T_ASC_PresentationContextID presID) {
-    std::cout << "📋 SOP Class: " << req.AffectedSOPClassUID << std::endl;
-    std::cout << "🔑 SOP Instance: " << req.AffectedSOPInstanceUID << std::endl;
-
-    // استلام الـ Dataset المرفق
-    DcmDataset* dataset = nullptr;
-    OFCondition cond = DIMSE_receiveDataSetInMemory(currentAssociation_, presID, &dataset, NULL, NULL);
-    if (cond.bad() || !dataset) {
-        std::cerr << "❌ لم يتم استلام Dataset" << std::endl;
-        return sendNCreateResponse(req, presID, STATUS_ProcessingFailure);
+    LOG_DEBUG << "📋 SOP Class: " << req.AffectedSOPClassUID;
+    LOG_DEBUG << "🔑 SOP Instance: " << req.AffectedSOPInstanceUID;
+
+    // استلام الـ Dataset المرفق (اختياري لـ Film Session)
+    // Print management objects are small; anything else may be a legacy image
+    const std::string sopClass = req.AffectedSOPClassUID;
+    const bool printObject = sopClass == UID_BasicFilmSessionSOPClass || sopClass == UID_BasicFilmBoxSOPClass ||
+                             sopClass == UID_PresentationLUTSOPClass;
+    std::unique_ptr<DcmDataset> dataset;
+    std::shared_ptr<SpillFile> spill;
+    if (req.DataSetType != DIMSE_DATASET_NULL) {
+        if (receiveDataset(presID, dataset, printObject ? nullptr : &spill).bad())
+            return sendNCreateResponse(req, presID, STATUS_N_ProcessingFailure, std::string(), nullptr);
+    } else {
+        dataset.reset(new DcmDataset());
     }
 
-    // التشخيص: Transfer Syntax ووجود PixelData
-    OFString txUID;
-    dataset->findAndGetOFString(DCM_TransferSyntaxUID, txUID);
-    std::cout << "Transfer Syntax UID (dataset): " << txUID << std::endl;
+    // The SCU may propose the instance UID; otherwise we assign one
+    std::string uid = req.AffectedSOPInstanceUID;
+    if (uid.empty()) {
+        char generated[100];
+        dcmGenerateUniqueIdentifier(generated, SITE_INSTANCE_UID_ROOT);
+        uid = generated;
+    }
 
-    DcmElement* pixElem = nullptr;
-    if (dataset->findAndGetElement(DCM_PixelData, pixElem) == EC_Normal) {
-        std::cout << "PixelData: present" << std::endl;
+    std::unique_ptr<DcmDataset> rspDataset;
+    Uint16 status;
+
+    if (sopClass == UID_BasicFilmSessionSOPClass) {
+        status = createFilmSession(uid, *dataset, rspDataset);
+    } else if (sopClass == UID_BasicFilmBoxSOPClass) {
+        status = createFilmBox(uid, *dataset, presID, rspDataset);
+    } else if (sopClass == UID_PresentationLUTSOPClass) {
+        status = createPresentationLut(uid, *dataset);
+    } else if (isPrintableDataset(*dataset)) {
+        // Legacy: an image sent directly with N-CREATE is printed as a one-box film
+        std::string jobUID;
+        status = enqueuePrintJob(dataset.release(), spill, jobUID);
     } else {
-        std::cout << "PixelData: NOT found" << std::endl;
+        LOG_ERROR << "❌ SOP Class غير مدعوم في N-CREATE: " << sopClass;
+        status = STATUS_N_NoSuchSOPClass;
     }
 
-    // Use DicomImage to convert to displayable 8-bit (or 24-bit for color)
-    DicomImage dcmImage(dataset, EXS_Unknown);
-    if (dcmImage.getStatus() != EIS_Normal) {
-        std::cerr << "❌ Error reading DICOM Image (status=" << dcmImage.getStatus() << ")\n";
-        delete dataset;
-        return sendNCreateResponse(req, presID, STATUS_CannotUnderstand);
-    }
+    return sendNCreateResponse(req, presID, status, status == STATUS_Success ? uid : std::string(),
+                               rspDataset.get());
+}
 
-    dcmImage.setMinMaxWindow(); // apply automatic windowing
+// -----------------------------
+// إنشاء كائنات الطباعة
+// -----------------------------
+Uint16 PrintSCP::createFilmSession(const std::string& uid, DcmDataset& dataset,
+                                   std::unique_ptr<DcmDataset>& rspDataset) {
+    LOG_DEBUG << "🎞 معالجة إنشاء جلسة فيلم";
+    if (!filmSessionUID_.empty()) {
+        LOG_ERROR << "❌ توجد جلسة فيلم بالفعل في هذا الاتصال";
+        return STATUS_N_DuplicateSOPInstance;
+    }
 
-    const unsigned long width = dcmImage.getWidth();
-    const unsigned long height = dcmImage.getHeight();
+    auto session = std::make_shared<FilmSessionObject>();
+    session->sopInstanceUID = uid;
+    session->sopClassUID = UID_BasicFilmSessionSOPClass;
+    session->associationId = associationId_;
+
+    OFString value;
+    if (dataset.findAndGetOFString(DCM_NumberOfCopies, value).good() && !value.empty())
+        session->numberOfCopies = (unsigned)std::max(1, atoi(value.c_str()));
+    if (dataset.findAndGetOFString(DCM_PrintPriority, value).good() && !value.empty())
+        session->printPriority = value.c_str();
+    if (dataset.findAndGetOFString(DCM_MediumType, value).good() && !value.empty())
+        session->mediumType = value.c_str();
+    if (dataset.findAndGetOFString(DCM_FilmDestination, value).good() && !value.empty())
+        session->filmDestination = value.c_str();
+    if (dataset.findAndGetOFString(DCM_FilmSessionLabel, value).good())
+        session->label = value.c_str();
+
+    if (!store_.insert(session)) return STATUS_N_DuplicateSOPInstance;
+    filmSessionUID_ = uid;
+    ownedRoots_.push_back(uid);
+
+    // Echo the effective attribute values
+    rspDataset.reset(new DcmDataset());
+    rspDataset->putAndInsertString(DCM_NumberOfCopies, std::to_string(session->numberOfCopies).c_str());
+    rspDataset->putAndInsertString(DCM_PrintPriority, session->printPriority.c_str());
+    rspDataset->putAndInsertString(DCM_MediumType, session->mediumType.c_str());
+    rspDataset->putAndInsertString(DCM_FilmDestination, session->filmDestination.c_str());
+
+    LOG_INFO << "✅ إنشاء جلسة طباعة جديدة: " << uid;
+    return STATUS_Success;
+}
 
-    const void* outData = dcmImage.getOutputData(8); // request 8-bit output; color images will be 3 bytes per pixel
-    if (!outData) {
-        std::cerr << "❌ getOutputData returned NULL" << std::endl;
-        delete dataset;
-        return sendNCreateResponse(req, presID, STATUS_ProcessingFailure);
+Uint16 PrintSCP::createFilmBox(const std::string& uid, DcmDataset& dataset,
+                               T_ASC_PresentationContextID presID,
+                               std::unique_ptr<DcmDataset>& rspDataset) {
+    LOG_DEBUG << "📦 معالجة إنشاء صندوق فيلم";
+
+    // The film box must reference this association's film session
+    DcmItem* sessionRef = nullptr;
+    OFString sessionUID;
+    if (dataset.findAndGetSequenceItem(DCM_ReferencedFilmSessionSequence, sessionRef).bad() ||
+        sessionRef->findAndGetOFString(DCM_ReferencedSOPInstanceUID, sessionUID).bad()) {
+        LOG_ERROR << "❌ Referenced Film Session Sequence مفقود";
+        return STATUS_N_MissingAttribute;
+    }
+    std::shared_ptr<FilmSessionObject> session =
+        store_.find<FilmSessionObject>(sessionUID.c_str(), associationId_);
+    if (!session) {
+        LOG_ERROR << "❌ Film Session غير موجودة: " << sessionUID;
+        return STATUS_N_InvalidAttributeValue;
+    }
+    if (!dataset.tagExists(DCM_ImageDisplayFormat)) return STATUS_N_MissingAttribute;
+
+    auto filmBox = std::make_shared<FilmBoxObject>();
+    filmBox->sopInstanceUID = uid;
+    filmBox->sopClassUID = UID_BasicFilmBoxSOPClass;
+    filmBox->associationId = associationId_;
+    filmBox->filmSessionUID = sessionUID.c_str();
+    filmBox->spec.updateFrom(dataset);
+
+    FilmLayout layout;
+    if (!computeFilmLayout(filmBox->spec, config_.printerDpi, layout)) {
+        LOG_ERROR << "❌ تنسيق غير مدعوم: " << filmBox->spec.imageDisplayFormat << " / "
+                  << filmBox->spec.filmSizeID;
+        return STATUS_N_InvalidAttributeValue;
     }
 
-    // If monochrome, outData length = width*height (1 byte per pixel)
-    // If color, outData length = width*height*3 (RGB)
-    if (dcmImage.isMonochrome()) {
-        std::vector<Uint8> buffer(width * height);
-        memcpy(buffer.data(), outData, width * height);
+    DcmItem* lutRef = nullptr;
+    OFString lutUID;
+    if (dataset.findAndGetSequenceItem(DCM_ReferencedPresentationLUTSequence, lutRef).good() &&
+        lutRef->findAndGetOFString(DCM_ReferencedSOPInstanceUID, lutUID).good()) {
+        if (!store_.find<PresentationLutObject>(lutUID.c_str(), associationId_))
+            return STATUS_N_InvalidAttributeValue;
+        filmBox->presentationLutUID = lutUID.c_str();
+    }
 
-        // MONOCHROME1 needs inversion
-        if (dcmImage.getPhotometricInterpretation() == EPI_Monochrome1) {
-            for (size_t i = 0; i < buffer.size(); ++i) buffer[i] = 255 - buffer[i];
+    // Image boxes follow the meta SOP class negotiated for this context
+    T_ASC_PresentationContext pc;
+    const bool color =
+        ASC_findAcceptedPresentationContext(currentAssociation_->params, presID, &pc).good() &&
+        strcmp(pc.abstractSyntax, UID_BasicColorPrintManagementMetaSOPClass) == 0;
+    const char* imageBoxClass = color ? UID_BasicColorImageBoxSOPClass : UID_BasicGrayscaleImageBoxSOPClass;
+
+    rspDataset.reset(new DcmDataset(dataset));
+    for (size_t i = 0; i < layout.tiles.size(); ++i) {
+        char imageBoxUID[100];
+        dcmGenerateUniqueIdentifier(imageBoxUID, SITE_INSTANCE_UID_ROOT);
+
+        auto imageBox = std::make_shared<ImageBoxObject>();
+        imageBox->sopInstanceUID = imageBoxUID;
+        imageBox->sopClassUID = imageBoxClass;
+        imageBox->associationId = associationId_;
+        imageBox->filmBoxUID = uid;
+        imageBox->position = (Uint16)(i + 1);
+        store_.insert(imageBox);
+        filmBox->children.push_back(imageBoxUID);
+
+        DcmItem* item = nullptr;
+        if (rspDataset->findOrCreateSequenceItem(DCM_ReferencedImageBoxSequence, item, -2).good()) {
+            item->putAndInsertString(DCM_ReferencedSOPClassUID, imageBoxClass);
+            item->putAndInsertString(DCM_ReferencedSOPInstanceUID, imageBoxUID);
         }
+    }
 
-        // Send to printer as 8-bit grayscale
-        if (!sendToPrinter(buffer.data(), width, height, std::string(), 8)) {
-            std::cerr << "❌ sendToPrinter failed for monochrome image" << std::endl;
-            delete dataset;
-            return sendNCreateResponse(req, presID, STATUS_ProcessingFailure);
-        }
+    if (!store_.insert(filmBox)) {
+        for (const std::string& child : filmBox->children) store_.eraseTree(child);
+        rspDataset.reset();
+        return STATUS_N_DuplicateSOPInstance;
+    }
+    session->children.push_back(uid);
+
+    LOG_INFO << "✅ Film Box " << filmBox->spec.imageDisplayFormat << " مع "
+             << layout.tiles.size() << " مربع صورة";
+    return STATUS_Success;
+}
+
+Uint16 PrintSCP::createPresentationLut(const std::string& uid, DcmDataset& dataset) {
+    LOG_DEBUG << "🌗 معالجة إنشاء Presentation LUT";
+
+    auto lut = std::make_shared<PresentationLutObject>();
+    lut->sopInstanceUID = uid;
+    lut->sopClassUID = UID_PresentationLUTSOPClass;
+    lut->associationId = associationId_;
+
+    OFString shape;
+    if (dataset.findAndGetOFString(DCM_PresentationLUTShape, shape).good() && !shape.empty())
+        lut->shape = shape.c_str();
+    else if (!dataset.tagExists(DCM_PresentationLUTSequence))
+        return STATUS_N_MissingAttribute;
+    lut->attributes.reset(new DcmDataset(dataset));
+
+    if (!store_.insert(lut)) return STATUS_N_DuplicateSOPInstance;
+    ownedRoots_.push_back(uid);
+    return STATUS_Success;
+}
+
+// -----------------------------
+// N-SET
+// -----------------------------
+OFCondition PrintSCP::handleNSetRequest(const T_DIMSE_N_SetRQ& req,
+                                        T_ASC_PresentationContextID presID) {
+    const std::string sopClass = req.RequestedSOPClassUID;
+    const std::string uid = req.RequestedSOPInstanceUID;
+    const bool imageBoxClass = sopClass == UID_BasicGrayscaleImageBoxSOPClass ||
+                               sopClass == UID_BasicColorImageBoxSOPClass;
+
+    // Only image boxes carry pixel data worth keeping on disk
+    std::unique_ptr<DcmDataset> dataset;
+    std::shared_ptr<SpillFile> spill;
+    OFCondition cond = receiveDataset(presID, dataset, imageBoxClass ? &spill : nullptr);
+    if (cond.bad()) return cond;
+
+    Uint16 status;
+
+    if (imageBoxClass) {
+        std::shared_ptr<ImageBoxObject> imageBox = store_.find<ImageBoxObject>(uid, associationId_);
+        if (!imageBox) status = STATUS_N_NoSuchObjectInstance;
+        else if (imageBox->sopClassUID != sopClass) status = STATUS_N_ClassInstanceConflict;
+        else status = setImageBox(*imageBox, *dataset, spill);
     } else {
-        // Color image - assume RGB interleaved (R G B)
-        const size_t rgbSize = (size_t)width * (size_t)height * 3;
-        std::vector<Uint8> rgbBuffer(rgbSize);
-        memcpy(rgbBuffer.data(), outData, rgbSize);
-
-        // sendToPrinter expects BGR; the function will swap bytes
-        if (!sendToPrinter(rgbBuffer.data(), width, height, std::string(), 24)) {
-            std::cerr << "❌ sendToPrinter failed for color image" << std::endl;
-            delete dataset;
-            return sendNCreateResponse(req, presID, STATUS_ProcessingFailure);
-        }
+        LOG_ERROR << "❌ SOP Class غير مدعوم في N-SET: " << sopClass;
+        status = STATUS_N_NoSuchSOPClass;
+    }
+
+    T_DIMSE_Message rsp;
+    memset(&rsp, 0, sizeof(rsp));
+    rsp.CommandField = DIMSE_N_SET_RSP;
+    rsp.msg.NSetRSP.MessageIDBeingRespondedTo = req.MessageID;
+    rsp.msg.NSetRSP.DimseStatus = status;
+    rsp.msg.NSetRSP.DataSetType = DIMSE_DATASET_NULL;
+    OFStandard::strlcpy(rsp.msg.NSetRSP.AffectedSOPClassUID, req.RequestedSOPClassUID,
+                        sizeof(rsp.msg.NSetRSP.AffectedSOPClassUID));
+    OFStandard::strlcpy(rsp.msg.NSetRSP.AffectedSOPInstanceUID, req.RequestedSOPInstanceUID,
+                        sizeof(rsp.msg.NSetRSP.AffectedSOPInstanceUID));
+    rsp.msg.NSetRSP.opts = O_NSET_AFFECTEDSOPCLASSUID | O_NSET_AFFECTEDSOPINSTANCEUID;
+    Metrics::instance().dimseResponse("N-SET", status);
+    return DIMSE_sendMessageUsingMemoryData(currentAssociation_, presID, &rsp, NULL, NULL, NULL, NULL);
+}
+
+Uint16 PrintSCP::setImageBox(ImageBoxObject& imageBox, DcmDataset& dataset,
+                             const std::shared_ptr<SpillFile>& spill) {
+    Uint16 position = 0;
+    if (dataset.findAndGetUint16(DCM_ImageBoxPosition, position).good() && position != imageBox.position) {
+        LOG_ERROR << "❌ Image Box Position " << position << " != " << imageBox.position;
+        return STATUS_N_InvalidAttributeValue;
     }
 
-    delete dataset;
-    return sendNCreateResponse(req, presID, STATUS_Success);
+    OFString value;
+    if (dataset.findAndGetOFString(DCM_Polarity, value).good()) imageBox.polarity = value.c_str();
+    if (dataset.findAndGetOFString(DCM_MagnificationType, value).good()) imageBox.magnificationType = value.c_str();
+
+    const bool color = imageBox.sopClassUID == UID_BasicColorImageBoxSOPClass;
+    DcmItem* pixelModule = nullptr;
+    if (dataset.findAndGetSequenceItem(color ? DCM_BasicColorImageSequence : DCM_BasicGrayscaleImageSequence,
+                                       pixelModule).bad()) {
+        // Attribute-only update (e.g. polarity); the stored image is kept
+        return STATUS_Success;
+    }
+    if (!isPrintableDataset(*pixelModule)) return STATUS_N_MissingAttribute;
+
+    // Move the pixel module out of the request as received
+    std::shared_ptr<DcmDataset> image(new DcmDataset());
+    while (pixelModule->card() > 0)
+        image->insert(pixelModule->remove((unsigned long)0), OFTrue);
+    image->updateOriginalXfer();
+
+    // Replacing an image that was never printed costs nothing but the free; a
+    // decode still running on the old one finishes on its own copy
+    imageBox.image = image;
+    imageBox.spill = spill;
+
+    // Decode on the render threads while the next image box is received, so the
+    // response goes out now and the film is ready to compose at N-ACTION. The page
+    // cache key is hashed in the same task, before the pixel data is rewritten.
+    // Spilled pixel data stays on disk until it is printed (and is keyed then).
+    imageBox.decodeAhead = spill ? nullptr : spooler_.decodeAhead(image);
+    LOG_DEBUG << "🖼 Image Box " << imageBox.position << " محفوظ"
+              << (imageBox.decodeAhead ? " (فك الترميز في الخلفية)" : " (بدون فك ترميز)");
+    return STATUS_Success;
 }
 
 // -----------------------------
@@ -300,70 +434,194 @@ OFCondition PrintSCP::handleNCreateRequest(const T_DIMSE_N_CreateRQ& req,
 // -----------------------------
 OFCondition PrintSCP::handleNActionRequest(const T_DIMSE_N_ActionRQ& req,
                                            T_ASC_PresentationContextID presID) {
-    std::cout << "⚡ معالجة N-ACTION: " << req.ActionTypeID << std::endl;
-
-    // استلام Dataset للطباعة
-    DcmDataset* dataset = nullptr;
-    OFCondition cond = DIMSE_receiveDataSetInMemory(currentAssociation_, presID, &dataset, NULL, NULL);
-    if (cond.bad() || !dataset) {
-        std::cerr << "❌ لم يتم استلام Dataset" << std::endl;
-        return EC_IllegalParameter;
-    }
+    LOG_DEBUG << "⚡ معالجة N-ACTION: " << req.ActionTypeID;
 
-    // معالجة مشابهة لـ N-CREATE: تحويل الصورة وإرسالها
-    DicomImage dcmImage(dataset, EXS_Unknown);
-    if (dcmImage.getStatus() != EIS_Normal) {
-        std::cerr << "❌ خطأ في قراءة DICOM Image" << std::endl;
-        delete dataset;
-        return EC_CorruptedData;
-    }
+    // Legacy: an image attached to N-ACTION is printed directly
+    if (req.DataSetType != DIMSE_DATASET_NULL) {
+        std::unique_ptr<DcmDataset> dataset;
+        std::shared_ptr<SpillFile> spill;
+        OFCondition cond = receiveDataset(presID, dataset, &spill);
+        if (cond.bad()) return cond;
 
-    dcmImage.setMinMaxWindow();
-    const unsigned long width = dcmImage.getWidth();
-    const unsigned long height = dcmImage.getHeight();
+        if (!isPrintableDataset(*dataset))
+            return sendNActionResponse(req, presID, STATUS_CannotUnderstand, std::string());
 
-    const void* outData = dcmImage.getOutputData(8);
-    if (!outData) {
-        std::cerr << "❌ getOutputData returned NULL in N-ACTION" << std::endl;
-        delete dataset;
-        return EC_CorruptedData;
+        std::string jobUID;
+        const Uint16 status = enqueuePrintJob(dataset.release(), spill, jobUID);
+        return sendNActionResponse(req, presID, status, jobUID);
     }
 
-    if (dcmImage.isMonochrome()) {
-        std::vector<Uint8> buffer(width * height);
-        memcpy(buffer.data(), outData, width * height);
-        if (dcmImage.getPhotometricInterpretation() == EPI_Monochrome1)
-            for (size_t i = 0; i < buffer.size(); ++i) buffer[i] = 255 - buffer[i];
-
-        if (!sendToPrinter(buffer.data(), width, height, std::string(), 8)) {
-            std::cerr << "❌ sendToPrinter failed (N-ACTION, mono)" << std::endl;
-            delete dataset;
-            return EC_CorruptedData;
+    if (req.ActionTypeID != 1) // 1 = Print
+        return sendNActionResponse(req, presID, STATUS_N_NoSuchAction, std::string());
+
+    const std::string sopClass = req.RequestedSOPClassUID;
+    const std::string uid = req.RequestedSOPInstanceUID;
+    std::unique_ptr<PrintJob> job = spooler_.createJob();
+    bool anyImage = false;
+
+    if (sopClass == UID_BasicFilmBoxSOPClass) {
+        std::shared_ptr<FilmBoxObject> filmBox = store_.find<FilmBoxObject>(uid, associationId_);
+        if (!filmBox)
+            return sendNActionResponse(req, presID, STATUS_N_NoSuchObjectInstance, std::string());
+        job->pages.emplace_back();
+        anyImage = buildFilmPage(*filmBox, job->pages.back());
+        if (auto session = store_.find<FilmSessionObject>(filmBox->filmSessionUID, associationId_))
+            applySession(*session, *job);
+    } else if (sopClass == UID_BasicFilmSessionSOPClass) {
+        std::shared_ptr<FilmSessionObject> session = store_.find<FilmSessionObject>(uid, associationId_);
+        if (!session)
+            return sendNActionResponse(req, presID, STATUS_N_NoSuchObjectInstance, std::string());
+        for (const std::string& filmBoxUID : session->children) {
+            if (auto filmBox = store_.find<FilmBoxObject>(filmBoxUID, associationId_)) {
+                job->pages.emplace_back();
+                anyImage = buildFilmPage(*filmBox, job->pages.back()) || anyImage;
+            }
         }
+        if (job->pages.empty()) {
+            LOG_ERROR << "❌ جلسة الفيلم لا تحتوي على Film Box";
+            return sendNActionResponse(req, presID, STATUS_N_PRINT_BFS_Fail_NoFilmBox, std::string());
+        }
+        applySession(*session, *job);
     } else {
-        const size_t rgbSize = (size_t)width * (size_t)height * 3;
-        std::vector<Uint8> rgbBuffer(rgbSize);
-        memcpy(rgbBuffer.data(), outData, rgbSize);
-
-        if (!sendToPrinter(rgbBuffer.data(), width, height, std::string(), 24)) {
-            std::cerr << "❌ sendToPrinter failed (N-ACTION, color)" << std::endl;
-            delete dataset;
-            return EC_CorruptedData;
+        return sendNActionResponse(req, presID, STATUS_N_NoSuchSOPClass, std::string());
+    }
+
+    // Nothing to put on film: warn instead of printing blank sheets
+    if (!anyImage) {
+        LOG_WARN << "⚠ كل مربعات الصور فارغة - لم تتم الطباعة";
+        return sendNActionResponse(req, presID, STATUS_N_PRINT_BFB_Warn_EmptyPage, std::string());
+    }
+
+    std::string jobUID;
+    const Uint16 status = submitJob(std::move(job), jobUID);
+    return sendNActionResponse(req, presID, status, jobUID);
+}
+
+bool PrintSCP::buildFilmPage(const FilmBoxObject& filmBox, FilmPage& page) {
+    page.film = filmBox.spec;
+    page.images.resize(filmBox.children.size());
+
+    // Film-level Presentation LUT applies to every image box
+    std::string lutShape;
+    if (!filmBox.presentationLutUID.empty()) {
+        if (auto lut = store_.find<PresentationLutObject>(filmBox.presentationLutUID, associationId_))
+            lutShape = lut->shape;
+    }
+
+    // The job shares each image box dataset instead of copying it. Neither side
+    // writes to a dataset the other holds: N-SET stores a new one in the box, and the
+    // spooler copies a shared dataset before decoding it or loading its spilled pixel
+    // data, which DCMTK keeps in whichever dataset first reads it
+    bool anyImage = false;
+    for (size_t i = 0; i < filmBox.children.size(); ++i) {
+        std::shared_ptr<ImageBoxObject> imageBox =
+            store_.find<ImageBoxObject>(filmBox.children[i], associationId_);
+        if (imageBox && imageBox->image) {
+            if (imageBox->decodeAhead) imageBox->decodeAhead->wait();
+            page.images[i].dataset = imageBox->image;
+            page.images[i].polarity = imageBox->polarity;
+            page.images[i].magnificationType = imageBox->magnificationType;
+            page.images[i].presentationLutShape = lutShape;
+            page.images[i].spill = imageBox->spill;
+            if (imageBox->decodeAhead) page.images[i].cacheKey = imageBox->decodeAhead->cacheKey();
+            anyImage = true;
         }
     }
+    return anyImage;
+}
 
-    delete dataset;
+// -----------------------------
+// التحقق السريع وإضافة مهمة الطباعة
+// -----------------------------
+bool PrintSCP::isPrintableDataset(DcmItem& dataset) {
+    // Cheap attribute checks only; decoding happens on the spooler workers
+    DcmElement* pixElem = nullptr;
+    if (dataset.findAndGetElement(DCM_PixelData, pixElem).bad()) {
+        LOG_WARN << "PixelData: NOT found";
+        return false;
+    }
+    LOG_DEBUG << "PixelData: present";
+
+    Uint16 rows = 0, columns = 0;
+    if (dataset.findAndGetUint16(DCM_Rows, rows).bad() ||
+        dataset.findAndGetUint16(DCM_Columns, columns).bad() ||
+        rows == 0 || columns == 0) {
+        LOG_ERROR << "❌ Rows/Columns missing or zero";
+        return false;
+    }
+    return true;
+}
 
-    // إرسال الرد
+Uint16 PrintSCP::enqueuePrintJob(DcmDataset* dataset, const std::shared_ptr<SpillFile>& spill,
+                                 std::string& jobUID) {
+    std::unique_ptr<PrintJob> job = spooler_.createJob();
+
+    // A bare image is printed as a one-box film; Film Box attributes that
+    // travel with it (display format, film size...) still apply
+    job->pages.emplace_back();
+    FilmPage& page = job->pages.back();
+    page.film.updateFrom(*dataset);
+    page.images.emplace_back();
+    page.images.back().dataset.reset(dataset);
+    page.images.back().spill = spill;
+    return submitJob(std::move(job), jobUID);
+}
+
+Uint16 PrintSCP::submitJob(std::unique_ptr<PrintJob> job, std::string& jobUID) {
+    job->callingAE = currentAssociation_->params->DULparams.callingAPTitle;
+    jobUID = job->jobUID;
+
+    switch (spooler_.submit(std::move(job))) {
+    case SubmitResult::Queued:
+        return STATUS_Success;
+    case SubmitResult::NoPrinter:
+        jobUID.clear();
+        return STATUS_N_ProcessingFailure;
+    case SubmitResult::QueueFull:
+    default:
+        jobUID.clear();
+        return STATUS_N_PRINT_BSB_Fail_PrintQueueFull;
+    }
+}
+
+void PrintSCP::applySession(const FilmSessionObject& session, PrintJob& job) {
+    job.copies = session.numberOfCopies;
+    job.priority = parsePrintPriority(session.printPriority);
+    job.mediumType = session.mediumType;
+}
+
+// -----------------------------
+// إرسال N-ACTION Response
+// -----------------------------
+OFCondition PrintSCP::sendNActionResponse(const T_DIMSE_N_ActionRQ& req,
+                                          T_ASC_PresentationContextID presID,
+                                          Uint16 status,
+                                          const std::string& jobUID) {
     T_DIMSE_Message rsp;
     memset(&rsp, 0, sizeof(rsp));
     rsp.CommandField = DIMSE_N_ACTION_RSP;
     rsp.msg.NActionRSP.MessageIDBeingRespondedTo = req.MessageID;
     rsp.msg.NActionRSP.ActionTypeID = req.ActionTypeID;
-    rsp.msg.NActionRSP.DimseStatus = STATUS_Success;
+    rsp.msg.NActionRSP.DimseStatus = status;
     rsp.msg.NActionRSP.DataSetType = DIMSE_DATASET_NULL;
 
-    return DIMSE_sendMessageUsingMemoryData(currentAssociation_, presID, &rsp, NULL, NULL, NULL, NULL);
+    // Reference the queued Print Job so the SCU can track it
+    DcmDataset* rspDataset = nullptr;
+    if (status == STATUS_Success && !jobUID.empty()) {
+        rspDataset = new DcmDataset();
+        DcmItem* item = nullptr;
+        if (rspDataset->findOrCreateSequenceItem(DCM_ReferencedPrintJobSequence, item).good()) {
+            item->putAndInsertString(DCM_ReferencedSOPClassUID, UID_PrintJobSOPClass);
+            item->putAndInsertString(DCM_ReferencedSOPInstanceUID, jobUID.c_str());
+        }
+        rsp.msg.NActionRSP.DataSetType = DIMSE_DATASET_PRESENT;
+    }
+
+    Metrics::instance().dimseResponse("N-ACTION", status);
+    OFCondition sendCond = DIMSE_sendMessageUsingMemoryData(
+        currentAssociation_, presID, &rsp, NULL, rspDataset, NULL, NULL);
+    delete rspDataset;
+    return sendCond;
 }
 
 // -----------------------------
@@ -371,13 +629,40 @@ OFCondition PrintSCP::handleNActionRequest(const T_DIMSE_N_ActionRQ& req,
 // -----------------------------
 OFCondition PrintSCP::handleNDeleteRequest(const T_DIMSE_N_DeleteRQ& req,
                                            T_ASC_PresentationContextID presID) {
-    std::cout << "🗑 معالجة N-DELETE" << std::endl;
+    LOG_DEBUG << "🗑 معالجة N-DELETE";
+    const std::string sopClass = req.RequestedSOPClassUID;
+    const std::string uid = req.RequestedSOPInstanceUID;
+    Uint16 status = STATUS_Success;
+
+    if (sopClass == UID_BasicFilmSessionSOPClass) {
+        if (!store_.find<FilmSessionObject>(uid, associationId_)) status = STATUS_N_NoSuchObjectInstance;
+        else filmSessionUID_.clear();
+    } else if (sopClass == UID_BasicFilmBoxSOPClass) {
+        std::shared_ptr<FilmBoxObject> filmBox = store_.find<FilmBoxObject>(uid, associationId_);
+        if (!filmBox) {
+            status = STATUS_N_NoSuchObjectInstance;
+        } else if (auto session = store_.find<FilmSessionObject>(filmBox->filmSessionUID, associationId_)) {
+            auto& boxes = session->children;
+            boxes.erase(std::remove(boxes.begin(), boxes.end(), uid), boxes.end());
+        }
+    } else if (sopClass == UID_PresentationLUTSOPClass) {
+        if (!store_.find<PresentationLutObject>(uid, associationId_)) status = STATUS_N_NoSuchObjectInstance;
+    } else {
+        status = STATUS_N_NoSuchSOPClass;
+    }
+
+    if (status == STATUS_Success) {
+        const size_t erased = store_.eraseTree(uid);
+        LOG_INFO << "✅ حذف " << erased << " كائن";
+    }
+
     T_DIMSE_Message rsp;
     memset(&rsp, 0, sizeof(rsp));
     rsp.CommandField = DIMSE_N_DELETE_RSP;
     rsp.msg.NDeleteRSP.MessageIDBeingRespondedTo = req.MessageID;
-    rsp.msg.NDeleteRSP.DimseStatus = STATUS_Success;
+    rsp.msg.NDeleteRSP.DimseStatus = status;
     rsp.msg.NDeleteRSP.DataSetType = DIMSE_DATASET_NULL;
+    Metrics::instance().dimseResponse("N-DELETE", status);
     return DIMSE_sendMessageUsingMemoryData(currentAssociation_, presID, &rsp, NULL, NULL, NULL, NULL);
 }
 
@@ -386,7 +671,9 @@ OFCondition PrintSCP::handleNDeleteRequest(const T_DIMSE_N_DeleteRQ& req,
 // -----------------------------
 OFCondition PrintSCP::sendNCreateResponse(const T_DIMSE_N_CreateRQ& req,
                                           T_ASC_PresentationContextID presID,
-                                          Uint16 status) {
+                                          Uint16 status,
+                                          const std::string& instanceUID,
+                                          DcmDataset* rspDataset) {
     if (!currentAssociation_) return EC_IllegalCall;
 
     T_DIMSE_Message response;
@@ -394,53 +681,27 @@ OFCondition PrintSCP::sendNCreateResponse(const T_DIMSE_N_CreateRQ& req,
     response.CommandField = DIMSE_N_CREATE_RSP;
     response.msg.NCreateRSP.MessageIDBeingRespondedTo = req.MessageID;
     response.msg.NCreateRSP.DimseStatus = status;
-    response.msg.NCreateRSP.DataSetType = DIMSE_DATASET_NULL;
-
-    // Optional dataset in response
-    DcmDataset* rspDataset = nullptr;
-    if (status == STATUS_Success) {
-        rspDataset = new DcmDataset();
-        rspDataset->putAndInsertString(DCM_NumberOfCopies, "1");
-        rspDataset->putAndInsertString(DCM_PrintPriority, "MED");
-        rspDataset->putAndInsertString(DCM_MediumType, "PAPER");
+    response.msg.NCreateRSP.DataSetType = rspDataset ? DIMSE_DATASET_PRESENT : DIMSE_DATASET_NULL;
+
+    // The SCU learns the assigned instance UID from the response
+    OFStandard::strlcpy(response.msg.NCreateRSP.AffectedSOPClassUID, req.AffectedSOPClassUID,
+                        sizeof(response.msg.NCreateRSP.AffectedSOPClassUID));
+    response.msg.NCreateRSP.opts = O_NCREATE_AFFECTEDSOPCLASSUID;
+    if (!instanceUID.empty()) {
+        OFStandard::strlcpy(response.msg.NCreateRSP.AffectedSOPInstanceUID, instanceUID.c_str(),
+                            sizeof(response.msg.NCreateRSP.AffectedSOPInstanceUID));
+        response.msg.NCreateRSP.opts |= O_NCREATE_AFFECTEDSOPINSTANCEUID;
     }
 
+    Metrics::instance().dimseResponse("N-CREATE", status);
     OFCondition sendCond = DIMSE_sendMessageUsingMemoryData(
         currentAssociation_, presID, &response, NULL, rspDataset, NULL, NULL);
 
-    delete rspDataset;
-
-    if (sendCond.good())
-        std::cout << "✅ تم إرسال رد N-CREATE بنجاح" << std::endl;
-    else
-        std::cerr << "❌ فشل في إرسال رد N-CREATE: " << sendCond.text() << std::endl;
+    if (sendCond.good()) {
+        LOG_DEBUG << "✅ تم إرسال رد N-CREATE بنجاح";
+    } else {
+        LOG_ERROR << "❌ فشل في إرسال رد N-CREATE: " << sendCond.text();
+    }
 
     return sendCond;
 }
-
-// -----------------------------
-// إنشاء جلسة فيلم
-// -----------------------------
-OFCondition PrintSCP::handleFilmSessionCreate() {
-    std::cout << "🎞 معالجة إنشاء جلسة فيلم" << std::endl;
-    std::lock_guard<std::mutex> lock(sessionMutex_);
-    printSessions_["default_session"] = "ACTIVE";
-    std::cout << "✅ إنشاء جلسة طباعة جديدة" << std::endl;
-    return EC_Normal;
-}
-
-// -----------------------------
-// إنشاء صندوق فيلم
-// -----------------------------
-OFCondition PrintSCP::handleFilmBoxCreate() {
-    std::cout << "📦 معالجة إنشاء صندوق فيلم" << std::endl;
-    return EC_Normal;
-}
-
-// -----------------------------
-// إنشاء طابعة
-// -----------------------------
-OFCondition PrintSCP::handlePrinterCreate() {
-    std::cout << "🖨 معالجة إنشاء طابعة" << std::endl;
-    return EC_Normal;
-}
@@ -1,8 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <string>
-#include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
@@ -19,30 +20,44 @@
 #include <dcmtk/dcmdata/dctk.h>
 #include <dcmtk/dcmimgle/dcmimage.h> // لإدارة الصور الطبية DicomImage
 
-// ====================
-// Windows Headers للطباعة
-// ====================
-#ifdef _WIN32
-#include <windows.h>
-#endif
+#include "ServerConfig.h"
+#include "DatasetSpill.h"
+#include "PrintSpooler.h"
+#include "PrintObjectStore.h"
 
 /**
  * @class PrintSCP
  * @brief خادم DICOM Print SCP يتعامل مع أوامر N-CREATE / N-ACTION / N-DELETE
- *        ويحول بيانات DICOM إلى صور يمكن طباعتها عبر طابعة ويندوز.
+ *        ويتحقق من بيانات DICOM ثم يضيفها إلى طابور الطباعة (PrintSpooler).
+ *
+ * كائنات Film Session / Film Box / Image Box / Presentation LUT تُحفظ في مخزن
+ * مشترك (PrintObjectStore) وتُحذف تلقائياً عند انتهاء الاتصال أو عند N-DELETE.
  */
 class PrintSCP {
 private:
-    std::mutex sessionMutex_; ///< قفل لحماية جلسات الطباعة
-    std::map<std::string, std::string> printSessions_; ///< تخزين جلسات الطباعة
+    const ServerConfig& config_; ///< إعدادات الخادم (المهلات...)
+    PrintSpooler& spooler_;      ///< طابور الطباعة المشترك بين الاتصالات
+    PrintObjectStore& store_;    ///< مخزن كائنات الطباعة المشترك بين الاتصالات
     T_ASC_Association* currentAssociation_; ///< الاتصال الحالي مع العميل DICOM
+    unsigned long associationId_;           ///< رقم الاتصال الحالي (ملكية الكائنات)
+    std::string filmSessionUID_;            ///< Film Session الحالية (واحدة لكل اتصال)
+    std::vector<std::string> ownedRoots_;   ///< الكائنات الجذرية التي تُحذف عند انتهاء الاتصال
+    const std::atomic<bool>* stopRequested_; ///< علم إيقاف الخادم (اختياري)
 
 public:
-    PrintSCP();
+    /**
+     * @param config إعدادات الخادم
+     * @param spooler طابور الطباعة الذي تُرسل إليه الصور
+     * @param store مخزن كائنات الطباعة
+     * @param stopRequested علم يضبطه الخادم عند الإيقاف لإنهاء الاتصال الجاري
+     */
+    PrintSCP(const ServerConfig& config, PrintSpooler& spooler, PrintObjectStore& store,
+             const std::atomic<bool>* stopRequested = nullptr);
     virtual ~PrintSCP();
 
     /**
      * @brief معالجة جلسة اتصال DICOM واحدة (Association)
+     *        تنتظر الرسائل على المقبس مباشرة وتغلق الاتصال بعد مهلة الخمول
      * @param assoc مؤشر إلى جلسة الاتصال
      * @return حالة التنفيذ (DCMTK OFCondition)
      */
@@ -61,6 +76,12 @@ protected:
     virtual OFCondition handleNActionRequest(const T_DIMSE_N_ActionRQ& req,
                                              T_ASC_PresentationContextID presID);
 
+    /**
+     * @brief معالجة طلب N-SET (بيانات مربعات الصور)
+     */
+    virtual OFCondition handleNSetRequest(const T_DIMSE_N_SetRQ& req,
+                                          T_ASC_PresentationContextID presID);
+
     /**
      * @brief معالجة طلب N-DELETE (حذف جلسة أو فيلم)
      */
@@ -68,40 +89,93 @@ protected:
                                              T_ASC_PresentationContextID presID);
 
 private:
+    /**
+     * @brief حلقة استقبال أوامر DIMSE حتى نهاية الاتصال
+     */
+    OFCondition serveAssociation(T_ASC_Association* assoc);
+
+    /**
+     * @brief حذف كل كائنات الطباعة التي أنشأها الاتصال الحالي
+     */
+    void releaseOwnedObjects();
+
+    /**
+     * @brief استلام الـ Dataset المرافق للأمر
+     * @param spill إذا لم يكن nullptr وكان التفريغ مفعلاً يُستلم عبر ملف، ويُملأ
+     *        بالملف الذي بقيت فيه بيانات البكسلات (nullptr = كل شيء في الذاكرة)
+     */
+    OFCondition receiveDataset(T_ASC_PresentationContextID presID,
+                               std::unique_ptr<DcmDataset>& dataset,
+                               std::shared_ptr<SpillFile>* spill = nullptr);
+
     /**
      * @brief إنشاء جلسة فيلم جديدة (Film Session)
      */
-    OFCondition handleFilmSessionCreate();
+    Uint16 createFilmSession(const std::string& uid, DcmDataset& dataset,
+                             std::unique_ptr<DcmDataset>& rspDataset);
+
+    /**
+     * @brief إنشاء صندوق فيلم (Film Box) مع مربعات الصور حسب تنسيق العرض
+     */
+    Uint16 createFilmBox(const std::string& uid, DcmDataset& dataset,
+                         T_ASC_PresentationContextID presID,
+                         std::unique_ptr<DcmDataset>& rspDataset);
 
     /**
-     * @brief إنشاء صندوق فيلم (Film Box)
+     * @brief إنشاء Presentation LUT
      */
-    OFCondition handleFilmBoxCreate();
+    Uint16 createPresentationLut(const std::string& uid, DcmDataset& dataset);
 
     /**
-     * @brief إنشاء طابعة (Printer Instance)
+     * @brief حفظ بيانات Image Box كما استُلمت؛ فك الترميز يتأخر حتى الطباعة
      */
-    OFCondition handlePrinterCreate();
+    Uint16 setImageBox(ImageBoxObject& imageBox, DcmDataset& dataset,
+                       const std::shared_ptr<SpillFile>& spill);
+
+    /**
+     * @brief تجهيز صفحة المهمة من Film Box ومربعاته
+     * @return false إذا كانت كل المربعات فارغة
+     */
+    bool buildFilmPage(const FilmBoxObject& filmBox, FilmPage& page);
+
+    /**
+     * @brief نقل النسخ والأولوية و Medium Type من Film Session إلى المهمة
+     */
+    void applySession(const FilmSessionObject& session, PrintJob& job);
 
     /**
      * @brief إرسال رد N-CREATE إلى الجهاز المرسل
      */
     OFCondition sendNCreateResponse(const T_DIMSE_N_CreateRQ& req,
                                     T_ASC_PresentationContextID presID,
-                                    Uint16 status);
-
-    /**
-     * @brief دالة إرسال الصورة إلى طابعة النظام (Windows Printer)
-     * 
-     * @param buffer بيانات الصورة (8bit أو 24bit)
-     * @param width عرض الصورة
-     * @param height ارتفاع الصورة
-     * @param printerName اسم الطابعة المستهدفة (افتراضي الطابعة الافتراضية)
-     * @param bitsPerPixel عمق البت (8 = رمادي، 24 = ملون)
-     */
-    bool sendToPrinter(const Uint8* buffer,
-                       unsigned long width,
-                       unsigned long height,
-                       const std::string& printerName = "",
-                       int bitsPerPixel = 8);
+                                    Uint16 status,
+                                    const std::string& instanceUID,
+                                    DcmDataset* rspDataset);
+
+    /**
+     * @brief إرسال رد N-ACTION مع مرجع مهمة الطباعة (Print Job) عند النجاح
+     */
+    OFCondition sendNActionResponse(const T_DIMSE_N_ActionRQ& req,
+                                    T_ASC_PresentationContextID presID,
+                                    Uint16 status,
+                                    const std::string& jobUID);
+
+    /**
+     * @brief تحقق سريع من وجود بيانات صورة قابلة للطباعة (بدون فك الترميز)
+     */
+    bool isPrintableDataset(DcmItem& dataset);
+
+    /**
+     * @brief إضافة صورة مفردة (المسار القديم بدون Film Box) إلى طابور الطباعة
+     *        تنتقل ملكية dataset إلى المهمة
+     * @param jobUID يُملأ بـ Print Job UID عند النجاح
+     * @return حالة DIMSE للرد
+     */
+    Uint16 enqueuePrintJob(DcmDataset* dataset, const std::shared_ptr<SpillFile>& spill,
+                           std::string& jobUID);
+
+    /**
+     * @brief إضافة مهمة جاهزة (صفحات Film Box) إلى طابور الطباعة
+     */
+    Uint16 submitJob(std::unique_ptr<PrintJob> job, std::string& jobUID);
 };
@@ -0,0 +1,152 @@
+// PrintScheduler.cpp
+#include "PrintScheduler.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include <limits>
+
+namespace {
+
+// Empty list = any value; "PREFIX*" matches by prefix
+bool matches(const std::vector<std::string>& patterns, const std::string& value) {
+    if (patterns.empty()) return true;
+    for (const std::string& pattern : patterns) {
+        if (!pattern.empty() && pattern.back() == '*') {
+            if (value.compare(0, pattern.size() - 1, pattern, 0, pattern.size() - 1) == 0) return true;
+        } else if (pattern == value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool accepts(const PrinterRoute& route, const PrintJob& job) {
+    if (!matches(route.callingAETitles, job.callingAE)) return false;
+    if (!job.mediumType.empty() && !matches(route.mediumTypes, job.mediumType)) return false;
+    for (const FilmPage& page : job.pages) {
+        if (!matches(route.filmSizes, page.film.filmSizeID)) return false;
+    }
+    return true;
+}
+
+// Prometheus label values escape backslashes (UNC printer names) and quotes
+std::string printerLabel(const std::string& name) {
+    std::string label = "printer=\"";
+    for (char c : name) {
+        if (c == '\\' || c == '"') label += '\\';
+        label += c;
+    }
+    label += '"';
+    return label;
+}
+
+} // namespace
+
+PrintPriority parsePrintPriority(const std::string& value) {
+    if (value == "HIGH") return PrintPriority::High;
+    if (value == "LOW") return PrintPriority::Low;
+    return PrintPriority::Med;
+}
+
+// -----------------------------
+// PrintScheduler Implementation
+// -----------------------------
+PrintScheduler::PrintScheduler(const ServerConfig& config)
+    : aging_(std::chrono::seconds(config.priorityAgingSec)) {
+    for (const PrinterRoute& route : config.printers) {
+        Printer printer;
+        printer.route = route;
+        printers_.push_back(printer);
+    }
+    // Without a configured pool every job goes to the default printer
+    if (printers_.empty()) printers_.push_back(Printer());
+}
+
+bool PrintScheduler::route(PrintJob& job) const {
+    size_t best = printers_.size();
+    double bestLoad = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < printers_.size(); ++i) {
+        const Printer& printer = printers_[i];
+        if (!accepts(printer.route, job)) continue;
+
+        // Minutes until this job would be done; without a speed, sheets waiting
+        const double speed = printer.route.pagesPerMinute ? printer.route.pagesPerMinute : 1.0;
+        const double load = (printer.queuedSheets + printer.activeSheets + job.sheets()) / speed;
+        if (load < bestLoad) {
+            bestLoad = load;
+            best = i;
+        }
+    }
+    if (best == printers_.size()) {
+        LOG_WARN << "⛔ No printer accepts job #" << job.id << " (AE " << job.callingAE << ", medium "
+                 << job.mediumType << ", film " << (job.pages.empty() ? "" : job.pages[0].film.filmSizeID)
+                 << ")";
+        return false;
+    }
+    job.printerIndex = best;
+    job.printerName = printers_[best].route.name;
+    return true;
+}
+
+void PrintScheduler::push(std::unique_ptr<PrintJob> job) {
+    Printer& printer = printers_[job->printerIndex];
+    printer.queuedSheets += job->sheets();
+    ++printer.queuedJobs;
+    queue_.push_back(std::move(job));
+}
+
+double PrintScheduler::effectivePriority(const PrintJob& job, std::chrono::steady_clock::time_point now) const {
+    double priority = (double)job.priority;
+    if (aging_.count() > 0)
+        priority += std::chrono::duration<double>(now - job.enqueuedAt) / aging_;
+    return priority;
+}
+
+std::unique_ptr<PrintJob> PrintScheduler::pop() {
+    if (queue_.empty()) return nullptr;
+
+    // The queue is in arrival order, so strict > keeps the oldest among equals
+    const auto now = std::chrono::steady_clock::now();
+    size_t best = 0;
+    double bestPriority = effectivePriority(*queue_[0], now);
+    for (size_t i = 1; i < queue_.size(); ++i) {
+        const double priority = effectivePriority(*queue_[i], now);
+        if (priority > bestPriority) {
+            bestPriority = priority;
+            best = i;
+        }
+    }
+
+    std::unique_ptr<PrintJob> job = std::move(queue_[best]);
+    queue_.erase(queue_.begin() + best);
+    Printer& printer = printers_[job->printerIndex];
+    printer.queuedSheets -= job->sheets();
+    printer.activeSheets += job->sheets();
+    --printer.queuedJobs;
+    if (best != 0) {
+        LOG_DEBUG << "🔀 Job #" << job->id << " (priority " << (int)job->priority << ") ahead of "
+                  << best << " earlier jobs";
+    }
+    return job;
+}
+
+void PrintScheduler::finished(const PrintJob& job) {
+    Printer& printer = printers_[job.printerIndex];
+    printer.activeSheets -= job.sheets();
+    printer.printedSheets += job.sheets();
+}
+
+void PrintScheduler::appendMetrics(std::string& out) const {
+    appendHeader(out, "dicom_print_printer_queued_jobs", "gauge", "Jobs waiting for each printer.");
+    for (const Printer& printer : printers_)
+        appendSample(out, "dicom_print_printer_queued_jobs", printerLabel(printer.route.name),
+                     (double)printer.queuedJobs);
+    appendHeader(out, "dicom_print_printer_pending_sheets", "gauge",
+                 "Sheets queued or printing on each printer.");
+    for (const Printer& printer : printers_)
+        appendSample(out, "dicom_print_printer_pending_sheets", printerLabel(printer.route.name),
+                     (double)(printer.queuedSheets + printer.activeSheets));
+    appendHeader(out, "dicom_print_printer_sheets_total", "counter", "Sheets sent to each printer.");
+    for (const Printer& printer : printers_)
+        appendSample(out, "dicom_print_printer_sheets_total", printerLabel(printer.route.name),
+                     (double)printer.printedSheets);
+}
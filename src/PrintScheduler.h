@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ServerConfig.h"
+#include "PrintJob.h"
+
+/**
+ * @class PrintScheduler
+ * @brief توجيه المهام إلى الطابعات المعرفة وترتيب سحبها حسب الأولوية
+ *
+ * كل مهمة تذهب إلى أقل طابعة حملاً من الطابعات التي تقبل عنوان AE المرسل
+ * و Medium Type و Film Size الخاصة بها. الحمل هو الأوراق المنتظرة والجارية
+ * مقسومة على سرعة الطابعة (صفحة/دقيقة). العمال يسحبون المهمة ذات الأولوية
+ * الأعلى (HIGH > MED > LOW)، وكل فترة تقادم تنتظرها المهمة ترفعها درجة حتى
+ * لا تبقى المهام المنخفضة منتظرة للأبد.
+ *
+ * غير آمن للخيوط: PrintSpooler يستدعيه تحت قفل الطابور.
+ */
+class PrintScheduler {
+private:
+    struct Printer {
+        PrinterRoute route;
+        unsigned long queuedSheets = 0;  ///< أوراق المهام المنتظرة
+        unsigned long activeSheets = 0;  ///< أوراق المهام قيد الطباعة
+        unsigned long queuedJobs = 0;
+        unsigned long printedSheets = 0;
+    };
+
+    std::vector<Printer> printers_;
+    std::vector<std::unique_ptr<PrintJob>> queue_; ///< بترتيب الوصول
+    std::chrono::steady_clock::duration aging_;    ///< صفر = بدون تقادم
+
+public:
+    explicit PrintScheduler(const ServerConfig& config);
+
+    /**
+     * @brief اختيار الطابعة للمهمة (يضبط printerName و printerIndex)
+     * @return false إذا لم تقبلها أي طابعة
+     */
+    bool route(PrintJob& job) const;
+
+    /**
+     * @brief إضافة مهمة موجهة إلى الطابور
+     */
+    void push(std::unique_ptr<PrintJob> job);
+
+    /**
+     * @brief سحب المهمة ذات الأولوية الفعلية الأعلى (الأقدم عند التساوي)
+     */
+    std::unique_ptr<PrintJob> pop();
+
+    /**
+     * @brief تحرير حمل مهمة انتهت طباعتها
+     */
+    void finished(const PrintJob& job);
+
+    size_t size() const { return queue_.size(); }
+    bool empty() const { return queue_.empty(); }
+
+    /**
+     * @brief حمل كل طابعة بصيغة Prometheus
+     */
+    void appendMetrics(std::string& out) const;
+
+private:
+    double effectivePriority(const PrintJob& job, std::chrono::steady_clock::time_point now) const;
+};
@@ -0,0 +1,387 @@
+// PrintSpooler.cpp
+#include "PrintSpooler.h"
+#include "Logger.h"
+#include "BufferPool.h"
+#include "Metrics.h"
+#include "PageBuffer.h"
+#include "PixelKernels.h"
+
+#include <algorithm>
+#include <functional>
+
+#include <dcmtk/dcmdata/dctk.h>
+
+namespace {
+
+// Idle workers hand back buffer classes that no job used for a while
+const auto kPoolTrimInterval = std::chrono::seconds(10);
+const auto kPoolIdleAge = std::chrono::seconds(30);
+
+double elapsedMs(std::chrono::steady_clock::time_point from,
+                 std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+struct ImageSize {
+    size_t width = 0;
+    size_t height = 0;
+    size_t samples = 1;
+    size_t bytesPerSample = 1;
+    size_t frames = 1;
+};
+
+// A dataset still held by its image box (or another job) is copied before the
+// job rewrites it; one the job holds alone is used as is
+DcmDataset* writableDataset(PageImage& image) {
+    if (image.dataset.use_count() > 1) image.dataset = std::make_shared<DcmDataset>(*image.dataset);
+    return image.dataset.get();
+}
+
+bool readImageSize(DcmDataset& dataset, ImageSize& size) {
+    Uint16 rows = 0, columns = 0, samples = 1, bitsAllocated = 8;
+    if (dataset.findAndGetUint16(DCM_Rows, rows).bad() || dataset.findAndGetUint16(DCM_Columns, columns).bad())
+        return false;
+    dataset.findAndGetUint16(DCM_SamplesPerPixel, samples);
+    dataset.findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+    Sint32 frames = 1;
+    dataset.findAndGetSint32(DCM_NumberOfFrames, frames);
+    size.width = columns;
+    size.height = rows;
+    size.samples = samples ? samples : 1;
+    size.bytesPerSample = bitsAllocated > 8 ? 2 : 1;
+    size.frames = frames > 0 ? (size_t)frames : 1;
+    return true;
+}
+
+} // namespace
+
+// -----------------------------
+// PrintSpooler Implementation
+// -----------------------------
+PrintSpooler::PrintSpooler(const ServerConfig& config)
+    : config_(config), renderPool_(config.renderThreads),
+      decoder_(renderPool_, (size_t)config.decodeMemoryMB * 1024 * 1024,
+               (size_t)config.decodeAheadMB * 1024 * 1024),
+      compositor_(renderPool_, config.printerDpi),
+      pageCache_((size_t)config.pageCacheMB * 1024 * 1024), scheduler_(config), waitingForMemory_(0),
+      stopping_(false),
+      nextJobId_(1) {
+}
+
+PrintSpooler::~PrintSpooler() {
+    stop();
+}
+
+bool PrintSpooler::start() {
+    if (!backend_) backend_ = createOutputBackend(config_, &renderPool_);
+    if (!backend_) return false;
+
+    BufferPool::instance().setBudget((size_t)config_.memoryBudgetMB * 1024 * 1024);
+    BufferPool::instance().setIdleLimit((size_t)config_.poolIdleMB * 1024 * 1024);
+
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    stopping_ = false;
+    for (unsigned i = 0; i < config_.spoolWorkers; ++i)
+        workers_.emplace_back(&PrintSpooler::workerLoop, this, i);
+    LOG_INFO << "🖨 Print spooler: " << config_.spoolWorkers << " workers, queue depth "
+             << config_.spoolQueueDepth << ", " << renderPool_.size() << " render threads @ "
+             << config_.printerDpi << " dpi, pixel kernels " << PixelKernels::activeIsaName()
+             << ", memory budget "
+             << (config_.memoryBudgetMB ? std::to_string(config_.memoryBudgetMB) + " MB" : "off");
+    return true;
+}
+
+void PrintSpooler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (stopping_ && workers_.empty()) return;
+        stopping_ = true;
+    }
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    workers_.clear();
+}
+
+std::unique_ptr<PrintJob> PrintSpooler::createJob() {
+    std::unique_ptr<PrintJob> job(new PrintJob());
+    job->id = nextJobId_++;
+    char uid[100];
+    dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT);
+    job->jobUID = uid;
+    return job;
+}
+
+SubmitResult PrintSpooler::submit(std::unique_ptr<PrintJob> job) {
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    if (!scheduler_.route(*job)) {
+        Metrics::instance().jobRejected();
+        return SubmitResult::NoPrinter;
+    }
+
+    // Backpressure: wait a bounded time for a free slot, then give up so the
+    // association thread can answer with "print queue full".
+    const bool hasRoom = notFull_.wait_for(lock,
+        std::chrono::milliseconds(config_.spoolSubmitTimeoutMs),
+        [this] { return stopping_ || scheduler_.size() + waitingForMemory_ < config_.spoolQueueDepth; });
+    if (!hasRoom || stopping_) {
+        LOG_WARN << "⛔ Print queue full (" << scheduler_.size() + waitingForMemory_ << "), job #" << job->id
+                 << " rejected";
+        Metrics::instance().jobRejected();
+        return SubmitResult::QueueFull;
+    }
+
+    // Routed again: the load on the printers may have changed while waiting for room
+    scheduler_.route(*job);
+    job->enqueuedAt = std::chrono::steady_clock::now();
+    LOG_INFO << "📥 Job #" << job->id << " queued for "
+             << (job->printerName.empty() ? std::string("default printer") : job->printerName) << " (depth "
+             << scheduler_.size() + waitingForMemory_ + 1 << ")";
+    scheduler_.push(std::move(job));
+    lock.unlock();
+    notEmpty_.notify_one();
+    Metrics::instance().jobSubmitted();
+    return SubmitResult::Queued;
+}
+
+std::shared_ptr<DecodeAhead> PrintSpooler::decodeAhead(const std::shared_ptr<DcmDataset>& image) {
+    PixelDecoder::KeyFunction key;
+    if (pageCache_.enabled()) key = imageCacheKey;
+    return decoder_.decodeAhead(image, key);
+}
+
+size_t PrintSpooler::queueDepth() const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return scheduler_.size() + waitingForMemory_;
+}
+
+void PrintSpooler::appendMetrics(std::string& out) {
+    appendMetric(out, "dicom_print_spool_queue_depth", "gauge", "Print jobs waiting in the spool queue.",
+                 (double)queueDepth());
+    appendMetric(out, "dicom_print_page_cache_hits_total", "counter", "Rendered page cache hits.",
+                 (double)pageCache_.hits());
+    appendMetric(out, "dicom_print_page_cache_misses_total", "counter", "Rendered page cache misses.",
+                 (double)pageCache_.misses());
+    appendMetric(out, "dicom_print_page_cache_evictions_total", "counter", "Rendered page cache evictions.",
+                 (double)pageCache_.evictions());
+    appendMetric(out, "dicom_print_page_cache_bytes", "gauge", "Bytes held by the rendered page cache.",
+                 (double)pageCache_.usedBytes());
+    appendMetric(out, "dicom_print_lut_cache_hits_total", "counter", "Grayscale LUT cache hits.",
+                 (double)compositor_.lutCache().hits());
+    appendMetric(out, "dicom_print_lut_cache_misses_total", "counter", "Grayscale LUT cache misses.",
+                 (double)compositor_.lutCache().misses());
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        scheduler_.appendMetrics(out);
+    }
+    BufferPool::instance().appendMetrics(out);
+    if (backend_) backend_->appendMetrics(out);
+}
+
+void PrintSpooler::workerLoop(unsigned workerId) {
+    while (true) {
+        std::unique_ptr<PrintJob> job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            while (!stopping_ && scheduler_.empty()) {
+                if (notEmpty_.wait_for(lock, kPoolTrimInterval) == std::cv_status::timeout) {
+                    lock.unlock();
+                    BufferPool::instance().trimIdle(kPoolIdleAge);
+                    lock.lock();
+                }
+            }
+            // Drain what is left before exiting so accepted jobs still print
+            if (scheduler_.empty()) return;
+            job = scheduler_.pop();
+            ++waitingForMemory_;
+        }
+
+        LogContext context;
+        context.jobId = job->id;
+        LogScope scope(context);
+
+        // Wait for room in the memory budget before allocating anything; the job
+        // keeps its queue slot meanwhile so backpressure still reaches the senders
+        const size_t estimate = estimateJobMemory(*job);
+        const auto reserveStart = std::chrono::steady_clock::now();
+        BufferPool::Reservation memory = BufferPool::instance().reserve(estimate);
+        const double memoryWaitMs = elapsedMs(reserveStart, std::chrono::steady_clock::now());
+        if (memory.bytes() && memory.bytes() < estimate) {
+            LOG_WARN << "⚠️ Job #" << job->id << " needs about " << estimate / (1024 * 1024)
+                     << " MB, more than the whole memory budget; it runs alone with "
+                     << memory.bytes() / (1024 * 1024) << " MB reserved";
+        }
+        if (memoryWaitMs >= 1.0) {
+            LOG_INFO << "⏳ Job #" << job->id << " waited " << memoryWaitMs << " ms for "
+                     << estimate / (1024 * 1024) << " MB of memory budget";
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            --waitingForMemory_;
+        }
+        notFull_.notify_one();
+
+        const auto started = std::chrono::steady_clock::now();
+        const bool ok = processJob(*job);
+        const auto finished = std::chrono::steady_clock::now();
+        Metrics::instance().jobFinished(ok);
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            scheduler_.finished(*job);
+        }
+
+        LOG_INFO << (ok ? "✅" : "❌") << " Job #" << job->id << " (worker " << workerId << ")"
+                 << " wait " << elapsedMs(job->enqueuedAt, started) << " ms,"
+                 << " process " << elapsedMs(started, finished) << " ms";
+    }
+}
+
+size_t PrintSpooler::estimateJobMemory(const PrintJob& job) const {
+    size_t pageBytes = 0;
+    size_t decodedBytes = 0;
+    std::vector<size_t> tileBytes;
+
+    for (const FilmPage& film : job.pages) {
+        FilmLayout layout;
+        if (!computeFilmLayout(film.film, config_.printerDpi, layout)) continue;
+
+        bool color = false;
+        for (size_t i = 0; i < film.images.size(); ++i) {
+            ImageSize size;
+            if (!film.images[i].dataset || !readImageSize(*film.images[i].dataset, size)) continue;
+            color = color || size.samples == 3;
+
+            const size_t frameBytes = size.width * size.height * size.samples * size.bytesPerSample;
+            decodedBytes += frameBytes * size.frames;
+
+            // Decoded frame + 8-bit display copy + fitted tile + resampler intermediate
+            const size_t tileWidth = i < layout.tiles.size() ? layout.tiles[i].width : size.width;
+            const size_t tileHeight = i < layout.tiles.size() ? layout.tiles[i].height : size.height;
+            tileBytes.push_back(frameBytes + size.width * size.height * size.samples +
+                                tileWidth * tileHeight * size.samples +
+                                tileWidth * size.height * size.samples * sizeof(Sint16));
+        }
+        // One page buffer is reused for the whole job, so only the largest counts
+        pageBytes = std::max(pageBytes, (size_t)layout.pageWidth * layout.pageHeight * (color ? 3 : 1));
+    }
+
+    // Only as many tiles as there are render threads (plus the caller) are in flight at once
+    const size_t inFlight = std::min(tileBytes.size(), (size_t)renderPool_.size() + 1);
+    std::partial_sort(tileBytes.begin(), tileBytes.begin() + inFlight, tileBytes.end(), std::greater<size_t>());
+    size_t scratchBytes = 0;
+    for (size_t i = 0; i < inFlight; ++i) scratchBytes += tileBytes[i];
+
+    return pageBytes + std::min(decodedBytes, (size_t)config_.decodeMemoryMB * 1024 * 1024) + scratchBytes;
+}
+
+// -----------------------------
+// Render + print
+// -----------------------------
+bool PrintSpooler::processJob(PrintJob& job) {
+    const RasterLayout layout = backend_->preferredLayout();
+
+    // Content keys come from the pixel data as received, so they are taken before decoding
+    std::vector<PageCache::PagePtr> cached(job.pages.size());
+    std::vector<std::string> keys(job.pages.size());
+    std::vector<bool> cacheable(job.pages.size(), false);
+    if (pageCache_.enabled()) {
+        for (size_t p = 0; p < job.pages.size(); ++p) {
+            // Keying at print time loads spilled pixel data, so that is done on a copy;
+            // in-memory images are only read
+            for (PageImage& image : job.pages[p].images) {
+                if (image.dataset && image.cacheKey.empty() && image.spill) writableDataset(image);
+            }
+            const FilmPage& film = job.pages[p];
+            cacheable[p] = pageCacheKey(film.film, film.images, config_.printerDpi, layout, keys[p]);
+            if (cacheable[p]) cached[p] = pageCache_.find(keys[p]);
+        }
+    }
+
+    // Decode every image box of the pages still to render, in parallel, before composing.
+    // Images decode-ahead already finished are shared read-only with their image box;
+    // the rest are rewritten here or by the renderer, so the job takes its own copy.
+    // Spilled images are copied too: rendering loads their pixel data into the dataset,
+    // which would keep it in the image box for the rest of the association.
+    std::vector<DcmDataset*> datasets;
+    for (size_t p = 0; p < job.pages.size(); ++p) {
+        if (cached[p]) continue;
+        for (PageImage& image : job.pages[p].images) {
+            if (!image.dataset) continue;
+            if (image.spill) writableDataset(image);
+            if (needsDecode(*image.dataset)) datasets.push_back(writableDataset(image));
+        }
+    }
+    decoder_.decodeAll(datasets);
+
+    // All pages and copies of the job go out as one document. It is opened once the
+    // first page is ready: opening takes the device (its lock, a socket connection),
+    // and holding it through composition would serialize the rendering of every job
+    // for that device and leave a printer connection idle meanwhile
+    PageInfo documentInfo;
+    documentInfo.printerName = job.printerName;
+    documentInfo.jobId = job.id;
+    documentInfo.dpi = config_.printerDpi;
+    std::unique_ptr<OutputDocument> document;
+    auto startDocument = [&]() {
+        if (!document) document = backend_->openDocument(documentInfo);
+        if (!document)
+            LOG_ERROR << "❌ " << backend_->name() << " output could not start a document for job #" << job.id;
+        return document != nullptr;
+    };
+
+    PageBuffer page; // reused across the pages of the job
+    unsigned pageNumber = 0;
+
+    for (size_t p = 0; p < job.pages.size(); ++p) {
+        const auto renderStart = std::chrono::steady_clock::now();
+
+        // A cache hit goes straight to the backend; otherwise compose all image boxes
+        // into one page laid out the way the backend wants it
+        PageRaster raster;
+        if (cached[p]) {
+            raster = cached[p]->raster();
+        } else {
+            const FilmPage& film = job.pages[p];
+            if (!compositor_.compose(film.film, film.images, layout, page))
+                return false;
+            if (cacheable[p]) pageCache_.insert(keys[p], page);
+            raster = page.raster();
+        }
+
+        PageInfo info = documentInfo;
+        const auto spoolStart = std::chrono::steady_clock::now();
+        if (!startDocument()) return false;
+        for (unsigned copy = 0; copy < job.copies; ++copy) {
+            info.pageNumber = ++pageNumber;
+            StageTimer timer(Stage::Spool);
+            if (!document->printPage(raster, info)) {
+                LOG_ERROR << "❌ " << backend_->name() << " output failed for job #" << job.id
+                          << " page " << info.pageNumber;
+                return false;
+            }
+        }
+        const auto spoolEnd = std::chrono::steady_clock::now();
+
+        LOG_INFO << "⏱ Job #" << job.id << " page " << p + 1 << "/" << job.pages.size()
+                 << (cached[p] ? ": cached " : ": render ") << elapsedMs(renderStart, spoolStart)
+                 << " ms, spool " << elapsedMs(spoolStart, spoolEnd) << " ms";
+    }
+
+    {
+        StageTimer timer(Stage::Spool);
+        if (!startDocument()) return false;
+        if (!document->finish()) {
+            LOG_ERROR << "❌ " << backend_->name() << " output could not finish job #" << job.id;
+            return false;
+        }
+    }
+
+    if (pageCache_.enabled()) {
+        LOG_INFO << "🗃 Page cache: " << pageCache_.hits() << " hits, " << pageCache_.misses() << " misses, "
+                 << pageCache_.evictions() << " evictions, " << pageCache_.usedBytes() / (1024 * 1024)
+                 << "/" << pageCache_.capacityBytes() / (1024 * 1024) << " MB";
+    }
+    return true;
+}
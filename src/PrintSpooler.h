@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcdatset.h>
+
+#include "ServerConfig.h"
+#include "OutputBackend.h"
+#include "FilmLayout.h"
+#include "FilmCompositor.h"
+#include "PageCache.h"
+#include "PixelDecoder.h"
+#include "PrintScheduler.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief نتيجة إضافة مهمة إلى الطابور
+ */
+enum class SubmitResult {
+    Queued,
+    QueueFull,    ///< بقي الطابور ممتلئاً طوال المهلة أو كان متوقفاً
+    NoPrinter     ///< لا توجد طابعة تقبل المهمة (AE / Medium / Film Size)
+};
+
+/**
+ * @class PrintSpooler
+ * @brief طابور طباعة غير متزامن يفصل تحويل الصور والطباعة عن ردود DIMSE.
+ *
+ * المعالِج يتحقق من البيانات ويضيف المهمة ثم يرد فوراً، بينما تقوم خيوط
+ * العرض/الطباعة بسحب المهام من الطابور. عند امتلاء الطابور ينتظر الإدخال
+ * مدة محدودة (backpressure) ثم يفشل بدلاً من تعطيل الاتصال.
+ */
+class PrintSpooler {
+private:
+    const ServerConfig& config_;
+    std::unique_ptr<OutputBackend> backend_;    ///< مخرج الصفحات (GDI / ملفات / stream / null)
+    ThreadPool renderPool_;                     ///< خيوط عرض المربعات المشتركة بين كل المهام
+    PixelDecoder decoder_;                      ///< فك ضغط صور المهمة بالتوازي قبل التركيب
+    FilmCompositor compositor_;                 ///< تركيب صفحة Film Box من مربعاتها
+    PageCache pageCache_;                       ///< الصفحات المركبة سابقاً لإعادة الطباعة
+
+    mutable std::mutex queueMutex_;             ///< قفل لحماية الطابور
+    std::condition_variable notEmpty_;          ///< إشعار العمال بوجود مهمة
+    std::condition_variable notFull_;           ///< إشعار المرسلين بتوفر مكان
+    PrintScheduler scheduler_;                  ///< المهام المنتظرة وتوجيهها إلى الطابعات
+    size_t waitingForMemory_;                   ///< مهام سُحبت وتنتظر حد الذاكرة (تُحسب في عمق الطابور)
+    std::vector<std::thread> workers_;          ///< خيوط العرض والطباعة
+    bool stopping_;                             ///< طلب الإيقاف (بعد تفريغ الطابور)
+    std::atomic<unsigned long> nextJobId_;      ///< عداد أرقام المهام
+
+public:
+    explicit PrintSpooler(const ServerConfig& config);
+    ~PrintSpooler();
+
+    PrintSpooler(const PrintSpooler&) = delete;
+    PrintSpooler& operator=(const PrintSpooler&) = delete;
+
+    /**
+     * @brief تشغيل خيوط العرض/الطباعة
+     * @return false إذا تعذر إنشاء مخرج الصفحات المحدد في الإعدادات
+     */
+    bool start();
+
+    /**
+     * @brief إيقاف الطابور بعد طباعة المهام المتبقية
+     */
+    void stop();
+
+    /**
+     * @brief إنشاء مهمة جديدة برقم و Print Job UID فريدين
+     */
+    std::unique_ptr<PrintJob> createJob();
+
+    /**
+     * @brief توجيه المهمة إلى طابعة وإضافتها إلى الطابور
+     */
+    SubmitResult submit(std::unique_ptr<PrintJob> job);
+
+    /**
+     * @brief بدء فك ضغط صورة Image Box في خيوط العرض أثناء استلام المربع التالي
+     *
+     * مع ذاكرة الصفحات يُحسب مفتاح الصورة في نفس المهمة قبل الفك.
+     * @return nullptr إذا لم يكن هناك ما يُفك أو امتلأ حد الفك المسبق
+     */
+    std::shared_ptr<DecodeAhead> decodeAhead(const std::shared_ptr<DcmDataset>& image);
+
+    /**
+     * @brief عدد المهام المنتظرة حالياً (في الطابور أو في انتظار حد الذاكرة)
+     */
+    size_t queueDepth() const;
+
+    /**
+     * @brief ذاكرة الصفحات المركبة (عدادات التطابق والإخراج)
+     */
+    const PageCache& pageCache() const { return pageCache_; }
+
+    /**
+     * @brief مقاييس الطابور وذاكرات الصفحات والجداول بصيغة Prometheus
+     */
+    void appendMetrics(std::string& out);
+
+private:
+    /**
+     * @brief حلقة خيط العرض/الطباعة
+     */
+    void workerLoop(unsigned workerId);
+
+    /**
+     * @brief تقدير ذروة ذاكرة العرض للمهمة: الصفحة + الإطارات المفكوكة + مخازن
+     *        المربعات التي تُعرض في نفس الوقت
+     */
+    size_t estimateJobMemory(const PrintJob& job) const;
+
+    /**
+     * @brief تركيب صفحات Film Box وإرسالها إلى مخرج الصفحات
+     */
+    bool processJob(PrintJob& job);
+};
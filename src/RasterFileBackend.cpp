@@ -0,0 +1,84 @@
+// RasterFileBackend.cpp
+#include "RasterFileBackend.h"
+#include "Logger.h"
+#include "PixelKernels.h"
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+
+RasterFileBackend::RasterFileBackend(const std::string& directory, const std::string& format)
+    : directory_(directory), format_(format) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec)
+        LOG_ERROR << "❌ Cannot create spool directory " << directory_ << ": " << ec.message();
+}
+
+std::string RasterFileBackend::pagePath(const PageInfo& info, const char* extension) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "job%06lu_p%03u.%s", info.jobId, info.pageNumber, extension);
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+bool RasterFileBackend::printPage(const PageRaster& page, const PageInfo& info) {
+    if (!page.data || (page.bitsPerPixel != 8 && page.bitsPerPixel != 24)) {
+        LOG_ERROR << "❌ Unsupported page raster for file output";
+        return false;
+    }
+
+    const bool raw = (format_ == "raw");
+    const char* extension = raw ? "raw" : (page.bitsPerPixel == 8 ? "pgm" : "ppm");
+    const std::string path = pagePath(info, extension);
+
+    // Write to a temporary name and rename, so spool readers never see half a page
+    const std::string tmpPath = path + ".part";
+    std::FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR << "❌ Cannot open " << tmpPath << " for writing";
+        return false;
+    }
+
+    bool ok = true;
+    if (!raw) {
+        // Binary PGM (P5) for gray, PPM (P6) for RGB
+        ok = std::fprintf(file, "%s\n%lu %lu\n255\n",
+                          page.bitsPerPixel == 8 ? "P5" : "P6", page.width, page.height) > 0;
+    }
+
+    const size_t rowBytes = page.rowBytes();
+    if (page.bitsPerPixel == 24 && page.bgr) {
+        // PPM is RGB; swap one row at a time through a small scratch row
+        std::vector<Uint8> row(rowBytes);
+        for (unsigned long y = 0; ok && y < page.height; ++y) {
+            PixelKernels::swizzleRGBtoBGR(page.data + y * page.stride, rowBytes, row.data(), rowBytes, page.width, 1);
+            ok = std::fwrite(row.data(), 1, rowBytes, file) == rowBytes;
+        }
+    } else if (ok && page.stride == rowBytes) {
+        ok = std::fwrite(page.data, rowBytes, page.height, file) == page.height;
+    } else {
+        for (unsigned long y = 0; ok && y < page.height; ++y)
+            ok = std::fwrite(page.data + y * page.stride, 1, rowBytes, file) == rowBytes;
+    }
+    ok = (std::fclose(file) == 0) && ok;
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmpPath, path, ec);
+    if (!ok || ec) {
+        LOG_ERROR << "❌ Failed to write page " << path;
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+
+    if (raw) {
+        // Sidecar with the geometry, raw files carry no header
+        std::FILE* meta = std::fopen(pagePath(info, "txt").c_str(), "w");
+        if (meta) {
+            std::fprintf(meta, "width=%lu\nheight=%lu\nbits=%d\n", page.width, page.height, page.bitsPerPixel);
+            std::fclose(meta);
+        }
+    }
+
+    LOG_INFO << "💾 Page written: " << path;
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+#include "OutputBackend.h"
+
+/**
+ * @class RasterFileBackend
+ * @brief كتابة الصفحات كملفات PGM/PPM أو RAW داخل مجلد التخزين المؤقت (Spool)
+ *
+ * يعمل على لينكس وويندوز، ويسمح بتشغيل خط الطباعة كاملاً دون طابعة فعلية.
+ * ملفات RAW تُكتب أسطراً متتالية بدون حشو ويُرفق بها ملف .txt بالأبعاد.
+ */
+class RasterFileBackend : public OutputBackend {
+private:
+    std::string directory_; ///< مجلد كتابة الصفحات
+    std::string format_;    ///< "pnm" أو "raw"
+
+public:
+    RasterFileBackend(const std::string& directory, const std::string& format);
+
+    const char* name() const override { return "file"; }
+    bool printPage(const PageRaster& page, const PageInfo& info) override;
+
+private:
+    /**
+     * @brief بناء اسم الملف: job<id>_p<page>.<ext>
+     */
+    std::string pagePath(const PageInfo& info, const char* extension) const;
+};
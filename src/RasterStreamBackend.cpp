@@ -0,0 +1,718 @@
+// RasterStreamBackend.cpp
+#include "RasterStreamBackend.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "PixelKernels.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+#define CLOSE_SOCKET closesocket
+#define SHUTDOWN_SEND SD_SEND
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/file.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define INVALID_SOCKET (-1)
+#define CLOSE_SOCKET close
+#define SHUTDOWN_SEND SHUT_WR
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace {
+
+// Raw rows per encode task; small enough to spread one page over every core
+const size_t kBandBytes = 256 * 1024;
+const char* const kSocketPrefix = "socket://";
+const char* const kRawPrintPort = "9100";
+const size_t kPwgHeaderBytes = 1796;
+
+// -----------------------------
+// Destinations
+// -----------------------------
+class StreamSink {
+public:
+    virtual ~StreamSink() = default;
+    virtual bool write(const void* data, size_t size) = 0;
+    /// Completes the stream; destroying the sink without commit() abandons it
+    virtual bool commit() = 0;
+};
+
+class FileSink : public StreamSink {
+private:
+    std::FILE* file_;
+    std::string path_;
+    std::string finalPath_; ///< renamed to on commit (empty = device, written in place)
+
+public:
+    FileSink(std::FILE* file, const std::string& path, const std::string& finalPath)
+        : file_(file), path_(path), finalPath_(finalPath) {}
+
+    ~FileSink() override {
+        if (!file_) return;
+        std::fclose(file_);
+        std::error_code ec;
+        if (!finalPath_.empty()) std::filesystem::remove(path_, ec);
+    }
+
+    bool write(const void* data, size_t size) override {
+        return std::fwrite(data, 1, size, file_) == size;
+    }
+
+    bool commit() override {
+        bool ok = std::fclose(file_) == 0;
+        file_ = nullptr;
+        std::error_code ec;
+        if (!finalPath_.empty()) {
+            if (ok) std::filesystem::rename(path_, finalPath_, ec);
+            if (!ok || ec) {
+                std::filesystem::remove(path_, ec);
+                ok = false;
+            }
+        }
+        return ok;
+    }
+};
+
+bool setNonBlocking(SocketHandle sock, bool nonBlocking) {
+#ifdef _WIN32
+    u_long mode = nonBlocking ? 1 : 0;
+    return ioctlsocket(sock, FIONBIO, &mode) == 0;
+#else
+    const int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0) return false;
+    return fcntl(sock, F_SETFL, nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK)) == 0;
+#endif
+}
+
+bool connectInProgress() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS;
+#endif
+}
+
+bool sendTimedOut() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAETIMEDOUT;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+// Bounded connect: a printer that never answers must not hold the device lock forever
+bool connectWithTimeout(SocketHandle sock, const sockaddr* address, int length, unsigned timeoutSec,
+                        bool& timedOut) {
+    timedOut = false;
+    if (!setNonBlocking(sock, true)) return false;
+    if (connect(sock, address, length) != 0) {
+        if (!connectInProgress()) return false;
+        fd_set writable;
+        FD_ZERO(&writable);
+        FD_SET(sock, &writable);
+        timeval timeout = {(long)timeoutSec, 0};
+        const int ready = select((int)sock + 1, NULL, &writable, NULL, &timeout);
+        if (ready == 0) timedOut = true;
+        if (ready <= 0) return false;
+        int error = 0;
+        socklen_t errorLength = sizeof(error);
+        if (getsockopt(sock, SOL_SOCKET, SO_ERROR, (char*)&error, &errorLength) != 0 || error != 0) return false;
+    }
+    return setNonBlocking(sock, false);
+}
+
+class SocketSink : public StreamSink {
+private:
+    SocketHandle socket_;
+    std::string target_;
+
+public:
+    SocketSink(SocketHandle socket, const std::string& target) : socket_(socket), target_(target) {}
+
+    ~SocketSink() override {
+        if (socket_ != INVALID_SOCKET) CLOSE_SOCKET(socket_);
+    }
+
+    bool write(const void* data, size_t size) override {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            const int chunk = (int)std::min(size, (size_t)1 << 30);
+            const int n = (int)send(socket_, bytes, chunk, MSG_NOSIGNAL);
+            if (n <= 0) {
+                // SO_SNDTIMEO expired: the printer stopped reading
+                if (n < 0 && sendTimedOut()) LOG_ERROR << "❌ Timed out sending to printer " << target_;
+                return false;
+            }
+            bytes += n;
+            size -= (size_t)n;
+        }
+        return true;
+    }
+
+    bool commit() override {
+        // Half-close first so the printer sees end of job before the socket goes away
+        const bool ok = shutdown(socket_, SHUTDOWN_SEND) == 0;
+        const bool closed = CLOSE_SOCKET(socket_) == 0;
+        socket_ = INVALID_SOCKET;
+        return ok && closed;
+    }
+};
+
+// socket://host[:port], IPv6 hosts in brackets
+std::unique_ptr<StreamSink> connectSocket(const std::string& target, unsigned timeoutSec) {
+    std::string host = target.substr(std::strlen(kSocketPrefix));
+    std::string port = kRawPrintPort;
+    const size_t bracket = host.rfind(']');
+    const size_t colon = host.rfind(':');
+    if (colon != std::string::npos && (bracket == std::string::npos || colon > bracket)) {
+        port = host.substr(colon + 1);
+        host.erase(colon);
+    }
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.size() - 2);
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    const int rc = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+    if (rc != 0) {
+        LOG_ERROR << "❌ Cannot resolve printer " << target << ": " << gai_strerror(rc);
+        return nullptr;
+    }
+
+    SocketHandle sock = INVALID_SOCKET;
+    bool timedOut = false;
+    for (addrinfo* address = addresses; address && sock == INVALID_SOCKET; address = address->ai_next) {
+        sock = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (sock == INVALID_SOCKET) continue;
+        bool addressTimedOut = false;
+        if (!connectWithTimeout(sock, address->ai_addr, (int)address->ai_addrlen, timeoutSec, addressTimedOut)) {
+            timedOut = timedOut || addressTimedOut;
+            CLOSE_SOCKET(sock);
+            sock = INVALID_SOCKET;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (sock == INVALID_SOCKET) {
+        if (timedOut) LOG_ERROR << "❌ Timed out connecting to printer " << target << " after " << timeoutSec << " s";
+        else LOG_ERROR << "❌ Cannot connect to printer " << target;
+        return nullptr;
+    }
+
+    // A printer that stops reading fails the document instead of blocking the job
+#ifdef _WIN32
+    const DWORD sendTimeout = (DWORD)timeoutSec * 1000;
+#else
+    const timeval sendTimeout = {(long)timeoutSec, 0};
+#endif
+    if (setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const char*)&sendTimeout, sizeof(sendTimeout)) != 0) {
+        LOG_ERROR << "❌ Cannot set a send timeout for printer " << target;
+        CLOSE_SOCKET(sock);
+        return nullptr;
+    }
+    return std::unique_ptr<StreamSink>(new SocketSink(sock, target));
+}
+
+// -----------------------------
+// Band encoders
+// -----------------------------
+
+// Packed gray / RGB rows; BGR pages are swapped back one row at a time. Two
+// scratch rows so the previous row stays valid while the next one is read.
+class RowReader {
+private:
+    const PageRaster& page_;
+    std::vector<Uint8> scratch_[2];
+
+public:
+    explicit RowReader(const PageRaster& page) : page_(page) {}
+
+    const Uint8* row(unsigned long y) {
+        const Uint8* src = page_.data + y * page_.stride;
+        if (page_.bitsPerPixel != 24 || !page_.bgr) return src;
+        std::vector<Uint8>& dst = scratch_[y & 1];
+        dst.resize(page_.rowBytes());
+        PixelKernels::swizzleRGBtoBGR(src, dst.size(), dst.data(), dst.size(), page_.width, 1);
+        return dst.data();
+    }
+};
+
+// PWG PackBits for one line: 0..127 = next pixel repeated n+1 times,
+// 129..255 = 257-n literal pixels
+template <size_t Bytes>
+void encodePwgLine(const Uint8* row, size_t width, std::vector<Uint8>& out) {
+    auto same = [row](size_t a, size_t b) { return std::memcmp(row + a * Bytes, row + b * Bytes, Bytes) == 0; };
+    size_t x = 0;
+    while (x < width) {
+        size_t run = 1;
+        while (x + run < width && run < 128 && same(x, x + run)) ++run;
+        if (run > 1) {
+            out.push_back((Uint8)(run - 1));
+            out.insert(out.end(), row + x * Bytes, row + (x + 1) * Bytes);
+            x += run;
+            continue;
+        }
+
+        // Literal pixels up to the start of the next run
+        const size_t start = x++;
+        while (x < width && x - start < 128 && !(x + 1 < width && same(x, x + 1))) ++x;
+        const size_t count = x - start;
+        out.push_back(count == 1 ? 0 : (Uint8)(257 - count));
+        out.insert(out.end(), row + start * Bytes, row + x * Bytes);
+    }
+}
+
+// Line records are self-contained, so bands join by plain concatenation
+void encodePwgBand(const PageRaster& page, unsigned long y0, unsigned long y1, std::vector<Uint8>& out) {
+    RowReader reader(page);
+    const size_t rowBytes = page.rowBytes();
+    unsigned long y = y0;
+    while (y < y1) {
+        const Uint8* raw = page.data + y * page.stride;
+        unsigned long repeat = 0;
+        while (y + repeat + 1 < y1 && repeat < 255 &&
+               std::memcmp(raw, page.data + (y + repeat + 1) * page.stride, rowBytes) == 0)
+            ++repeat;
+
+        out.push_back((Uint8)repeat);
+        if (page.bitsPerPixel == 24) encodePwgLine<3>(reader.row(y), page.width, out);
+        else encodePwgLine<1>(reader.row(y), page.width, out);
+        y += repeat + 1;
+    }
+}
+
+// One band of the page's zlib stream as raw deflate with its own Adler-32. Every
+// band but the last ends on a sync flush (byte boundary, no final block), so the
+// bands concatenate into one valid stream and the checksums combine.
+// Rows carry the PNG "Up" predictor; the row above a band is read from the page.
+bool deflateBand(const PageRaster& page, unsigned long y0, unsigned long y1, bool last,
+                 std::vector<Uint8>& out, uLong& adler) {
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;
+
+    RowReader reader(page);
+    const size_t rowBytes = page.rowBytes();
+    std::vector<Uint8> filtered(rowBytes + 1);
+    filtered[0] = 2; // PNG Up
+    std::vector<Uint8> zeros;
+    const Uint8* prev = nullptr;
+    if (y0 > 0) {
+        prev = reader.row(y0 - 1);
+    } else {
+        zeros.assign(rowBytes, 0);
+        prev = zeros.data();
+    }
+
+    out.resize(deflateBound(&zs, (uLong)((rowBytes + 1) * (y1 - y0))) + 64);
+    adler = adler32(0L, Z_NULL, 0);
+    bool ok = true;
+    for (unsigned long y = y0; ok && y < y1; ++y) {
+        const Uint8* cur = reader.row(y);
+        for (size_t i = 0; i < rowBytes; ++i) filtered[i + 1] = (Uint8)(cur[i] - prev[i]);
+        prev = cur;
+        adler = adler32(adler, filtered.data(), (uInt)filtered.size());
+
+        const int flush = y + 1 < y1 ? Z_NO_FLUSH : (last ? Z_FINISH : Z_SYNC_FLUSH);
+        zs.next_in = filtered.data();
+        zs.avail_in = (uInt)filtered.size();
+        do {
+            if (zs.total_out == out.size()) out.resize(out.size() * 2);
+            zs.next_out = out.data() + zs.total_out;
+            zs.avail_out = (uInt)(out.size() - zs.total_out);
+            const int rc = deflate(&zs, flush);
+            ok = rc == Z_OK || rc == Z_STREAM_END || rc == Z_BUF_ERROR;
+        } while (ok && zs.avail_out == 0);
+    }
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return ok;
+}
+
+// Rows per encode task, and tasks per page
+unsigned long bandRows(const PageRaster& page) {
+    return (unsigned long)std::max<size_t>(1, kBandBytes / std::max<size_t>(1, page.rowBytes()));
+}
+
+size_t bandCount(const PageRaster& page) {
+    const unsigned long rows = bandRows(page);
+    return (size_t)((page.height + rows - 1) / rows);
+}
+
+void putU32(Uint8* dst, uint32_t value) {
+    dst[0] = (Uint8)(value >> 24);
+    dst[1] = (Uint8)(value >> 16);
+    dst[2] = (Uint8)(value >> 8);
+    dst[3] = (Uint8)value;
+}
+
+void putFloat(Uint8* dst, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putU32(dst, bits);
+}
+
+// PWG 5102.4 page header (the CUPS v2 raster header with PWG values)
+void pwgPageHeader(const PageRaster& page, unsigned dpi, Uint8* header) {
+    std::memset(header, 0, kPwgHeaderBytes);
+    std::memcpy(header, "PwgRaster", 9);             // MediaClass
+    putU32(header + 276, dpi);                       // HWResolution
+    putU32(header + 280, dpi);
+    putU32(header + 340, 1);                         // NumCopies, copies are sent as pages
+    const float widthPt = page.width * 72.0f / dpi;
+    const float heightPt = page.height * 72.0f / dpi;
+    putU32(header + 352, (uint32_t)(widthPt + 0.5f)); // PageSize
+    putU32(header + 356, (uint32_t)(heightPt + 0.5f));
+    putU32(header + 372, (uint32_t)page.width);      // cupsWidth
+    putU32(header + 376, (uint32_t)page.height);     // cupsHeight
+    putU32(header + 384, 8);                         // cupsBitsPerColor
+    putU32(header + 388, (uint32_t)page.bitsPerPixel);
+    putU32(header + 392, (uint32_t)page.rowBytes()); // cupsBytesPerLine
+    putU32(header + 400, page.bitsPerPixel == 24 ? 19 : 18); // cupsColorSpace: sRGB / sGray
+    putU32(header + 420, page.bitsPerPixel == 24 ? 3 : 1);   // cupsNumColors
+    putFloat(header + 428, widthPt);                 // cupsPageSize
+    putFloat(header + 432, heightPt);
+    putU32(header + 456, 1);                         // CrossFeedTransform
+    putU32(header + 460, 1);                         // FeedTransform
+}
+
+} // namespace
+
+// -----------------------------
+// Document: one stream per job, pages written as soon as they are encoded
+// -----------------------------
+class RasterStreamBackend::Document : public OutputDocument {
+private:
+    RasterStreamBackend& backend_;
+    std::unique_lock<std::mutex> deviceLock_; ///< held until the job is out, device targets only
+    std::unique_ptr<StreamSink> sink_;
+    std::string target_;
+    uint64_t written_;
+    uint64_t rasterBytes_;
+    unsigned pages_;
+    bool failed_;
+
+    // PDF: object 1 is the catalog, object 2 the page tree written by finish()
+    std::vector<uint64_t> objectOffsets_; ///< by object number - 1
+    std::vector<unsigned> pageObjects_;
+
+public:
+    Document(RasterStreamBackend& backend, std::unique_lock<std::mutex> deviceLock,
+             std::unique_ptr<StreamSink> sink, const std::string& target)
+        : backend_(backend), deviceLock_(std::move(deviceLock)), sink_(std::move(sink)), target_(target),
+          written_(0), rasterBytes_(0), pages_(0), failed_(false), objectOffsets_(2, 0) {}
+
+    ~Document() override {
+        if (sink_) LOG_WARN << "⚠ Print stream to " << target_ << " abandoned after " << pages_ << " pages";
+    }
+
+    bool begin() {
+        if (backend_.format_ == Format::Pwg) return write("RaS2", 4);
+        // Binary marker comment so transports treat the file as binary
+        static const char kHeader[] = "%PDF-1.4\n%\xE2\xE3\xCF\xD3\n";
+        return write(kHeader, sizeof(kHeader) - 1) && beginObject(1) &&
+               writeText("<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+    }
+
+    bool printPage(const PageRaster& page, const PageInfo& info) override {
+        if (failed_ || !sink_) return false;
+        if (!page.data || page.width == 0 || page.height == 0 ||
+            (page.bitsPerPixel != 8 && page.bitsPerPixel != 24)) {
+            LOG_ERROR << "❌ Unsupported page raster for stream output";
+            return false;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t before = written_;
+        const unsigned dpi = info.dpi ? info.dpi : 72;
+        const bool ok = backend_.format_ == Format::Pwg ? writePwgPage(page, dpi) : writePdfPage(page, dpi);
+        if (!ok) {
+            failed_ = true;
+            LOG_ERROR << "❌ Cannot write page " << info.pageNumber << " to " << target_;
+            return false;
+        }
+
+        const uint64_t raw = (uint64_t)page.rowBytes() * page.height;
+        ++pages_;
+        rasterBytes_ += raw;
+        ++backend_.pages_;
+        backend_.rasterBytes_ += raw;
+        LOG_DEBUG << "📦 Page " << info.pageNumber << ": " << raw / 1024 << " KB raster -> "
+                  << (written_ - before) / 1024 << " KB in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)
+                         .count()
+                  << " ms";
+        return true;
+    }
+
+    bool finish() override {
+        if (failed_ || !sink_) return false;
+        if (backend_.format_ == Format::Pdf && !writePdfTrailer()) failed_ = true;
+        std::unique_ptr<StreamSink> sink = std::move(sink_);
+        const bool committed = !failed_ && sink->commit();
+        sink.reset();
+        if (deviceLock_.owns_lock()) deviceLock_.unlock();
+        if (!committed) {
+            LOG_ERROR << "❌ Cannot complete print stream " << target_;
+            return false;
+        }
+
+        ++backend_.documents_;
+        LOG_INFO << "💾 Print stream written: " << target_ << " (" << pages_ << " pages, "
+                 << rasterBytes_ / 1024 << " KB raster -> " << written_ / 1024 << " KB)";
+        return true;
+    }
+
+private:
+    bool write(const void* data, size_t size) {
+        if (!sink_->write(data, size)) return false;
+        written_ += size;
+        backend_.streamBytes_ += size;
+        return true;
+    }
+
+    bool writeText(const std::string& text) { return write(text.data(), text.size()); }
+
+    // Runs encode(y0, y1, band) for every band of the page, in parallel on the pool
+    template <class Encode>
+    bool encodeBands(const PageRaster& page, size_t bandCount, Encode encode) {
+        const unsigned long rows = bandRows(page);
+        std::vector<char> ok(bandCount, 0);
+        auto run = [&](size_t band) {
+            const unsigned long y0 = (unsigned long)band * rows;
+            ok[band] = encode(y0, std::min(page.height, y0 + rows), band) ? 1 : 0;
+        };
+        if (backend_.pool_) {
+            backend_.pool_->parallelFor(bandCount, run);
+        } else {
+            for (size_t band = 0; band < bandCount; ++band) run(band);
+        }
+        return std::find(ok.begin(), ok.end(), 0) == ok.end();
+    }
+
+    bool writePwgPage(const PageRaster& page, unsigned dpi) {
+        std::vector<std::vector<Uint8>> bands(bandCount(page));
+        encodeBands(page, bands.size(), [&](unsigned long y0, unsigned long y1, size_t band) {
+            encodePwgBand(page, y0, y1, bands[band]);
+            return true;
+        });
+
+        Uint8 header[kPwgHeaderBytes];
+        pwgPageHeader(page, dpi, header);
+        if (!write(header, sizeof(header))) return false;
+        for (const std::vector<Uint8>& band : bands) {
+            if (!write(band.data(), band.size())) return false;
+        }
+        return true;
+    }
+
+    bool writePdfPage(const PageRaster& page, unsigned dpi) {
+        const size_t count = bandCount(page);
+        std::vector<std::vector<Uint8>> bands(count);
+        std::vector<uLong> checksums(count);
+        const bool encoded = encodeBands(page, count, [&](unsigned long y0, unsigned long y1, size_t band) {
+            return deflateBand(page, y0, y1, y1 == page.height, bands[band], checksums[band]);
+        });
+        if (!encoded) {
+            LOG_ERROR << "❌ Deflate failed";
+            return false;
+        }
+
+        // zlib wrapper around the joined bands: header, data, Adler-32 of the whole page
+        const unsigned long rows = bandRows(page);
+        uLong adler = adler32(0L, Z_NULL, 0);
+        size_t dataBytes = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const unsigned long bandHeight = std::min(rows, page.height - (unsigned long)i * rows);
+            adler = adler32_combine(adler, checksums[i], (z_off_t)((page.rowBytes() + 1) * bandHeight));
+            dataBytes += bands[i].size();
+        }
+        Uint8 trailer[4];
+        putU32(trailer, (uint32_t)adler);
+        static const Uint8 kZlibHeader[2] = {0x78, 0x9C};
+
+        const bool gray = page.bitsPerPixel == 8;
+        const double widthPt = page.width * 72.0 / dpi;
+        const double heightPt = page.height * 72.0 / dpi;
+        const unsigned pageObject = (unsigned)objectOffsets_.size() + 1;
+        char text[512];
+
+        std::snprintf(text, sizeof(text),
+                      "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %.2f %.2f] /Resources << /XObject << "
+                      "/Im0 %u 0 R >> >> /Contents %u 0 R >>\nendobj\n",
+                      widthPt, heightPt, pageObject + 2, pageObject + 1);
+        if (!beginObject(pageObject) || !writeText(text)) return false;
+
+        char content[128];
+        const int contentBytes =
+            std::snprintf(content, sizeof(content), "q %.2f 0 0 %.2f 0 0 cm /Im0 Do Q\n", widthPt, heightPt);
+        std::snprintf(text, sizeof(text), "<< /Length %d >>\nstream\n%sendstream\nendobj\n", contentBytes, content);
+        if (!beginObject(pageObject + 1) || !writeText(text)) return false;
+
+        std::snprintf(text, sizeof(text),
+                      "<< /Type /XObject /Subtype /Image /Width %lu /Height %lu /ColorSpace /%s "
+                      "/BitsPerComponent 8 /Filter /FlateDecode /DecodeParms << /Predictor 12 /Colors %d "
+                      "/BitsPerComponent 8 /Columns %lu >> /Length %llu >>\nstream\n",
+                      page.width, page.height, gray ? "DeviceGray" : "DeviceRGB", gray ? 1 : 3, page.width,
+                      (unsigned long long)(dataBytes + sizeof(kZlibHeader) + sizeof(trailer)));
+        if (!beginObject(pageObject + 2) || !writeText(text) || !write(kZlibHeader, sizeof(kZlibHeader)))
+            return false;
+        for (const std::vector<Uint8>& band : bands) {
+            if (!write(band.data(), band.size())) return false;
+        }
+        if (!write(trailer, sizeof(trailer)) || !writeText("\nendstream\nendobj\n")) return false;
+
+        pageObjects_.push_back(pageObject);
+        return true;
+    }
+
+    bool writePdfTrailer() {
+        std::string kids;
+        for (unsigned object : pageObjects_) kids += std::to_string(object) + " 0 R ";
+        if (!beginObject(2) || !writeText("<< /Type /Pages /Kids [ " + kids + "] /Count " + std::to_string(pageObjects_.size()) +
+                       " >>\nendobj\n"))
+            return false;
+
+        const uint64_t xref = written_;
+        std::string table = "xref\n0 " + std::to_string(objectOffsets_.size() + 1) + "\n0000000000 65535 f \n";
+        char entry[32];
+        for (uint64_t offset : objectOffsets_) {
+            std::snprintf(entry, sizeof(entry), "%010llu 00000 n \n", (unsigned long long)offset);
+            table += entry;
+        }
+        table += "trailer\n<< /Size " + std::to_string(objectOffsets_.size() + 1) +
+                 " /Root 1 0 R >>\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n";
+        return writeText(table);
+    }
+
+    // Records where object n starts and opens it
+    bool beginObject(unsigned number) {
+        if (objectOffsets_.size() < number) objectOffsets_.resize(number, 0);
+        objectOffsets_[number - 1] = written_;
+        return writeText(std::to_string(number) + " 0 obj\n");
+    }
+};
+
+// -----------------------------
+// RasterStreamBackend Implementation
+// -----------------------------
+RasterStreamBackend::RasterStreamBackend(Format format, const std::string& directory, const std::string& device,
+                                         unsigned timeoutSec, ThreadPool* pool)
+    : format_(format), directory_(directory), device_(device), timeoutSec_(timeoutSec), pool_(pool), documents_(0),
+      pages_(0),
+      rasterBytes_(0), streamBytes_(0) {
+    if (device_.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory_, ec);
+        if (ec)
+            LOG_ERROR << "❌ Cannot create spool directory " << directory_ << ": " << ec.message();
+    }
+}
+
+bool RasterStreamBackend::printPage(const PageRaster& page, const PageInfo& info) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "job%06lu_p%03u.%s", info.jobId, info.pageNumber,
+                  format_ == Format::Pwg ? "pwg" : "pdf");
+    std::unique_ptr<OutputDocument> document = openStream(name);
+    return document && document->printPage(page, info) && document->finish();
+}
+
+std::unique_ptr<OutputDocument> RasterStreamBackend::openDocument(const PageInfo& info) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "job%06lu.%s", info.jobId, format_ == Format::Pwg ? "pwg" : "pdf");
+    return openStream(name);
+}
+
+std::unique_ptr<OutputDocument> RasterStreamBackend::openStream(const std::string& fileName) {
+    std::unique_lock<std::mutex> deviceLock;
+    std::unique_ptr<StreamSink> sink;
+    std::string target;
+
+    if (device_.empty()) {
+        // Spool readers only ever see complete streams under the final name
+        target = (std::filesystem::path(directory_) / fileName).string();
+        const std::string tmpPath = target + ".part";
+        std::FILE* file = std::fopen(tmpPath.c_str(), "wb");
+        if (!file) {
+            LOG_ERROR << "❌ Cannot open " << tmpPath << " for writing";
+            return nullptr;
+        }
+        sink.reset(new FileSink(file, tmpPath, target));
+    } else {
+        target = device_;
+        deviceLock = std::unique_lock<std::mutex>(deviceMutex_);
+        if (device_.compare(0, std::strlen(kSocketPrefix), kSocketPrefix) == 0) {
+            sink = connectSocket(device_, timeoutSec_);
+        } else {
+            std::FILE* file = std::fopen(device_.c_str(), "wb");
+            if (!file) {
+                LOG_ERROR << "❌ Cannot open printer device " << device_;
+                return nullptr;
+            }
+#ifndef _WIN32
+            // Worker processes (--processes) share the device too; wait for theirs
+            // to finish for as long as a socket printer would be given
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSec_);
+            int locked;
+            while ((locked = flock(fileno(file), LOCK_EX | LOCK_NB)) != 0 && errno == EWOULDBLOCK &&
+                   std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (locked != 0) {
+                LOG_ERROR << "❌ Cannot lock printer device " << device_ << ": "
+                          << (errno == EWOULDBLOCK ? std::string("held by another process") : strerror(errno));
+                std::fclose(file);
+                return nullptr;
+            }
+#endif
+            sink.reset(new FileSink(file, device_, std::string()));
+        }
+        if (!sink) return nullptr;
+    }
+
+    std::unique_ptr<Document> document(new Document(*this, std::move(deviceLock), std::move(sink), target));
+    if (!document->begin()) {
+        LOG_ERROR << "❌ Cannot write to " << target;
+        return nullptr;
+    }
+    return std::unique_ptr<OutputDocument>(document.release());
+}
+
+void RasterStreamBackend::appendMetrics(std::string& out) {
+    appendMetric(out, "dicom_print_stream_documents_total", "counter", "Print streams completed by the stream output.",
+                 (double)documents_.load());
+    appendMetric(out, "dicom_print_stream_pages_total", "counter", "Pages encoded by the stream output.",
+                 (double)pages_.load());
+    appendMetric(out, "dicom_print_stream_raster_bytes_total", "counter",
+                 "Uncompressed page bytes handed to the stream output.", (double)rasterBytes_.load());
+    appendMetric(out, "dicom_print_stream_bytes_total", "counter", "Encoded bytes written by the stream output.",
+                 (double)streamBytes_.load());
+}
+
+bool parseStreamFormat(const std::string& text, RasterStreamBackend::Format& format) {
+    if (text == "pwg") format = RasterStreamBackend::Format::Pwg;
+    else if (text == "pdf") format = RasterStreamBackend::Format::Pdf;
+    else return false;
+    return true;
+}
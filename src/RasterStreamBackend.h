@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "OutputBackend.h"
+
+class ThreadPool;
+
+/**
+ * @class RasterStreamBackend
+ * @brief ترميز صفحات المهمة كتيار طباعة مضغوط واحد بدلاً من صفحات غير مضغوطة
+ *
+ * الصيغ:
+ * - pwg: PWG Raster (RaS2) بضغط تكرار الأسطر + PackBits الخاص بها، تقبله طابعات
+ *   IPP Everywhere و CUPS مباشرة
+ * - pdf: PDF بصورة واحدة لكل صفحة مضغوطة بـ Flate (zlib)
+ *
+ * كل صفحة تُقسم إلى شرائح أفقية تُرمز بالتوازي على مجموعة خيوط العرض ثم تُكتب
+ * بالترتيب، وكل صفحة تُرسل فور ترميزها دون انتظار بقية المهمة.
+ *
+ * الوجهة: ملف لكل مهمة داخل مجلد التخزين (job<id>.pwg / .pdf، يظهر باسمه النهائي
+ * عند اكتماله فقط)، أو جهاز: مسار يُفتح للكتابة (/dev/usb/lp0، FIFO...) أو
+ * socket://host[:port] لمنفذ الطباعة الخام (9100). المهام إلى الجهاز تُرسل واحدة
+ * تلو الأخرى لأنه لا يقبل إلا مهمة واحدة في كل مرة، ولذلك الاتصال والإرسال وانتظار
+ * قفل الجهاز محدودة بمهلة تُفشل المستند عند انقضائها بدلاً من حجز الجهاز.
+ */
+class RasterStreamBackend : public OutputBackend {
+public:
+    enum class Format {
+        Pwg,
+        Pdf
+    };
+
+private:
+    Format format_;
+    std::string directory_;  ///< مجلد ملفات المهام عند عدم تحديد جهاز
+    std::string device_;     ///< مسار الجهاز أو socket://host:port (فارغ = ملفات)
+    unsigned timeoutSec_;    ///< مهلة الاتصال والإرسال إلى الطابعة وانتظار قفل الجهاز
+    ThreadPool* pool_;       ///< لترميز الشرائح بالتوازي (nullptr = الخيط المستدعي)
+    std::mutex deviceMutex_; ///< مهمة واحدة على الجهاز في كل مرة
+
+    std::atomic<uint64_t> documents_;
+    std::atomic<uint64_t> pages_;
+    std::atomic<uint64_t> rasterBytes_;  ///< حجم الصفحات قبل الضغط
+    std::atomic<uint64_t> streamBytes_;  ///< البايتات المكتوبة فعلاً
+
+    class Document;
+
+public:
+    RasterStreamBackend(Format format, const std::string& directory, const std::string& device, unsigned timeoutSec,
+                        ThreadPool* pool);
+
+    const char* name() const override { return format_ == Format::Pwg ? "stream (pwg)" : "stream (pdf)"; }
+
+    /**
+     * @brief 8bit رمادي أو RGB متراص، وهو ما تحمله الصيغتان كما هو
+     */
+    RasterLayout preferredLayout() const override { return RasterLayout(); }
+
+    /**
+     * @brief صفحة منفردة كمستند من صفحة واحدة
+     */
+    bool printPage(const PageRaster& page, const PageInfo& info) override;
+
+    std::unique_ptr<OutputDocument> openDocument(const PageInfo& info) override;
+
+    void appendMetrics(std::string& out) override;
+
+private:
+    /**
+     * @brief فتح الوجهة (الجهاز، أو fileName داخل المجلد) وكتابة بداية المستند
+     */
+    std::unique_ptr<OutputDocument> openStream(const std::string& fileName);
+};
+
+/**
+ * @brief قراءة اسم الصيغة ("pwg" أو "pdf")
+ */
+bool parseStreamFormat(const std::string& text, RasterStreamBackend::Format& format);
@@ -0,0 +1,143 @@
+// RenderKernels.cpp
+#include "RenderKernels.h"
+#include <algorithm>
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+
+namespace {
+
+// -----------------------------
+// Grayscale: one table lookup per stored word
+// -----------------------------
+template <class Word>
+void grayHistogram(const void* raw, size_t count, uint32_t* bins) {
+    const Word* words = static_cast<const Word*>(raw);
+    for (size_t i = 0; i < count; ++i) ++bins[words[i]];
+}
+
+template <class Word>
+void grayMap(const void* raw, const uint8_t* table, uint8_t* dst, size_t count) {
+    const Word* words = static_cast<const Word*>(raw);
+    for (size_t i = 0; i < count; ++i) dst[i] = table[words[i]];
+}
+
+// -----------------------------
+// Colour: 8-bit RGB / YBR_FULL, by pixel or by plane
+// -----------------------------
+
+// ITU-R BT.601 full range in 16.16 fixed point, as tables indexed by Cb / Cr
+struct YbrTables {
+    int crToR[256];
+    int cbToB[256];
+    int cbCrToG[256][2]; ///< [Cb][0] and [Cr][1], summed per pixel
+
+    YbrTables() {
+        for (int i = 0; i < 256; ++i) {
+            const int c = i - 128;
+            crToR[i] = (91881 * c + 32768) >> 16;
+            cbToB[i] = (116130 * c + 32768) >> 16;
+            cbCrToG[i][0] = -22554 * c;
+            cbCrToG[i][1] = -46802 * c + 32768;
+        }
+    }
+};
+
+const YbrTables& ybrTables() {
+    static const YbrTables tables;
+    return tables;
+}
+
+inline uint8_t clamp8(int value) {
+    return (uint8_t)std::min(255, std::max(0, value));
+}
+
+template <Photometric P, bool Planar>
+void colorToRGB(const void* raw, uint8_t* dst, size_t pixelCount) {
+    const uint8_t* src = static_cast<const uint8_t*>(raw);
+    const YbrTables& ybr = ybrTables();
+    for (size_t i = 0; i < pixelCount; ++i) {
+        uint8_t a, b, c;
+        if constexpr (Planar) {
+            a = src[i];
+            b = src[pixelCount + i];
+            c = src[2 * pixelCount + i];
+        } else {
+            a = src[i * 3 + 0];
+            b = src[i * 3 + 1];
+            c = src[i * 3 + 2];
+        }
+        uint8_t* out = dst + i * 3;
+        if constexpr (P == Photometric::YbrFull) {
+            out[0] = clamp8(a + ybr.crToR[c]);
+            out[1] = clamp8(a + ((ybr.cbCrToG[b][0] + ybr.cbCrToG[c][1]) >> 16));
+            out[2] = clamp8(a + ybr.cbToB[b]);
+        } else {
+            out[0] = a;
+            out[1] = b;
+            out[2] = c;
+        }
+    }
+}
+
+const RenderKernel kGray8 = {"gray8", false, grayHistogram<uint8_t>, grayMap<uint8_t>, nullptr};
+const RenderKernel kGray16 = {"gray16", false, grayHistogram<uint16_t>, grayMap<uint16_t>, nullptr};
+const RenderKernel kRgb8 = {"rgb8", true, nullptr, nullptr, colorToRGB<Photometric::RGB, false>};
+const RenderKernel kRgb8Planar = {"rgb8-planar", true, nullptr, nullptr, colorToRGB<Photometric::RGB, true>};
+const RenderKernel kYbr8 = {"ybr8", true, nullptr, nullptr, colorToRGB<Photometric::YbrFull, false>};
+const RenderKernel kYbr8Planar = {"ybr8-planar", true, nullptr, nullptr, colorToRGB<Photometric::YbrFull, true>};
+
+} // namespace
+
+bool readPixelFormat(DcmItem& dataset, PixelFormat& format) {
+    if (dataset.findAndGetUint16(DCM_Rows, format.rows).bad() ||
+        dataset.findAndGetUint16(DCM_Columns, format.columns).bad() ||
+        dataset.findAndGetUint16(DCM_BitsAllocated, format.bitsAllocated).bad())
+        return false;
+
+    Uint16 value = 0;
+    format.samplesPerPixel = dataset.findAndGetUint16(DCM_SamplesPerPixel, value).good() ? value : 1;
+    format.bitsStored = dataset.findAndGetUint16(DCM_BitsStored, value).good() && value ? value
+                                                                                         : format.bitsAllocated;
+    format.highBit = dataset.findAndGetUint16(DCM_HighBit, value).good() ? value : format.bitsStored - 1;
+    format.isSigned = dataset.findAndGetUint16(DCM_PixelRepresentation, value).good() && value == 1;
+    format.planar = dataset.findAndGetUint16(DCM_PlanarConfiguration, value).good() && value == 1;
+
+    // The fused table only knows rescale and a linear window
+    DcmItem* item = nullptr;
+    OFString function;
+    dataset.findAndGetOFString(DCM_VOILUTFunction, function);
+    format.lutTables = dataset.findAndGetSequenceItem(DCM_ModalityLUTSequence, item, 0).good() ||
+                       dataset.findAndGetSequenceItem(DCM_VOILUTSequence, item, 0).good() ||
+                       (!function.empty() && function != "LINEAR");
+
+    OFString photometric;
+    dataset.findAndGetOFString(DCM_PhotometricInterpretation, photometric);
+    if (photometric == "MONOCHROME1") format.photometric = Photometric::Monochrome1;
+    else if (photometric == "MONOCHROME2") format.photometric = Photometric::Monochrome2;
+    else if (photometric == "RGB") format.photometric = Photometric::RGB;
+    else if (photometric == "YBR_FULL") format.photometric = Photometric::YbrFull;
+    else format.photometric = Photometric::Other;
+    return true;
+}
+
+const RenderKernel* selectRenderKernel(const PixelFormat& format) {
+    if (format.rows == 0 || format.columns == 0) return nullptr;
+
+    if (format.samplesPerPixel == 1 &&
+        (format.photometric == Photometric::Monochrome1 || format.photometric == Photometric::Monochrome2)) {
+        if (format.lutTables || format.bitsStored > format.bitsAllocated ||
+            format.highBit >= format.bitsAllocated || format.highBit + 1 < format.bitsStored)
+            return nullptr;
+        if (format.bitsAllocated == 8) return &kGray8;
+        if (format.bitsAllocated == 16) return &kGray16;
+        return nullptr;
+    }
+
+    // Colour values go out as stored, so only full 8-bit unsigned samples qualify
+    if (format.samplesPerPixel == 3 && format.bitsAllocated == 8 && format.bitsStored == 8 &&
+        format.highBit == 7 && !format.isSigned) {
+        if (format.photometric == Photometric::RGB) return format.planar ? &kRgb8Planar : &kRgb8;
+        if (format.photometric == Photometric::YbrFull) return format.planar ? &kYbr8Planar : &kYbr8;
+    }
+    return nullptr;
+}
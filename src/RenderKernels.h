@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcitem.h>
+
+/**
+ * @brief تفسير قيم البكسلات (Photometric Interpretation)
+ */
+enum class Photometric {
+    Monochrome1,
+    Monochrome2,
+    RGB,
+    YbrFull,
+    Other        ///< PALETTE COLOR / YBR_FULL_422 / ... (مسار DicomImage)
+};
+
+/**
+ * @struct PixelFormat
+ * @brief خصائص وحدة البكسلات التي تحدد نواة العرض، تُقرأ مرة واحدة لكل صورة
+ */
+struct PixelFormat {
+    Uint16 rows = 0;
+    Uint16 columns = 0;
+    Uint16 samplesPerPixel = 1;
+    Uint16 bitsAllocated = 0;
+    Uint16 bitsStored = 0;
+    Uint16 highBit = 0;
+    bool isSigned = false;
+    bool planar = false;          ///< Planar Configuration = 1 (R..R G..G B..B)
+    bool lutTables = false;       ///< Modality/VOI LUT Sequence أو VOI LUT Function غير LINEAR
+    Photometric photometric = Photometric::Other;
+};
+
+/**
+ * @brief قراءة PixelFormat من الـ Dataset
+ * @return false إذا نقصت Rows / Columns / Bits Allocated
+ */
+bool readPixelFormat(DcmItem& dataset, PixelFormat& format);
+
+/**
+ * @struct RenderKernel
+ * @brief الحلقات الداخلية لعرض صيغة بكسل واحدة، مولدة من قوالب لكل تركيبة
+ *        مدعومة فلا يبقى أي تفرع حسب الصيغة داخل الحلقات
+ *
+ * الرمادي: الحلقة تُولد لكل Bits Allocated (8/16)، وكل بكسل يمر بجدول واحد
+ * (GrayscaleLut) مفهرس بالكلمة المخزنة كما هي، فالإشارة و MONOCHROME1 والبتات
+ * خارج Bits Stored كلها داخل الجدول ولا تحتاج نسخاً منفصلة.
+ * الملون 8bit: تُولد لكل Photometric (RGB / YBR_FULL) و Planar Configuration،
+ * والناتج دائماً R G B متراص.
+ */
+struct RenderKernel {
+    const char* name;   ///< للسجلات، مثل "gray16" أو "ybr8-planar"
+    bool color;
+
+    /// عد الكلمات المخزنة في bins (256 أو 65536 خانة)؛ رمادي فقط
+    void (*histogram)(const void* raw, size_t count, uint32_t* bins);
+    /// dst[i] = table[الكلمة i]؛ رمادي فقط
+    void (*mapGray)(const void* raw, const uint8_t* table, uint8_t* dst, size_t count);
+    /// تحويل pixelCount بكسل إلى R G B متراص؛ ملون فقط
+    void (*toRGB)(const void* raw, uint8_t* dst, size_t pixelCount);
+};
+
+/**
+ * @brief اختيار النواة المطابقة للصيغة
+ * @return nullptr للترميزات النادرة (1/32bit، لون 16bit، PALETTE COLOR...) وللصور
+ *         الرمادية ذات جداول LUT أو دالة VOI غير خطية، فتبقى على مسار DicomImage العام
+ */
+const RenderKernel* selectRenderKernel(const PixelFormat& format);
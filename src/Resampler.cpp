@@ -0,0 +1,170 @@
+// Resampler.cpp
+#include "Resampler.h"
+#include "BufferPool.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace {
+
+const int kWeightBits = 14;          // filter weights: 1.0 == 1 << 14
+const int kIntermediateBits = 6;     // horizontal pass keeps 6 fractional bits in Sint16
+const int kHorizontalShift = kWeightBits - kIntermediateBits;
+const int kVerticalShift = kWeightBits + kIntermediateBits;
+const unsigned long kRowsPerBand = 32;
+
+double triangle(double x) {
+    x = std::fabs(x);
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+// Catmull-Rom spline (Keys cubic with a = -0.5)
+double catmullRom(double x) {
+    x = std::fabs(x);
+    if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+// Fixed-size tap window per output sample along one axis; out-of-range source
+// samples are folded onto the edge so every window lies inside the image.
+struct Contributions {
+    int taps = 1;
+    std::vector<unsigned long> start; // first source sample per output sample
+    std::vector<Sint16> weights;      // taps weights per output sample, sum == 1 << kWeightBits
+};
+
+void computeContributions(unsigned long srcSize, unsigned long dstSize, ResampleFilter filter,
+                          Contributions& out) {
+    out.start.assign(dstSize, 0);
+
+    const double scale = (double)dstSize / srcSize;
+    if (filter == ResampleFilter::Replicate || srcSize == dstSize) {
+        out.taps = 1;
+        out.weights.assign(dstSize, (Sint16)(1 << kWeightBits));
+        for (unsigned long i = 0; i < dstSize; ++i)
+            out.start[i] = std::min((unsigned long)((i + 0.5) / scale), srcSize - 1);
+        return;
+    }
+
+    const double radius = filter == ResampleFilter::Cubic ? 2.0 : 1.0;
+    const double stretch = std::max(1.0, 1.0 / scale); // widen the kernel when shrinking
+    const double support = radius * stretch;
+    out.taps = (int)std::min<unsigned long>((unsigned long)std::ceil(2.0 * support) + 1, srcSize);
+    out.weights.assign((size_t)dstSize * out.taps, 0);
+
+    std::vector<double> accum(out.taps);
+    for (unsigned long i = 0; i < dstSize; ++i) {
+        const double center = (i + 0.5) / scale - 0.5;
+        const long left = (long)std::floor(center - support) + 1;
+        const long right = (long)std::floor(center + support);
+        const long first = std::max(0L, left);
+        const unsigned long start = std::min((unsigned long)first, srcSize - out.taps);
+        out.start[i] = start;
+
+        std::fill(accum.begin(), accum.end(), 0.0);
+        double total = 0.0;
+        for (long j = left; j <= right; ++j) {
+            const double x = (j - center) / stretch;
+            const double w = filter == ResampleFilter::Cubic ? catmullRom(x) : triangle(x);
+            const long clamped = std::min(std::max(j, 0L), (long)srcSize - 1);
+            accum[clamped - start] += w;
+            total += w;
+        }
+
+        // Quantize and put the rounding error on the largest tap so the sum is exact
+        Sint16* weights = &out.weights[(size_t)i * out.taps];
+        int sum = 0, largest = 0;
+        for (int t = 0; t < out.taps; ++t) {
+            weights[t] = (Sint16)std::lround(accum[t] / total * (1 << kWeightBits));
+            sum += weights[t];
+            if (weights[t] > weights[largest]) largest = t;
+        }
+        weights[largest] = (Sint16)(weights[largest] + ((1 << kWeightBits) - sum));
+    }
+}
+
+// Horizontal pass: one source row into one Sint16 intermediate row
+void resampleRow(const Uint8* src, Sint16* dst, unsigned long dstWidth, int channels,
+                 const Contributions& horizontal) {
+    const int taps = horizontal.taps;
+    for (unsigned long x = 0; x < dstWidth; ++x) {
+        const Uint8* in = src + horizontal.start[x] * channels;
+        const Sint16* weights = &horizontal.weights[(size_t)x * taps];
+        for (int c = 0; c < channels; ++c) {
+            int acc = 1 << (kHorizontalShift - 1);
+            for (int t = 0; t < taps; ++t) acc += in[t * channels + c] * weights[t];
+            dst[x * channels + c] = (Sint16)(acc >> kHorizontalShift);
+        }
+    }
+}
+
+// Vertical pass: contiguous multiply-accumulate over whole rows, then clamp
+void resampleColumn(const Sint16* intermediate, size_t rowLength, Uint8* dst,
+                    const Contributions& vertical, unsigned long y, std::vector<int>& acc) {
+    const int taps = vertical.taps;
+    const Sint16* weights = &vertical.weights[(size_t)y * taps];
+    const Sint16* first = intermediate + vertical.start[y] * rowLength;
+
+    std::fill(acc.begin(), acc.end(), 1 << (kVerticalShift - 1));
+    for (int t = 0; t < taps; ++t) {
+        const Sint16* row = first + (size_t)t * rowLength;
+        const int w = weights[t];
+        for (size_t i = 0; i < rowLength; ++i) acc[i] += row[i] * w;
+    }
+    for (size_t i = 0; i < rowLength; ++i) {
+        const int value = acc[i] >> kVerticalShift;
+        dst[i] = (Uint8)(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+}
+
+void forEachBand(ThreadPool* pool, unsigned long rows,
+                 const std::function<void(unsigned long, unsigned long)>& fn) {
+    const size_t bands = (rows + kRowsPerBand - 1) / kRowsPerBand;
+    auto band = [&](size_t b) {
+        const unsigned long begin = (unsigned long)b * kRowsPerBand;
+        fn(begin, std::min(rows, begin + kRowsPerBand));
+    };
+    if (pool) pool->parallelFor(bands, band);
+    else for (size_t b = 0; b < bands; ++b) band(b);
+}
+
+} // namespace
+
+ResampleFilter resampleFilterFor(const std::string& magnificationType) {
+    if (magnificationType == "REPLICATE" || magnificationType == "NONE") return ResampleFilter::Replicate;
+    if (magnificationType == "BILINEAR") return ResampleFilter::Bilinear;
+    return ResampleFilter::Cubic; // printer default for empty or unknown values
+}
+
+bool resample8(const Uint8* src, unsigned long srcWidth, unsigned long srcHeight, size_t srcStride,
+               Uint8* dst, unsigned long dstWidth, unsigned long dstHeight, size_t dstStride,
+               int channels, ResampleFilter filter, ThreadPool* pool) {
+    if (!src || !dst || srcWidth == 0 || srcHeight == 0 || dstWidth == 0 || dstHeight == 0 ||
+        (channels != 1 && channels != 3))
+        return false;
+
+    Contributions horizontal, vertical;
+    computeContributions(srcWidth, dstWidth, filter, horizontal);
+    computeContributions(srcHeight, dstHeight, filter, vertical);
+
+    // Horizontal pass over every source row, banded across the pool
+    const size_t rowLength = (size_t)dstWidth * channels;
+    PooledBytes intermediateBytes;
+    if (!intermediateBytes.allocate(rowLength * srcHeight * sizeof(Sint16))) return false;
+    Sint16* intermediate = intermediateBytes.as<Sint16>();
+    forEachBand(pool, srcHeight, [&](unsigned long begin, unsigned long end) {
+        for (unsigned long y = begin; y < end; ++y)
+            resampleRow(src + y * srcStride, intermediate + y * rowLength, dstWidth, channels, horizontal);
+    });
+
+    // Vertical pass, one accumulator row per band
+    forEachBand(pool, dstHeight, [&](unsigned long begin, unsigned long end) {
+        std::vector<int> acc(rowLength);
+        for (unsigned long y = begin; y < end; ++y)
+            resampleColumn(intermediate, rowLength, dst + y * dstStride, vertical, y, acc);
+    });
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/ofstd/oftypes.h>
+
+class ThreadPool;
+
+/**
+ * @brief مرشحات إعادة التحجيم المقابلة لقيم Magnification Type
+ */
+enum class ResampleFilter {
+    Replicate, ///< REPLICATE / NONE: تكرار أقرب بكسل
+    Bilinear,  ///< BILINEAR: مرشح مثلثي
+    Cubic      ///< CUBIC: Catmull-Rom (a = -0.5)
+};
+
+/**
+ * @brief اختيار المرشح من Magnification Type (فارغ أو غير معروف = CUBIC)
+ */
+ResampleFilter resampleFilterFor(const std::string& magnificationType);
+
+/**
+ * @brief إعادة تحجيم صورة 8bit (رمادي أو R G B متداخل) إلى أبعاد محددة
+ *
+ * التحجيم منفصل (أفقي ثم عمودي) بأوزان ثابتة الفاصلة محسوبة مرة واحدة لكل
+ * محور. عند التصغير يتسع المرشح بنسبة التصغير لتجنب التشوه (aliasing).
+ * كل مرحلة تُقسم إلى شرائح أسطر تعمل في خيوط pool، والحلقة الداخلية للمرحلة
+ * العمودية متصلة في الذاكرة ليحولها المترجم إلى تعليمات SIMD.
+ *
+ * @param channels 1 (رمادي) أو 3 (R G B)
+ * @param pool مجموعة الخيوط (nullptr = في الخيط الحالي)
+ * @return false إذا كانت الأبعاد أو عدد القنوات غير صالحة
+ */
+bool resample8(const Uint8* src, unsigned long srcWidth, unsigned long srcHeight, size_t srcStride,
+               Uint8* dst, unsigned long dstWidth, unsigned long dstHeight, size_t dstStride,
+               int channels, ResampleFilter filter, ThreadPool* pool);
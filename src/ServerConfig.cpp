@@ -0,0 +1,301 @@
+// ServerConfig.cpp
+#include "ServerConfig.h"
+#include "Logger.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcuid.h>
+#include <dcmtk/dcmnet/assoc.h>
+
+namespace {
+
+// Parse a non-negative integer option value; returns false on garbage.
+bool parseUnsigned(const char* text, unsigned& value) {
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(text, &end, 10);
+    if (end == text || *end != '\0') return false;
+    value = static_cast<unsigned>(parsed);
+    return true;
+}
+
+bool parseInt(const char* text, int& value) {
+    char* end = nullptr;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0') return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool parseBool(const char* text, bool& value) {
+    if (std::strcmp(text, "on") == 0 || std::strcmp(text, "1") == 0) value = true;
+    else if (std::strcmp(text, "off") == 0 || std::strcmp(text, "0") == 0) value = false;
+    else return false;
+    return true;
+}
+
+struct TransferSyntaxName {
+    const char* name;
+    const char* uid;
+};
+
+const TransferSyntaxName TRANSFER_SYNTAX_NAMES[] = {
+    { "deflate", UID_DeflatedExplicitVRLittleEndianTransferSyntax },
+    { "jpeg-ls", UID_JPEGLSLosslessTransferSyntax },
+    { "jpeg-lossless", UID_JPEGProcess14SV1TransferSyntax },
+    { "rle", UID_RLELosslessTransferSyntax },
+    { "explicit-le", UID_LittleEndianExplicitTransferSyntax },
+    { "implicit-le", UID_LittleEndianImplicitTransferSyntax },
+    { "explicit-be", UID_BigEndianExplicitTransferSyntax },
+    { nullptr, nullptr }
+};
+
+std::vector<std::string> splitList(const std::string& text, char separator) {
+    std::vector<std::string> items;
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = text.find(separator, begin);
+        if (end == std::string::npos) end = text.size();
+        if (end > begin) items.push_back(text.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return items;
+}
+
+} // namespace
+
+bool parseTransferSyntaxList(const std::string& list, std::vector<std::string>& uids) {
+    uids.clear();
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == std::string::npos) end = list.size();
+        const std::string item = list.substr(begin, end - begin);
+        begin = end + 1;
+        if (item.empty()) continue;
+
+        const char* uid = nullptr;
+        if (item[0] >= '0' && item[0] <= '9') {
+            uid = item.c_str();
+        } else {
+            for (int i = 0; TRANSFER_SYNTAX_NAMES[i].name != nullptr; i++) {
+                if (item == TRANSFER_SYNTAX_NAMES[i].name) uid = TRANSFER_SYNTAX_NAMES[i].uid;
+            }
+            if (!uid) {
+                std::cerr << "❌ Unknown transfer syntax: " << item << std::endl;
+                return false;
+            }
+#ifndef WITH_ZLIB
+            if (item == "deflate") continue; // DCMTK cannot inflate without zlib
+#endif
+        }
+        uids.push_back(uid);
+    }
+    return !uids.empty();
+}
+
+bool parsePrinterRoute(const std::string& spec, PrinterRoute& route) {
+    route = PrinterRoute();
+    // The name comes first and may be empty (default printer); Windows printer names never contain commas
+    const size_t comma = spec.find(',');
+    route.name = spec.substr(0, comma);
+    if (comma == std::string::npos) return true;
+
+    for (const std::string& option : splitList(spec.substr(comma + 1), ',')) {
+        const size_t equals = option.find('=');
+        const std::string key = option.substr(0, equals);
+        const std::string value = equals == std::string::npos ? std::string() : option.substr(equals + 1);
+        if (key == "ae") {
+            route.callingAETitles = splitList(value, '|');
+        } else if (key == "medium") {
+            route.mediumTypes = splitList(value, '|');
+        } else if (key == "film") {
+            route.filmSizes = splitList(value, '|');
+        } else if (key == "ppm") {
+            if (!parseUnsigned(value.c_str(), route.pagesPerMinute)) return false;
+        } else {
+            std::cerr << "❌ Unknown printer option: " << key << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options]\n"
+              << "  --aetitle <title>          AE title of this SCP (default DICOM_PRINT_SCP)\n"
+              << "  --port <n>                 TCP port to listen on (default 11112)\n"
+              << "  --workers <n>              association worker threads (default 4)\n"
+              << "  --max-associations <n>     concurrent association cap (default 16)\n"
+              << "  --poll-interval <sec>      max wait before checking for shutdown (default 1)\n"
+              << "  --processes <n>            worker processes sharing the port under a supervisor\n"
+              << "                             that restarts them (POSIX only, default 1)\n"
+              << "  --worker-memory <MB>       address space limit per worker process, 0 = off (default 0)\n"
+              << "  --idle-timeout <sec>       close idle associations after this (default 60)\n"
+              << "  --dimse-timeout <sec>      dataset receive timeout (default 30)\n"
+              << "  --transfer-syntaxes <list> accepted transfer syntaxes in preference order\n"
+              << "                             (deflate,jpeg-ls,jpeg-lossless,rle,explicit-le,\n"
+              << "                              implicit-le,explicit-be or UIDs)\n"
+              << "  --max-pdu <bytes>          max receive PDU, 4096-131072 (default 16384)\n"
+              << "  --tcp-nodelay <on|off>     disable Nagle's algorithm (default on)\n"
+              << "  --socket-buffer <KB>       socket send/receive buffer, 0 = DCMTK default\n"
+              << "  --spool-workers <n>        render/print worker threads (default 2)\n"
+              << "  --spool-queue <n>          max queued print jobs (default 32)\n"
+              << "  --spool-wait-ms <ms>       wait for a queue slot before failing (default 2000)\n"
+              << "  --render-threads <n>       tile render threads, 0 = all cores (default 0)\n"
+              << "  --dpi <n>                  composed page resolution (default 150)\n"
+              << "  --decode-memory <MB>       pre-decoded pixel data cap per job (default 512)\n"
+              << "  --decode-ahead <MB>        decode image boxes while the next one is received;\n"
+              << "                             cap for all associations, 0 = off (default 256)\n"
+              << "  --page-cache <MB>          rendered page cache size, 0 = off (default 256)\n"
+              << "  --memory-budget <MB>       render memory for all jobs; jobs over it wait, 0 = off (default 0);\n"
+              << "                             covers render buffers only, not the page cache or received datasets\n"
+              << "  --pool-idle-mb <MB>        idle render buffers kept for reuse (default 256)\n"
+              << "  --printer <spec>           add a printer to the pool (repeatable):\n"
+              << "                             name[,ae=A|B*][,medium=PAPER|BLUE FILM][,film=14INX17IN][,ppm=n]\n"
+              << "  --priority-aging <sec>     waiting this long raises a job one priority level,\n"
+              << "                             0 = off (default 60)\n"
+              << "  --spill-threshold <MB>     keep pixel data of larger datasets on disk until printed,\n"
+              << "                             0 = off (default 0); deflated datasets are inflated\n"
+              << "                             on disk first\n"
+              << "  --spill-dir <path>         directory for spilled datasets (default spill)\n"
+              << "  --output <gdi|file|stream|null>\n"
+              << "                             page output backend; stream = compressed print stream\n"
+              << "  --spool-dir <path>         directory for the file and stream backends (default spool)\n"
+              << "  --file-format <pnm|raw>    page file format (default pnm)\n"
+              << "  --stream-format <pwg|pdf>  stream backend format: PWG Raster or Flate PDF (default pwg)\n"
+              << "  --stream-device <target>   send streams to a device path or socket://host[:port]\n"
+              << "                             instead of one file per job in the spool directory\n"
+              << "  --stream-timeout <sec>     connect/send/lock timeout for the stream device (default 30)\n"
+              << "  --metrics-port <n>         Prometheus endpoint on 127.0.0.1, 0 = off (default 0)\n"
+              << "  --metrics-file <path>      also write metrics to this file periodically\n"
+              << "  --metrics-interval <sec>   metrics file interval (default 15)\n"
+              << "  --log-level <level>        trace, debug, info, warn, error or off (default info)\n"
+              << "  --log-file <path>          also write the log to this file\n"
+              << "  --log-console <on|off>     write the log to the console (default on)\n"
+              << "  --log-max-size <MB>        rotate the log file at this size, 0 = never (default 50)\n"
+              << "  --log-max-files <n>        rotated log files to keep (default 5)\n"
+              << "  --help                     show this help\n";
+}
+
+bool parseCommandLine(int argc, char* argv[], ServerConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool ok = true;
+
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) {
+            printUsage(argv[0]);
+            return false;
+        } else if (!value) {
+            std::cerr << "❌ Missing value for option: " << arg << std::endl;
+            return false;
+        } else if (std::strcmp(arg, "--aetitle") == 0) {
+            config.aeTitle = value;
+        } else if (std::strcmp(arg, "--port") == 0) {
+            ok = parseInt(value, config.port) && config.port > 0 && config.port < 65536;
+        } else if (std::strcmp(arg, "--workers") == 0) {
+            ok = parseUnsigned(value, config.workerThreads) && config.workerThreads > 0;
+        } else if (std::strcmp(arg, "--max-associations") == 0) {
+            ok = parseUnsigned(value, config.maxAssociations) && config.maxAssociations > 0;
+        } else if (std::strcmp(arg, "--poll-interval") == 0) {
+            ok = parseInt(value, config.pollInterval) && config.pollInterval > 0;
+        } else if (std::strcmp(arg, "--processes") == 0) {
+            ok = parseUnsigned(value, config.processes) && config.processes > 0;
+        } else if (std::strcmp(arg, "--worker-memory") == 0) {
+            ok = parseUnsigned(value, config.workerMemoryMB);
+        } else if (std::strcmp(arg, "--idle-timeout") == 0) {
+            ok = parseInt(value, config.idleTimeout) && config.idleTimeout > 0;
+        } else if (std::strcmp(arg, "--dimse-timeout") == 0) {
+            ok = parseInt(value, config.dimseTimeout) && config.dimseTimeout > 0;
+        } else if (std::strcmp(arg, "--transfer-syntaxes") == 0) {
+            std::vector<std::string> uids;
+            config.transferSyntaxes = value;
+            ok = parseTransferSyntaxList(config.transferSyntaxes, uids);
+        } else if (std::strcmp(arg, "--max-pdu") == 0) {
+            ok = parseUnsigned(value, config.maxPdu) &&
+                 config.maxPdu >= ASC_MINIMUMPDUSIZE && config.maxPdu <= ASC_MAXIMUMPDUSIZE;
+        } else if (std::strcmp(arg, "--tcp-nodelay") == 0) {
+            ok = parseBool(value, config.tcpNoDelay);
+        } else if (std::strcmp(arg, "--socket-buffer") == 0) {
+            ok = parseUnsigned(value, config.socketBufferKB) && config.socketBufferKB <= 65536;
+        } else if (std::strcmp(arg, "--spool-workers") == 0) {
+            ok = parseUnsigned(value, config.spoolWorkers) && config.spoolWorkers > 0;
+        } else if (std::strcmp(arg, "--spool-queue") == 0) {
+            ok = parseUnsigned(value, config.spoolQueueDepth) && config.spoolQueueDepth > 0;
+        } else if (std::strcmp(arg, "--spool-wait-ms") == 0) {
+            ok = parseUnsigned(value, config.spoolSubmitTimeoutMs);
+        } else if (std::strcmp(arg, "--render-threads") == 0) {
+            ok = parseUnsigned(value, config.renderThreads);
+        } else if (std::strcmp(arg, "--dpi") == 0) {
+            ok = parseUnsigned(value, config.printerDpi) && config.printerDpi >= 50 && config.printerDpi <= 1200;
+        } else if (std::strcmp(arg, "--decode-memory") == 0) {
+            ok = parseUnsigned(value, config.decodeMemoryMB);
+        } else if (std::strcmp(arg, "--decode-ahead") == 0) {
+            ok = parseUnsigned(value, config.decodeAheadMB);
+        } else if (std::strcmp(arg, "--page-cache") == 0) {
+            ok = parseUnsigned(value, config.pageCacheMB);
+        } else if (std::strcmp(arg, "--memory-budget") == 0) {
+            ok = parseUnsigned(value, config.memoryBudgetMB);
+        } else if (std::strcmp(arg, "--pool-idle-mb") == 0) {
+            ok = parseUnsigned(value, config.poolIdleMB);
+        } else if (std::strcmp(arg, "--printer") == 0) {
+            PrinterRoute route;
+            ok = parsePrinterRoute(value, route);
+            if (ok) config.printers.push_back(route);
+        } else if (std::strcmp(arg, "--priority-aging") == 0) {
+            ok = parseUnsigned(value, config.priorityAgingSec);
+        } else if (std::strcmp(arg, "--spill-threshold") == 0) {
+            ok = parseUnsigned(value, config.spillThresholdMB);
+        } else if (std::strcmp(arg, "--spill-dir") == 0) {
+            config.spillDirectory = value;
+            ok = !config.spillDirectory.empty();
+        } else if (std::strcmp(arg, "--output") == 0) {
+            config.outputBackend = value;
+            ok = config.outputBackend == "gdi" || config.outputBackend == "file" ||
+                 config.outputBackend == "stream" || config.outputBackend == "null";
+        } else if (std::strcmp(arg, "--metrics-port") == 0) {
+            ok = parseUnsigned(value, config.metricsPort) && config.metricsPort < 65536;
+        } else if (std::strcmp(arg, "--metrics-file") == 0) {
+            config.metricsFile = value;
+        } else if (std::strcmp(arg, "--metrics-interval") == 0) {
+            ok = parseUnsigned(value, config.metricsIntervalSec) && config.metricsIntervalSec > 0;
+        } else if (std::strcmp(arg, "--log-level") == 0) {
+            LogLevel level;
+            config.logLevel = value;
+            ok = parseLogLevel(config.logLevel, level);
+        } else if (std::strcmp(arg, "--log-file") == 0) {
+            config.logFile = value;
+        } else if (std::strcmp(arg, "--log-console") == 0) {
+            ok = parseBool(value, config.logConsole);
+        } else if (std::strcmp(arg, "--log-max-size") == 0) {
+            ok = parseUnsigned(value, config.logMaxSizeMB);
+        } else if (std::strcmp(arg, "--log-max-files") == 0) {
+            ok = parseUnsigned(value, config.logMaxFiles);
+        } else if (std::strcmp(arg, "--spool-dir") == 0) {
+            config.spoolDirectory = value;
+        } else if (std::strcmp(arg, "--file-format") == 0) {
+            config.rasterFileFormat = value;
+            ok = config.rasterFileFormat == "pnm" || config.rasterFileFormat == "raw";
+        } else if (std::strcmp(arg, "--stream-format") == 0) {
+            config.streamFormat = value;
+            ok = config.streamFormat == "pwg" || config.streamFormat == "pdf";
+        } else if (std::strcmp(arg, "--stream-device") == 0) {
+            config.streamDevice = value;
+        } else if (std::strcmp(arg, "--stream-timeout") == 0) {
+            ok = parseUnsigned(value, config.streamTimeoutSec) && config.streamTimeoutSec > 0;
+        } else {
+            std::cerr << "❌ Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+
+        if (!ok) {
+            std::cerr << "❌ Invalid value for " << arg << ": " << value << std::endl;
+            return false;
+        }
+        ++i; // consumed the value
+    }
+    return true;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @struct PrinterRoute
+ * @brief طابعة / جهاز أفلام في مجموعة الطباعة والمهام التي يقبلها
+ *        القوائم الفارغة تقبل أي قيمة، و "X*" تطابق كل ما يبدأ بـ X.
+ */
+struct PrinterRoute {
+    std::string name;                          ///< اسم الطابعة في النظام (فارغ = الافتراضية)
+    std::vector<std::string> callingAETitles;  ///< عناوين AE المرسلة المقبولة
+    std::vector<std::string> mediumTypes;      ///< Medium Type المقبولة (PAPER, BLUE FILM...)
+    std::vector<std::string> filmSizes;        ///< Film Size ID المقبولة (14INX17IN...)
+    unsigned pagesPerMinute = 0;               ///< السرعة التقديرية لموازنة الحمل (0 = غير معروفة)
+};
+
+/**
+ * @struct ServerConfig
+ * @brief إعدادات تشغيل خادم الطباعة (المنفذ، عنوان AE، عدد العمال...)
+ *        القيم الافتراضية تطابق السلوك السابق للخادم.
+ */
+struct ServerConfig {
+    std::string aeTitle = "DICOM_PRINT_SCP"; ///< عنوان AE الخاص بالخادم
+    int port = 11112;                        ///< منفذ الاستماع
+
+    unsigned workerThreads = 4;    ///< عدد خيوط العمال التي تعالج الاتصالات
+    unsigned maxAssociations = 16; ///< الحد الأقصى للاتصالات المتزامنة (قيد المعالجة + المنتظرة)
+    int pollInterval = 1;          ///< أقصى مدة انتظار (ثوانٍ) داخل الاستقبال قبل فحص طلب الإيقاف
+    unsigned processes = 1;        ///< عمليات عاملة تشترك في المنفذ تحت مشرف (1 = عملية واحدة، POSIX فقط)
+    unsigned workerMemoryMB = 0;   ///< حد الذاكرة الافتراضية لكل عملية عاملة (MB، 0 = بدون حد)
+
+    int idleTimeout = 60;  ///< إغلاق الاتصال بعد هذه المدة (ثوانٍ) دون أي رسالة DIMSE
+    int dimseTimeout = 30; ///< مهلة استلام Dataset بعد وصول الأمر (ثوانٍ)
+
+    /// صيغ النقل بترتيب الأفضلية (أسماء مختصرة أو UIDs مفصولة بفواصل)
+    std::string transferSyntaxes = "deflate,jpeg-ls,jpeg-lossless,rle,explicit-le,implicit-le,explicit-be";
+    unsigned maxPdu = 16384;       ///< أقصى حجم PDU للاستقبال (4096..131072)
+    bool tcpNoDelay = true;        ///< تعطيل Nagle (الافتراضي في DCMTK)
+    unsigned socketBufferKB = 0;   ///< حجم مخزن الإرسال/الاستقبال للمقبس (0 = افتراضي DCMTK 32KB)
+
+    unsigned spoolWorkers = 2;          ///< عدد خيوط العرض/الطباعة في طابور الطباعة
+    unsigned spoolQueueDepth = 32;      ///< أقصى عدد مهام منتظرة في الطابور
+    unsigned spoolSubmitTimeoutMs = 2000; ///< مدة انتظار مكان في الطابور قبل الرد بامتلائه
+    unsigned renderThreads = 0;         ///< خيوط عرض مربعات الصور (0 = عدد أنوية المعالج)
+    unsigned printerDpi = 150;          ///< دقة الصفحة المركبة (نقطة لكل بوصة)
+    unsigned decodeMemoryMB = 512;      ///< حد ذاكرة الإطارات المفكوكة مسبقاً لكل مهمة (MB)
+    unsigned decodeAheadMB = 256;       ///< حد الإطارات المفكوكة عند استلام Image Box في كل الاتصالات (MB، 0 = معطل)
+    unsigned pageCacheMB = 256;         ///< حجم ذاكرة الصفحات المركبة (MB، 0 = معطلة)
+    unsigned memoryBudgetMB = 0;        ///< حد ذاكرة العرض لكل المهام معاً؛ الزائد ينتظر (MB، 0 = بدون حد)
+                                        ///< يغطي مخازن العرض فقط، لا ذاكرة الصفحات ولا الـ Datasets المستلمة
+    unsigned poolIdleMB = 256;          ///< أقصى حجم لمخازن العرض الحرة المحفوظة للإعادة (MB، 0 = لا تُحفظ)
+    std::vector<PrinterRoute> printers; ///< مجموعة الطابعات (فارغة = الطابعة الافتراضية فقط)
+    unsigned priorityAgingSec = 60;     ///< كل فترة انتظار ترفع أولوية المهمة درجة (0 = بدون تقادم)
+    unsigned spillThresholdMB = 0;      ///< Dataset أكبر من هذا تبقى بكسلاته في ملف حتى الطباعة (MB، 0 = معطل)
+    std::string spillDirectory = "spill"; ///< مجلد ملفات التفريغ
+
+#ifdef _WIN32
+    std::string outputBackend = "gdi";  ///< مخرج الصفحات: gdi / file / stream / null
+#else
+    std::string outputBackend = "file";
+#endif
+    unsigned metricsPort = 0;             ///< منفذ HTTP المحلي للمقاييس (0 = معطل)
+    std::string metricsFile;              ///< ملف تُكتب فيه المقاييس دورياً (فارغ = معطل)
+    unsigned metricsIntervalSec = 15;     ///< فترة كتابة ملف المقاييس (ثوانٍ)
+
+    std::string logLevel = "info";        ///< trace / debug / info / warn / error / off
+    std::string logFile;                  ///< ملف السجل (فارغ = الشاشة فقط)
+    bool logConsole = true;               ///< كتابة السجل في الشاشة أيضاً
+    unsigned logMaxSizeMB = 50;           ///< تدوير ملف السجل عند هذا الحجم (0 = بدون تدوير)
+    unsigned logMaxFiles = 5;             ///< عدد ملفات السجل القديمة المحفوظة
+
+    std::string spoolDirectory = "spool"; ///< مجلد الصفحات لمخرج الملفات
+    std::string rasterFileFormat = "pnm"; ///< صيغة ملفات الصفحات: pnm (PGM/PPM) أو raw
+    std::string streamFormat = "pwg";     ///< صيغة مخرج stream: pwg (PWG Raster) أو pdf
+    std::string streamDevice;             ///< وجهة مخرج stream: مسار جهاز أو socket://host[:port] (فارغ = ملف لكل مهمة في مجلد التخزين)
+    unsigned streamTimeoutSec = 30;       ///< مهلة الاتصال والإرسال إلى جهاز stream (ثوانٍ)
+};
+
+/**
+ * @brief قراءة الإعدادات من سطر الأوامر
+ * @param argc عدد المعاملات
+ * @param argv المعاملات
+ * @param config الإعدادات التي سيتم تعديلها
+ * @return false إذا كان هناك معامل غير صالح أو طُلبت المساعدة
+ */
+bool parseCommandLine(int argc, char* argv[], ServerConfig& config);
+
+/**
+ * @brief تحويل قائمة صيغ النقل إلى UIDs بنفس الترتيب
+ *
+ * الأسماء المختصرة: deflate, jpeg-ls, jpeg-lossless, rle, explicit-le,
+ * implicit-le, explicit-be. أي عنصر يبدأ برقم يُعامل كـ UID.
+ * deflate يُتجاهل إذا بُنيت DCMTK دون zlib.
+ *
+ * @return false إذا كان هناك اسم غير معروف أو كانت القائمة فارغة
+ */
+bool parseTransferSyntaxList(const std::string& list, std::vector<std::string>& uids);
+
+/**
+ * @brief قراءة تعريف طابعة: name[,ae=A|B*][,medium=M|N][,film=F][,ppm=n]
+ * @return false إذا كان هناك مفتاح غير معروف أو قيمة غير صالحة
+ */
+bool parsePrinterRoute(const std::string& spec, PrinterRoute& route);
+
+/**
+ * @brief طباعة قائمة الخيارات المتاحة
+ */
+void printUsage(const char* programName);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class Sha256
+ * @brief SHA-256 (FIPS 180-4) لمفاتيح المحتوى: بصمة قوية لا تتصادم عملياً
+ *        حتى بين صور تختلف في بتات قليلة فقط
+ */
+class Sha256 {
+public:
+    static constexpr size_t kDigestBytes = 32;
+
+private:
+    uint32_t state_[8];
+    uint8_t block_[64];
+    size_t blockBytes_;  ///< البايتات المنتظرة في block_
+    uint64_t totalBytes_;
+
+public:
+    Sha256();
+
+    void update(const void* data, size_t length);
+
+    /**
+     * @brief إنهاء الحساب وكتابة البصمة (لا يُستخدم الكائن بعدها)
+     */
+    void finish(uint8_t digest[kDigestBytes]);
+
+private:
+    void compress(const uint8_t* block);
+};
@@ -0,0 +1,182 @@
+// Supervisor.cpp
+#include "Supervisor.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include <dcmtk/dcmnet/dul.h>
+
+namespace {
+
+// A worker that dies sooner than this after starting is crashing on startup
+const std::chrono::seconds kStableRun(10);
+const std::chrono::seconds kMaxBackoff(30);
+
+std::string describeExit(int status) {
+    if (WIFSIGNALED(status))
+        return "killed by signal " + std::to_string(WTERMSIG(status)) + " (" + strsignal(WTERMSIG(status)) + ")";
+    return "exited with code " + std::to_string(WEXITSTATUS(status));
+}
+
+} // namespace
+
+ServerConfig workerConfig(const ServerConfig& config, unsigned index) {
+    ServerConfig worker = config;
+    const std::string suffix = "." + std::to_string(index + 1);
+    if (worker.metricsPort) worker.metricsPort += index;
+    if (!worker.metricsFile.empty()) worker.metricsFile += suffix;
+    if (!worker.logFile.empty()) worker.logFile += suffix;
+    // Page files are named by job number, which each process counts on its own
+    worker.spoolDirectory =
+        (std::filesystem::path(config.spoolDirectory) / ("worker" + std::to_string(index + 1))).string();
+    return worker;
+}
+
+// -----------------------------
+// Supervisor Implementation
+// -----------------------------
+Supervisor::Supervisor(const ServerConfig& config)
+    : config_(config), network_(nullptr), listenSocket_(-1), workers_(config.processes) {
+    sigemptyset(&workerMask_);
+}
+
+Supervisor::~Supervisor() {
+    if (network_) ASC_dropNetwork(&network_);
+}
+
+int Supervisor::run(WorkerMain workerMain) {
+    // The supervisor never starts the log writer thread: it forks again on every
+    // restart, and a forked child only gets the thread that called fork()
+    LogLevel level;
+    if (parseLogLevel(config_.logLevel, level)) Logger::setLevel(level);
+
+    // Stop signals and SIGCHLD are taken synchronously in the loop below
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &signals, &workerMask_);
+
+    // Bound once here; every worker accepts on the same inherited socket, so a
+    // restarted worker never races anyone for the port
+    OFCondition cond = ASC_initializeNetwork(NET_ACCEPTOR, config_.port, 30, &network_);
+    if (cond.bad()) {
+        LOG_ERROR << "❌ Failed to initialize DCMTK network: " << cond.text();
+        return 1;
+    }
+    listenSocket_ = DUL_networkSocket(network_->network);
+
+    LOG_INFO << "🧩 Supervisor " << getpid() << ": " << workers_.size() << " worker processes on port "
+             << config_.port << ", memory limit "
+             << (config_.workerMemoryMB ? std::to_string(config_.workerMemoryMB) + " MB" : std::string("off"))
+             << " each";
+    for (size_t i = 0; i < workers_.size(); ++i) spawn(i, workerMain);
+
+    bool stopping = false;
+    while (true) {
+        timespec timeout = {1, 0};
+        const int signal = sigtimedwait(&signals, NULL, &timeout);
+        if ((signal == SIGINT || signal == SIGTERM) && !stopping) {
+            stopping = true;
+            LOG_INFO << "Received stop signal. Stopping worker processes...";
+            for (const Worker& worker : workers_) {
+                if (worker.pid) kill(worker.pid, SIGTERM);
+            }
+            // Wakes workers blocked in accept() on the shared socket
+            shutdown(listenSocket_, SHUT_RD);
+        }
+
+        reap(stopping);
+        if (stopping) {
+            bool anyRunning = false;
+            for (const Worker& worker : workers_) anyRunning = anyRunning || worker.pid != 0;
+            if (!anyRunning) break;
+            continue;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            if (!workers_[i].pid && now >= workers_[i].restartAt) spawn(i, workerMain);
+        }
+    }
+
+    ASC_dropNetwork(&network_);
+    network_ = nullptr;
+    LOG_INFO << "👋 Supervisor stopped.";
+    return 0;
+}
+
+bool Supervisor::spawn(size_t index, WorkerMain workerMain) {
+    Worker& worker = workers_[index];
+    const pid_t supervisorPid = getpid();
+    // Console log lines still buffered would otherwise be written again by the child
+    std::fflush(NULL);
+    const pid_t pid = fork();
+    if (pid < 0) {
+        LOG_ERROR << "❌ Cannot start worker process " << index + 1 << ": " << strerror(errno);
+        worker.restartAt = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        return false;
+    }
+
+    if (pid == 0) {
+        sigprocmask(SIG_SETMASK, &workerMask_, NULL);
+#ifdef __linux__
+        // A worker never outlives the supervisor that owns the port
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (getppid() != supervisorPid) std::_Exit(1);
+#endif
+        if (config_.workerMemoryMB) {
+            rlimit limit;
+            limit.rlim_cur = limit.rlim_max = (rlim_t)config_.workerMemoryMB * 1024 * 1024;
+            if (setrlimit(RLIMIT_AS, &limit) != 0)
+                LOG_WARN << "⚠ Cannot limit worker memory: " << strerror(errno);
+        }
+        const ServerConfig config = workerConfig(config_, (unsigned)index);
+        std::exit(workerMain(config, network_));
+    }
+
+    worker.pid = pid;
+    worker.startedAt = std::chrono::steady_clock::now();
+    LOG_INFO << "👷 Worker process " << index + 1 << " started (pid " << pid << ")";
+    return true;
+}
+
+void Supervisor::reap(bool stopping) {
+    int status = 0;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            Worker& worker = workers_[i];
+            if (worker.pid != pid) continue;
+            worker.pid = 0;
+            if (stopping) {
+                LOG_INFO << "Worker process " << i + 1 << " " << describeExit(status);
+                break;
+            }
+
+            // Restart at once after a long run; back off when it keeps dying at startup
+            const auto now = std::chrono::steady_clock::now();
+            if (now - worker.startedAt >= kStableRun) worker.backoff = std::chrono::seconds(0);
+            else worker.backoff = std::min(kMaxBackoff, std::max(std::chrono::seconds(1), worker.backoff * 2));
+            worker.restartAt = now + worker.backoff;
+            ++worker.restarts;
+            LOG_ERROR << "💥 Worker process " << i + 1 << " (pid " << pid << ") " << describeExit(status)
+                      << ", restart #" << worker.restarts << " in " << worker.backoff.count() << " s";
+            break;
+        }
+    }
+}
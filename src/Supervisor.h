@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <csignal>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmnet/assoc.h>
+
+#include "ServerConfig.h"
+
+/**
+ * @class Supervisor
+ * @brief وضع العمليات المتعددة (POSIX فقط): عملية مشرفة تفتح منفذ الاستماع مرة
+ *        واحدة ثم تنشئ N عملية عاملة ترثه، كل منها خادم كامل بطابور طباعة خاص به.
+ *
+ * النواة تسلم كل اتصال جديد إلى عملية واحدة من العمليات المنتظرة عليه، فتتوزع
+ * الاتصالات على الأنوية. تعطل عملية (مثلاً Dataset يكسر فك الترميز) لا يقطع إلا
+ * اتصالاتها، والمشرف يعيد تشغيلها (مع تأخير متزايد إذا تكرر التعطل عند البدء).
+ * لكل عملية حد ذاكرة خاص بها (RLIMIT_AS).
+ */
+class Supervisor {
+public:
+    /// دالة العملية العاملة: تخدم الاتصالات على الشبكة الموروثة حتى الإيقاف وتعيد رمز الخروج
+    typedef int (*WorkerMain)(const ServerConfig& config, T_ASC_Network* network);
+
+private:
+    struct Worker {
+        pid_t pid = 0;                                   ///< 0 = لا تعمل
+        std::chrono::steady_clock::time_point startedAt;
+        std::chrono::steady_clock::time_point restartAt; ///< موعد إعادة التشغيل بعد الخروج
+        std::chrono::seconds backoff{0};                 ///< يتضاعف مع كل تعطل سريع
+        unsigned long restarts = 0;
+    };
+
+    const ServerConfig& config_;
+    T_ASC_Network* network_;      ///< شبكة DCMTK المستمعة المشتركة مع العمليات
+    int listenSocket_;
+    sigset_t workerMask_;         ///< قناع الإشارات الأصلي الذي تبدأ به العمليات
+    std::vector<Worker> workers_;
+
+public:
+    explicit Supervisor(const ServerConfig& config);
+    ~Supervisor();
+
+    Supervisor(const Supervisor&) = delete;
+    Supervisor& operator=(const Supervisor&) = delete;
+
+    /**
+     * @brief فتح المنفذ وتشغيل العمليات ومراقبتها حتى SIGINT / SIGTERM
+     *
+     * عند الإيقاف تُرسل SIGTERM إلى كل العمليات وينتظر المشرف حتى تنهي اتصالاتها
+     * وتطبع ما في طوابيرها.
+     *
+     * @return رمز خروج المشرف (العملية العاملة لا تعود من هنا بل تنتهي بـ exit)
+     */
+    int run(WorkerMain workerMain);
+
+private:
+    /**
+     * @brief إنشاء العملية رقم index
+     */
+    bool spawn(size_t index, WorkerMain workerMain);
+
+    /**
+     * @brief جمع العمليات المنتهية وجدولة إعادة تشغيلها (إلا أثناء الإيقاف)
+     */
+    void reap(bool stopping);
+};
+
+/**
+ * @brief إعدادات العملية العاملة رقم index (من 0): منفذ المقاييس وملفات السجل
+ *        والمقاييس ومجلد الصفحات تصبح خاصة بها حتى لا تتعارض العمليات
+ */
+ServerConfig workerConfig(const ServerConfig& config, unsigned index);
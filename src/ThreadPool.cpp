@@ -0,0 +1,87 @@
+// ThreadPool.cpp
+#include "ThreadPool.h"
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threadCount) : stopping_(false) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 2;
+    for (unsigned i = 0; i < threadCount; ++i)
+        threads_.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    for (std::thread& thread : threads_) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+void ThreadPool::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    cond_.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) return; // stopping and drained
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    if (count == 1 || threads_.empty()) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    // Shared state outlives this call: helpers that start after all items are
+    // done see next >= count and exit without touching fn.
+    struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+    const std::function<void(size_t)>* body = &fn;
+
+    // Helpers log under the caller's association/job IDs
+    const LogContext context = Logger::context();
+    auto runItems = [state, body, count, context]() {
+        LogScope scope(context);
+        size_t i;
+        while ((i = state->next.fetch_add(1)) < count) {
+            (*body)(i);
+            if (state->done.fetch_add(1) + 1 == count) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->cond.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min(count - 1, threads_.size());
+    for (size_t h = 0; h < helpers; ++h) post(runItems);
+
+    runItems(); // the caller works too
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cond.wait(lock, [&] { return state->done.load() == count; });
+}
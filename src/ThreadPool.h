@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief مجموعة خيوط ثابتة مشتركة لمهام العرض المتوازية (المربعات، فك الضغط...)
+ *
+ * parallelFor يشارك فيه الخيط المستدعي أيضاً، لذلك يمكن استدعاؤه من داخل مهمة
+ * تعمل في نفس المجموعة دون خطر الانسداد (deadlock).
+ */
+class ThreadPool {
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::function<void()>> tasks_; ///< المهام المنتظرة
+    std::vector<std::thread> threads_;
+    bool stopping_;
+
+public:
+    /**
+     * @param threadCount عدد الخيوط (0 = عدد أنوية المعالج)
+     */
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return (unsigned)threads_.size(); }
+
+    /**
+     * @brief إضافة مهمة مستقلة إلى الطابور
+     */
+    void post(std::function<void()> task);
+
+    /**
+     * @brief تنفيذ fn(i) لكل i في [0, count) بالتوازي والانتظار حتى انتهاء الجميع
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    void workerLoop();
+};
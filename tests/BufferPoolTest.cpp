@@ -0,0 +1,111 @@
+// BufferPoolTest.cpp
+// Size classes and reuse, the idle cap and trim, and the global budget under load
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BufferPool.h"
+#include "TestUtil.h"
+
+namespace {
+
+const size_t kMB = 1024 * 1024;
+
+// Reads the value of one metric line from the Prometheus text
+double metric(const std::string& name) {
+    std::string out;
+    BufferPool::instance().appendMetrics(out);
+    const size_t pos = out.find("\n" + name + " ");
+    return pos == std::string::npos ? -1.0 : std::stod(out.substr(pos + name.size() + 2));
+}
+
+void testSizeClasses() {
+    PooledBytes small(1000);
+    CHECK(small.capacity() == 64 * 1024);
+    PooledBytes large(5 * kMB);
+    CHECK(large.capacity() >= 5 * kMB && large.capacity() <= 5 * kMB + 5 * kMB / 8);
+
+    // A smaller request reuses the buffer in place
+    CHECK(large.allocate(kMB));
+    CHECK(large.size() == kMB && large.capacity() >= 5 * kMB);
+}
+
+void testReuse() {
+    const double misses = metric("dicom_print_buffer_pool_misses_total");
+    { PooledBytes a(3 * kMB); }
+    { PooledBytes b(3 * kMB); }
+    CHECK(metric("dicom_print_buffer_pool_misses_total") == misses + 1);
+}
+
+void testIdleLimit() {
+    BufferPool& pool = BufferPool::instance();
+    pool.trim();
+    pool.setIdleLimit(8 * kMB);
+    {
+        std::vector<PooledBytes> buffers;
+        for (int i = 0; i < 6; ++i) buffers.emplace_back(3 * kMB);
+    }
+    // Without a budget only what fits under the idle limit stays pooled
+    CHECK(metric("dicom_print_buffer_pool_free_bytes") <= 8.0 * kMB);
+    CHECK(metric("dicom_print_buffer_pool_free_bytes") > 0);
+
+    // Classes untouched for longer than maxAge are freed, fresh ones kept
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    { PooledBytes recent(200 * 1024); }
+    pool.trimIdle(std::chrono::milliseconds(10));
+    const double kept = metric("dicom_print_buffer_pool_free_bytes");
+    CHECK(kept > 0 && kept < kMB);
+
+    pool.setIdleLimit(0);
+    CHECK(metric("dicom_print_buffer_pool_free_bytes") == 0);
+    { PooledBytes notKept(kMB); }
+    CHECK(metric("dicom_print_buffer_pool_free_bytes") == 0);
+    pool.setIdleLimit(256 * kMB);
+}
+
+void testBudget() {
+    BufferPool& pool = BufferPool::instance();
+    pool.setBudget(64 * kMB);
+
+    // At most two 30 MB jobs fit in 64 MB at the same time
+    std::atomic<int> running(0), peak(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 20; ++i) {
+                BufferPool::Reservation memory = pool.reserve(30 * kMB);
+                const int now = ++running;
+                int seen = peak;
+                while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+                PooledBytes page((size_t)(10 + t) * kMB);
+                page.data()[0] = 1;
+                PooledBytes tile(3 * kMB);
+                --running;
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    CHECK(peak <= 2);
+    CHECK(metric("dicom_print_memory_reserved_bytes") == 0);
+    CHECK(metric("dicom_print_buffer_pool_free_bytes") <= 64.0 * kMB);
+
+    // Larger than the whole budget: clamped so it runs alone instead of never
+    {
+        BufferPool::Reservation big = pool.reserve(500 * kMB);
+        CHECK(big.bytes() == 64 * kMB);
+    }
+    pool.setBudget(0);
+    CHECK(pool.reserve(500 * kMB).bytes() == 0);
+}
+
+} // namespace
+
+int main() {
+    testSizeClasses();
+    testReuse();
+    testIdleLimit();
+    testBudget();
+    return TestUtil::result("BufferPoolTest");
+}
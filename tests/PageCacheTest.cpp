@@ -0,0 +1,93 @@
+// PageCacheTest.cpp
+// SHA-256 against the FIPS 180-4 vectors, and cache hits on the full key only
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "PageBuffer.h"
+#include "PageCache.h"
+#include "Sha256.h"
+#include "TestUtil.h"
+
+namespace {
+
+std::string hex(const uint8_t* bytes, size_t count) {
+    static const char kDigits[] = "0123456789abcdef";
+    std::string out;
+    for (size_t i = 0; i < count; ++i) {
+        out += kDigits[bytes[i] >> 4];
+        out += kDigits[bytes[i] & 15];
+    }
+    return out;
+}
+
+std::string sha256(const std::string& message, size_t chunk) {
+    Sha256 sha;
+    for (size_t i = 0; i < message.size(); i += chunk)
+        sha.update(message.data() + i, std::min(chunk, message.size() - i));
+    uint8_t digest[Sha256::kDigestBytes];
+    sha.finish(digest);
+    return hex(digest, sizeof(digest));
+}
+
+void testSha256() {
+    CHECK(sha256("", 1) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    CHECK(sha256("abc", 1) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    const std::string twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    CHECK(sha256(twoBlocks, twoBlocks.size()) ==
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    // Split points must not matter
+    const std::string million(1000000, 'a');
+    for (size_t chunk : {(size_t)1000000, (size_t)63, (size_t)64, (size_t)65, (size_t)4096})
+        CHECK(sha256(million, chunk) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+    // The case a 64-bit word fold cannot tell apart: 0x80 flipped in bytes 7 and 15
+    std::string a(16, '\x10'), b = a;
+    b[7] ^= (char)0x80;
+    b[15] ^= (char)0x80;
+    CHECK(sha256(a, 16) != sha256(b, 16));
+}
+
+bool fillPage(PageBuffer& page, Uint8 value) {
+    if (!page.allocate(64, 32, 8, RasterLayout())) return false;
+    std::memset(page.data(), value, page.size());
+    return true;
+}
+
+void testPageCache() {
+    PageBuffer first, second;
+    CHECK(fillPage(first, 1));
+    CHECK(fillPage(second, 2));
+
+    // Keys that share everything but the last byte are different pages
+    const std::string keyA = std::string(40, 'k') + 'A';
+    const std::string keyB = std::string(40, 'k') + 'B';
+    PageCache cache(first.size() * 2);
+    cache.insert(keyA, first);
+    CHECK(!cache.find(keyB));
+    cache.insert(keyB, second);
+
+    PageCache::PagePtr hit = cache.find(keyA);
+    CHECK(hit && hit->pixels.size() == first.size() && hit->pixels[0] == 1);
+    hit = cache.find(keyB);
+    CHECK(hit && hit->pixels[0] == 2);
+    CHECK(cache.hits() == 2 && cache.misses() == 1);
+
+    // A third page evicts the least recently used one (A)
+    PageBuffer third;
+    CHECK(fillPage(third, 3));
+    cache.insert(std::string(41, 'k'), third);
+    CHECK(!cache.find(keyA));
+    CHECK(cache.find(keyB));
+    CHECK(cache.evictions() == 1);
+    CHECK(cache.usedBytes() == first.size() * 2);
+}
+
+} // namespace
+
+int main() {
+    testSha256();
+    testPageCache();
+    return TestUtil::result("PageCacheTest");
+}
@@ -0,0 +1,106 @@
+// PixelKernelsTest.cpp
+// Every dispatch level must match the scalar kernels byte for byte
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "PixelKernels.h"
+#include "TestUtil.h"
+
+using namespace PixelKernels;
+
+namespace {
+
+std::mt19937 g_random(20240517);
+
+std::vector<uint8_t> randomBytes(size_t count) {
+    std::vector<uint8_t> bytes(count);
+    for (uint8_t& b : bytes) b = (uint8_t)g_random();
+    return bytes;
+}
+
+// Reference for convertStride: rows copied, padding zeroed
+std::vector<uint8_t> restride(const uint8_t* src, size_t srcStride, size_t dstStride, size_t rowBytes,
+                              size_t height) {
+    std::vector<uint8_t> out(dstStride * height, 0);
+    for (size_t y = 0; y < height; ++y) std::memcpy(&out[y * dstStride], src + y * srcStride, rowBytes);
+    return out;
+}
+
+void testInvert() {
+    // Lengths around every vector width and its tail
+    for (size_t n = 0; n < 300; ++n) {
+        const std::vector<uint8_t> src = randomBytes(n);
+        std::vector<uint8_t> expected(n), out(n, 0xAA);
+        scalar::invert8(src.data(), expected.data(), n);
+        invert8(src.data(), out.data(), n);
+        CHECK(out == expected);
+
+        std::vector<uint8_t> inPlace = src;
+        invert8(inPlace.data(), inPlace.data(), n);
+        CHECK(inPlace == expected);
+
+        // Unaligned source and destination
+        std::vector<uint8_t> shifted(n + 1), shiftedOut(n + 3);
+        if (n == 0) continue;
+        std::memcpy(shifted.data() + 1, src.data(), n);
+        invert8(shifted.data() + 1, shiftedOut.data() + 3, n);
+        CHECK(std::memcmp(shiftedOut.data() + 3, expected.data(), n) == 0);
+    }
+}
+
+void testSwizzle() {
+    for (size_t width = 1; width < 70; ++width) {
+        for (size_t height = 1; height < 4; ++height) {
+            const size_t srcStride = width * 3 + (width % 5); // odd padding on the source
+            const size_t dstStride = dibStride(width * 3);
+            const std::vector<uint8_t> src = randomBytes(srcStride * height);
+
+            std::vector<uint8_t> expected(dstStride * height, 0x55), out(dstStride * height, 0xAA);
+            scalar::swizzleRGBtoBGR(src.data(), srcStride, expected.data(), dstStride, width, height);
+            swizzleRGBtoBGR(src.data(), srcStride, out.data(), dstStride, width, height);
+            CHECK(out == expected);
+
+            // R and B really are swapped, and the DIB padding is zero
+            for (size_t y = 0; y < height; ++y) {
+                CHECK(out[y * dstStride] == src[y * srcStride + 2]);
+                CHECK(out[y * dstStride + 2] == src[y * srcStride]);
+                for (size_t x = width * 3; x < dstStride; ++x) CHECK(out[y * dstStride + x] == 0);
+            }
+
+            std::vector<uint8_t> inPlace = src, inPlaceExpected(src.size());
+            scalar::swizzleRGBtoBGR(src.data(), srcStride, inPlaceExpected.data(), srcStride, width, height);
+            swizzleRGBtoBGR(inPlace.data(), srcStride, inPlace.data(), srcStride, width, height);
+            CHECK(inPlace == inPlaceExpected);
+        }
+    }
+}
+
+void testConvertStride() {
+    for (size_t rowBytes = 1; rowBytes < 40; rowBytes += 3) {
+        for (size_t srcStride = rowBytes; srcStride < rowBytes + 5; ++srcStride) {
+            for (size_t dstStride = rowBytes; dstStride < rowBytes + 6; dstStride += 1) {
+                const size_t height = 1 + rowBytes % 4;
+                const std::vector<uint8_t> src = randomBytes(srcStride * height);
+                std::vector<uint8_t> out(dstStride * height, 0xAA);
+                convertStride(src.data(), srcStride, out.data(), dstStride, rowBytes, height);
+                CHECK(out == restride(src.data(), srcStride, dstStride, rowBytes, height));
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    // Highest level first; setMaxIsa never goes above what the CPU supports
+    const IsaLevel levels[] = {IsaLevel::AVX2, IsaLevel::SSSE3, IsaLevel::SSE2, IsaLevel::Scalar};
+    for (IsaLevel level : levels) {
+        setMaxIsa(level);
+        std::printf("dispatch level %s\n", activeIsaName());
+        testInvert();
+        testSwizzle();
+        testConvertStride();
+    }
+    return TestUtil::result("PixelKernelsTest");
+}
@@ -0,0 +1,95 @@
+// PrintSchedulerTest.cpp
+// Printer spec parsing, routing to the least loaded eligible printer, priority and aging
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "PrintScheduler.h"
+#include "TestUtil.h"
+
+namespace {
+
+std::unique_ptr<PrintJob> makeJob(unsigned long id, const char* callingAE, PrintPriority priority, int pages,
+                                  const char* medium = "BLUE FILM") {
+    std::unique_ptr<PrintJob> job(new PrintJob());
+    job->id = id;
+    job->callingAE = callingAE;
+    job->priority = priority;
+    job->mediumType = medium;
+    job->pages.resize(pages);
+    for (FilmPage& page : job->pages) page.film.filmSizeID = "14INX17IN";
+    job->enqueuedAt = std::chrono::steady_clock::now();
+    return job;
+}
+
+void testParsePrinterRoute() {
+    PrinterRoute route;
+    CHECK(parsePrinterRoute("Dry1,ae=CT*|MR1,film=14INX17IN|8INX10IN,ppm=2", route));
+    CHECK(route.name == "Dry1");
+    CHECK(route.callingAETitles.size() == 2);
+    CHECK(route.pagesPerMinute == 2);
+    CHECK(!parsePrinterRoute("X,bogus=1", route));
+}
+
+void testRouting() {
+    ServerConfig config;
+    PrinterRoute route;
+    CHECK(parsePrinterRoute("Dry1,ae=CT*|MR1,film=14INX17IN|8INX10IN,ppm=2", route));
+    config.printers.push_back(route);
+    CHECK(parsePrinterRoute("Dry2,ae=CT*|ER*,ppm=4", route));
+    config.printers.push_back(route);
+    CHECK(parsePrinterRoute("Paper,medium=PAPER", route));
+    config.printers.push_back(route);
+    config.priorityAgingSec = 1;
+    PrintScheduler scheduler(config);
+
+    // Both dry printers take CT; the long job goes to the faster one, the next to the idle one
+    std::unique_ptr<PrintJob> longJob = makeJob(1, "CT_A", PrintPriority::Med, 40);
+    CHECK(scheduler.route(*longJob));
+    CHECK(longJob->printerName == "Dry2");
+    scheduler.push(std::move(longJob));
+
+    std::unique_ptr<PrintJob> shortJob = makeJob(2, "CT_A", PrintPriority::Med, 2);
+    CHECK(scheduler.route(*shortJob));
+    CHECK(shortJob->printerName == "Dry1");
+    scheduler.push(std::move(shortJob));
+
+    std::unique_ptr<PrintJob> urgent = makeJob(3, "ER_1", PrintPriority::High, 1);
+    CHECK(scheduler.route(*urgent));
+    CHECK(urgent->printerName == "Dry2");
+    scheduler.push(std::move(urgent));
+
+    // No printer accepts this AE on film
+    std::unique_ptr<PrintJob> rejected = makeJob(4, "US_1", PrintPriority::Low, 1);
+    CHECK(!scheduler.route(*rejected));
+    CHECK(scheduler.size() == 3);
+
+    // High priority is served first
+    std::unique_ptr<PrintJob> first = scheduler.pop();
+    CHECK(first && first->id == 3);
+
+    // A low priority job that waited past two aging periods overtakes the medium ones
+    std::unique_ptr<PrintJob> aged = makeJob(5, "MR1", PrintPriority::Low, 1, "");
+    aged->enqueuedAt -= std::chrono::seconds(3);
+    CHECK(scheduler.route(*aged));
+    scheduler.push(std::move(aged));
+    std::unique_ptr<PrintJob> second = scheduler.pop();
+    CHECK(second && second->id == 5);
+
+    scheduler.finished(*first);
+    scheduler.finished(*second);
+    CHECK(scheduler.size() == 2);
+
+    std::string out;
+    scheduler.appendMetrics(out);
+    CHECK(out.find("dicom_print_printer_queued_jobs{printer=\"Dry1\"} 1") != std::string::npos);
+    CHECK(out.find("dicom_print_printer_pending_sheets{printer=\"Dry2\"} 40") != std::string::npos);
+}
+
+} // namespace
+
+int main() {
+    testParsePrinterRoute();
+    testRouting();
+    return TestUtil::result("PrintSchedulerTest");
+}
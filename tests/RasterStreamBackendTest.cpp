@@ -0,0 +1,330 @@
+// RasterStreamBackendTest.cpp
+// PWG and PDF streams decoded back to the page pixels, and device timeouts failing the document
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "RasterStreamBackend.h"
+#include "TestUtil.h"
+#include "ThreadPool.h"
+
+namespace {
+
+const unsigned long kWidth = 601;
+const unsigned long kHeight = 403;
+const unsigned kDpi = 300;
+
+// Gray page with blank margins, a solid band and noise; BGR page on a padded stride
+struct TestPages {
+    size_t bgrStride = kWidth * 3 + 7;
+    std::vector<Uint8> gray;
+    std::vector<Uint8> bgr;
+    std::vector<Uint8> rgb; ///< what the printer must see for the BGR page
+
+    TestPages() : gray(kWidth * kHeight), bgr(bgrStride * kHeight), rgb(kWidth * 3 * kHeight) {
+        std::srand(1);
+        for (unsigned long y = 0; y < kHeight; ++y) {
+            for (unsigned long x = 0; x < kWidth; ++x) {
+                Uint8 value = (x < 40 || y < 40 || y > 350) ? 0 : (Uint8)((x * 7 + y * 3) / 13 + std::rand() % 3);
+                if (y > 200 && y < 220) value = 255;
+                gray[y * kWidth + x] = value;
+
+                Uint8* pixel = &bgr[y * bgrStride + x * 3];
+                pixel[0] = (Uint8)x;
+                pixel[1] = (Uint8)(y / 8);
+                pixel[2] = x > 300 ? 200 : (Uint8)(std::rand() % 256);
+                Uint8* expected = &rgb[(y * kWidth + x) * 3];
+                expected[0] = pixel[2];
+                expected[1] = pixel[1];
+                expected[2] = pixel[0];
+            }
+        }
+    }
+
+    PageRaster grayPage() const {
+        PageRaster page;
+        page.data = gray.data();
+        page.width = kWidth;
+        page.height = kHeight;
+        page.stride = kWidth;
+        page.bitsPerPixel = 8;
+        return page;
+    }
+
+    PageRaster bgrPage() const {
+        PageRaster page;
+        page.data = bgr.data();
+        page.width = kWidth;
+        page.height = kHeight;
+        page.stride = bgrStride;
+        page.bitsPerPixel = 24;
+        page.bgr = true;
+        return page;
+    }
+};
+
+std::string readFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+uint32_t getU32(const std::string& data, size_t offset) {
+    const Uint8* bytes = reinterpret_cast<const Uint8*>(data.data() + offset);
+    return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | bytes[3];
+}
+
+// Writes gray, colour, gray as one job and returns the stream
+std::string writeJob(RasterStreamBackend& backend, const std::filesystem::path& directory,
+                     const TestPages& pages, const char* extension) {
+    PageInfo info;
+    info.jobId = 7;
+    info.dpi = kDpi;
+    std::unique_ptr<OutputDocument> document = backend.openDocument(info);
+    CHECK(document != nullptr);
+    if (!document) return std::string();
+    info.pageNumber = 1;
+    CHECK(document->printPage(pages.grayPage(), info));
+    info.pageNumber = 2;
+    CHECK(document->printPage(pages.bgrPage(), info));
+    info.pageNumber = 3;
+    CHECK(document->printPage(pages.grayPage(), info));
+    CHECK(document->finish());
+    return readFile(directory / (std::string("job000007.") + extension));
+}
+
+// PWG: 1796 byte page header, then per line group a repeat count and PackBits-like runs of pixels
+void checkPwg(const std::string& stream, const TestPages& pages) {
+    CHECK(stream.compare(0, 4, "RaS2") == 0);
+    const std::vector<Uint8>* expected[3] = {&pages.gray, &pages.rgb, &pages.gray};
+    size_t pos = 4;
+    for (int p = 0; p < 3; ++p) {
+        const size_t bpp = expected[p] == &pages.rgb ? 3 : 1;
+        const size_t lineBytes = kWidth * bpp;
+        if (pos + 1796 > stream.size()) {
+            CHECK(false);
+            return;
+        }
+        CHECK(stream.compare(pos, 9, "PwgRaster") == 0);
+        CHECK(getU32(stream, pos + 276) == kDpi);
+        CHECK(getU32(stream, pos + 372) == kWidth && getU32(stream, pos + 376) == kHeight);
+        CHECK(getU32(stream, pos + 388) == 8 * bpp && getU32(stream, pos + 392) == lineBytes);
+        CHECK(getU32(stream, pos + 400) == (bpp == 3 ? 19u : 18u)); // sRGB / sGray
+        pos += 1796;
+
+        std::vector<Uint8> decoded;
+        unsigned long y = 0;
+        while (y < kHeight && pos < stream.size()) {
+            const unsigned repeat = (Uint8)stream[pos++] + 1u;
+            std::string line;
+            while (line.size() < lineBytes && pos < stream.size()) {
+                const Uint8 code = (Uint8)stream[pos++];
+                if (code < 128) {
+                    for (unsigned i = 0; i <= code; ++i) line.append(stream, pos, bpp);
+                    pos += bpp;
+                } else {
+                    const size_t count = (257 - code) * bpp;
+                    line.append(stream, pos, count);
+                    pos += count;
+                }
+            }
+            CHECK(line.size() == lineBytes);
+            for (unsigned i = 0; i < repeat; ++i) decoded.insert(decoded.end(), line.begin(), line.end());
+            y += repeat;
+        }
+        CHECK(y == kHeight);
+        CHECK(decoded == *expected[p]);
+    }
+    CHECK(pos == stream.size());
+}
+
+std::vector<Uint8> inflateZlib(const std::string& data, size_t expectedBytes) {
+    std::vector<Uint8> out(expectedBytes + 1);
+    uLongf size = (uLongf)out.size();
+    // uncompress() checks the zlib header and the Adler-32 of the whole stream
+    const int rc = uncompress(out.data(), &size, reinterpret_cast<const Bytef*>(data.data()), (uLong)data.size());
+    CHECK(rc == Z_OK);
+    out.resize(rc == Z_OK ? size : 0);
+    return out;
+}
+
+// PDF: every xref entry points at its object, every image inflates and un-predicts to the page
+void checkPdf(const std::string& pdf, const TestPages& pages) {
+    CHECK(pdf.compare(0, 8, "%PDF-1.4") == 0);
+    const size_t startxref = pdf.rfind("startxref\n");
+    CHECK(startxref != std::string::npos);
+    if (startxref == std::string::npos) return;
+    const size_t xref = std::strtoul(pdf.c_str() + startxref + 10, NULL, 10);
+    CHECK(pdf.compare(xref, 7, "xref\n0 ") == 0);
+    const unsigned objects = (unsigned)std::strtoul(pdf.c_str() + xref + 7, NULL, 10);
+    const size_t entries = pdf.find('\n', xref + 5) + 1;
+    CHECK(objects == 1 + 2 + 3 * 3); // free entry, catalog, page tree, three objects per page
+    for (unsigned i = 1; i < objects; ++i) {
+        const size_t offset = std::strtoul(pdf.c_str() + entries + 20 * i, NULL, 10);
+        CHECK(pdf.compare(offset, std::to_string(i).size() + 6, std::to_string(i) + " 0 obj") == 0);
+    }
+
+    const std::vector<Uint8>* expected[3] = {&pages.gray, &pages.rgb, &pages.gray};
+    size_t search = 0;
+    for (int p = 0; p < 3; ++p) {
+        const size_t image = pdf.find("/Subtype /Image", search);
+        CHECK(image != std::string::npos);
+        if (image == std::string::npos) return;
+        const size_t lengthAt = pdf.find("/Length ", image);
+        const size_t length = std::strtoul(pdf.c_str() + lengthAt + 8, NULL, 10);
+        const size_t data = pdf.find(">>\nstream\n", lengthAt) + 10;
+        CHECK(pdf.compare(data + length, 10, "\nendstream") == 0);
+        search = data + length;
+
+        // PNG Up predictor: a filter byte (2) per row, each byte added to the one above
+        const size_t rowBytes = expected[p]->size() / kHeight;
+        const std::vector<Uint8> raw = inflateZlib(pdf.substr(data, length), (rowBytes + 1) * kHeight);
+        CHECK(raw.size() == (rowBytes + 1) * kHeight);
+        if (raw.size() != (rowBytes + 1) * kHeight) continue;
+        std::vector<Uint8> decoded(expected[p]->size());
+        bool filters = true;
+        for (unsigned long y = 0; y < kHeight; ++y) {
+            const Uint8* row = &raw[y * (rowBytes + 1)];
+            filters = filters && row[0] == 2;
+            for (size_t x = 0; x < rowBytes; ++x) {
+                const Uint8 above = y ? decoded[(y - 1) * rowBytes + x] : 0;
+                decoded[y * rowBytes + x] = (Uint8)(row[1 + x] + above);
+            }
+        }
+        CHECK(filters);
+        CHECK(decoded == *expected[p]);
+    }
+}
+
+void testStreams(const std::filesystem::path& root, const TestPages& pages) {
+    ThreadPool pool(4);
+    for (int f = 0; f < 2; ++f) {
+        const RasterStreamBackend::Format format = f ? RasterStreamBackend::Format::Pdf : RasterStreamBackend::Format::Pwg;
+        const char* extension = f ? "pdf" : "pwg";
+
+        // Bands encoded on the pool must give the same bytes as one thread
+        const std::filesystem::path serialDir = root / (std::string("serial-") + extension);
+        const std::filesystem::path parallelDir = root / (std::string("parallel-") + extension);
+        RasterStreamBackend serial(format, serialDir.string(), std::string(), 5, nullptr);
+        RasterStreamBackend parallel(format, parallelDir.string(), std::string(), 5, &pool);
+        const std::string stream = writeJob(serial, serialDir, pages, extension);
+        CHECK(!stream.empty());
+        CHECK(writeJob(parallel, parallelDir, pages, extension) == stream);
+
+        if (f) checkPdf(stream, pages);
+        else checkPwg(stream, pages);
+
+        // Abandoned documents leave neither the final file nor the partial one
+        PageInfo info;
+        info.jobId = 8;
+        {
+            std::unique_ptr<OutputDocument> document = serial.openDocument(info);
+            CHECK(document && document->printPage(pages.grayPage(), info));
+        }
+        CHECK(!std::filesystem::exists(serialDir / (std::string("job000008.") + extension)));
+        CHECK(!std::filesystem::exists(serialDir / (std::string("job000008.") + extension + ".part")));
+    }
+}
+
+#ifndef _WIN32
+int listenLoopback(int backlog, int& port) {
+    const int sock = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (bind(sock, (sockaddr*)&address, sizeof(address)) != 0 || listen(sock, backlog) != 0 ||
+        getsockname(sock, (sockaddr*)&address, &length) != 0) {
+        close(sock);
+        return -1;
+    }
+    port = ntohs(address.sin_port);
+    return sock;
+}
+
+// A printer that accepts the connection but never reads must fail the job, not hang it
+void testSendTimeout() {
+    int port = 0;
+    const int listener = listenLoopback(1, port);
+    CHECK(listener >= 0);
+    if (listener < 0) return;
+
+    // Incompressible, and larger than any loopback socket buffer
+    const unsigned long size = 3000;
+    std::vector<Uint8> noise(size * size * 3);
+    for (Uint8& value : noise) value = (Uint8)std::rand();
+    PageRaster page;
+    page.data = noise.data();
+    page.width = size;
+    page.height = size;
+    page.stride = size * 3;
+    page.bitsPerPixel = 24;
+
+    RasterStreamBackend backend(RasterStreamBackend::Format::Pwg, std::string(),
+                                "socket://127.0.0.1:" + std::to_string(port), 1, nullptr);
+    PageInfo info;
+    std::unique_ptr<OutputDocument> document = backend.openDocument(info);
+    CHECK(document != nullptr);
+    if (document) {
+        const auto start = std::chrono::steady_clock::now();
+        CHECK(!(document->printPage(page, info) && document->printPage(page, info) && document->finish()));
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+    }
+    close(listener);
+}
+
+// A device locked by another process fails openDocument once the timeout is over
+void testDeviceLock(const std::filesystem::path& root) {
+    const std::string device = (root / "device").string();
+    const int holder = open(device.c_str(), O_WRONLY | O_CREAT, 0644);
+    CHECK(holder >= 0 && flock(holder, LOCK_EX) == 0);
+
+    RasterStreamBackend backend(RasterStreamBackend::Format::Pwg, std::string(), device, 1, nullptr);
+    PageInfo info;
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(backend.openDocument(info) == nullptr);
+    const auto waited = std::chrono::steady_clock::now() - start;
+    CHECK(waited >= std::chrono::milliseconds(900) && waited < std::chrono::seconds(5));
+
+    // Free again: the job goes through
+    flock(holder, LOCK_UN);
+    std::unique_ptr<OutputDocument> document = backend.openDocument(info);
+    CHECK(document && document->finish());
+    close(holder);
+}
+#endif
+
+} // namespace
+
+int main() {
+    std::error_code ec;
+    const std::filesystem::path root =
+        std::filesystem::temp_directory_path() / ("RasterStreamBackendTest-" + std::to_string(std::rand()));
+    std::filesystem::create_directories(root, ec);
+
+    const TestPages pages;
+    testStreams(root, pages);
+#ifndef _WIN32
+    testSendTimeout();
+    testDeviceLock(root);
+#endif
+
+    std::filesystem::remove_all(root, ec);
+    return TestUtil::result("RasterStreamBackendTest");
+}
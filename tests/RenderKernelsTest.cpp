@@ -0,0 +1,172 @@
+// RenderKernelsTest.cpp
+// Kernel selection per pixel format, and each kernel's output against the plain formulas
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+
+#include "RenderKernels.h"
+#include "TestUtil.h"
+
+namespace {
+
+PixelFormat colorFormat(Photometric photometric, bool planar) {
+    PixelFormat format;
+    format.rows = 4;
+    format.columns = 4;
+    format.samplesPerPixel = 3;
+    format.bitsAllocated = 8;
+    format.bitsStored = 8;
+    format.highBit = 7;
+    format.photometric = photometric;
+    format.planar = planar;
+    return format;
+}
+
+int expectedYbr(double value) {
+    return (int)std::lround(std::min(255.0, std::max(0.0, value)));
+}
+
+// Fixed point YBR_FULL conversion stays within one step of the float formula
+void testYbrFull() {
+    const RenderKernel* kernel = selectRenderKernel(colorFormat(Photometric::YbrFull, false));
+    CHECK(kernel && std::strcmp(kernel->name, "ybr8") == 0);
+    if (!kernel) return;
+
+    int maxDiff = 0;
+    for (int y = 0; y < 256; y += 3) {
+        for (int cb = 0; cb < 256; ++cb) {
+            for (int cr = 0; cr < 256; ++cr) {
+                const uint8_t src[3] = {(uint8_t)y, (uint8_t)cb, (uint8_t)cr};
+                uint8_t rgb[3];
+                kernel->toRGB(src, rgb, 1);
+                const int expected[3] = {
+                    expectedYbr(y + 1.402 * (cr - 128)),
+                    expectedYbr(y - 0.344136 * (cb - 128) - 0.714136 * (cr - 128)),
+                    expectedYbr(y + 1.772 * (cb - 128))};
+                for (int c = 0; c < 3; ++c) maxDiff = std::max(maxDiff, std::abs(expected[c] - rgb[c]));
+            }
+        }
+    }
+    CHECK(maxDiff <= 1);
+}
+
+void testPlanar() {
+    const RenderKernel* ybr = selectRenderKernel(colorFormat(Photometric::YbrFull, true));
+    CHECK(ybr && std::strcmp(ybr->name, "ybr8-planar") == 0);
+    if (ybr) {
+        // Y plane, then Cb, then Cr
+        const uint8_t planes[6] = {10, 20, 128, 128, 128, 200};
+        uint8_t rgb[6];
+        ybr->toRGB(planes, rgb, 2);
+        const uint8_t expected[6] = {10, 10, 10, 121, 0, 20};
+        CHECK(std::memcmp(rgb, expected, sizeof(rgb)) == 0);
+    }
+
+    const RenderKernel* rgbPlanar = selectRenderKernel(colorFormat(Photometric::RGB, true));
+    CHECK(rgbPlanar && std::strcmp(rgbPlanar->name, "rgb8-planar") == 0);
+    if (rgbPlanar) {
+        const uint8_t planes[6] = {1, 2, 3, 4, 5, 6};
+        uint8_t rgb[6];
+        rgbPlanar->toRGB(planes, rgb, 2);
+        const uint8_t expected[6] = {1, 3, 5, 2, 4, 6};
+        CHECK(std::memcmp(rgb, expected, sizeof(rgb)) == 0);
+    }
+
+    const RenderKernel* rgb = selectRenderKernel(colorFormat(Photometric::RGB, false));
+    CHECK(rgb && std::strcmp(rgb->name, "rgb8") == 0);
+}
+
+// Gray words index the table as stored, bits above Bits Stored included
+void testGray16() {
+    PixelFormat format;
+    format.rows = 1;
+    format.columns = 3;
+    format.bitsAllocated = 16;
+    format.bitsStored = 12;
+    format.highBit = 11;
+    format.photometric = Photometric::Monochrome1;
+    const RenderKernel* kernel = selectRenderKernel(format);
+    CHECK(kernel && std::strcmp(kernel->name, "gray16") == 0 && !kernel->color);
+    if (!kernel) return;
+
+    const uint16_t words[3] = {0, 4095, 65535};
+    std::vector<uint32_t> bins(65536);
+    kernel->histogram(words, 3, bins.data());
+    CHECK(bins[0] == 1 && bins[4095] == 1 && bins[65535] == 1);
+
+    std::vector<uint8_t> table(65536);
+    table[4095] = 7;
+    table[65535] = 9;
+    uint8_t gray[3];
+    kernel->mapGray(words, table.data(), gray, 3);
+    CHECK(gray[0] == 0 && gray[1] == 7 && gray[2] == 9);
+}
+
+// Rare encodings stay on the generic DicomImage path
+void testUnsupported() {
+    PixelFormat format;
+    format.rows = 1;
+    format.columns = 1;
+    format.bitsAllocated = 32;
+    format.bitsStored = 32;
+    format.highBit = 31;
+    format.photometric = Photometric::Monochrome2;
+    CHECK(selectRenderKernel(format) == nullptr);
+
+    PixelFormat color16 = colorFormat(Photometric::RGB, false);
+    color16.bitsAllocated = 16;
+    CHECK(selectRenderKernel(color16) == nullptr);
+
+    CHECK(selectRenderKernel(colorFormat(Photometric::Other, false)) == nullptr);
+}
+
+// LUT tables and non-linear VOI functions are beyond the fused table
+void testLutFallback() {
+    PixelFormat format;
+    format.rows = 2;
+    format.columns = 2;
+    format.bitsAllocated = 16;
+    format.bitsStored = 12;
+    format.highBit = 11;
+    format.photometric = Photometric::Monochrome2;
+    CHECK(selectRenderKernel(format) != nullptr);
+    format.lutTables = true;
+    CHECK(selectRenderKernel(format) == nullptr);
+
+    DcmDataset dataset;
+    dataset.putAndInsertUint16(DCM_Rows, 2);
+    dataset.putAndInsertUint16(DCM_Columns, 2);
+    dataset.putAndInsertUint16(DCM_BitsAllocated, 16);
+    dataset.putAndInsertUint16(DCM_BitsStored, 12);
+    dataset.putAndInsertUint16(DCM_HighBit, 11);
+    dataset.putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+    dataset.putAndInsertString(DCM_VOILUTFunction, "LINEAR");
+    CHECK(readPixelFormat(dataset, format) && !format.lutTables);
+    CHECK(selectRenderKernel(format) != nullptr);
+
+    dataset.putAndInsertString(DCM_VOILUTFunction, "SIGMOID");
+    CHECK(readPixelFormat(dataset, format) && format.lutTables);
+    CHECK(selectRenderKernel(format) == nullptr);
+
+    dataset.putAndInsertString(DCM_VOILUTFunction, "LINEAR");
+    DcmItem* item = nullptr;
+    CHECK(dataset.findOrCreateSequenceItem(DCM_ModalityLUTSequence, item, -2).good());
+    CHECK(readPixelFormat(dataset, format) && format.lutTables);
+    CHECK(selectRenderKernel(format) == nullptr);
+}
+
+} // namespace
+
+int main() {
+    testYbrFull();
+    testPlanar();
+    testGray16();
+    testUnsupported();
+    testLutFallback();
+    return TestUtil::result("RenderKernelsTest");
+}
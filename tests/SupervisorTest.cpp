@@ -0,0 +1,124 @@
+// SupervisorTest.cpp
+// Per-worker config, and a crashed worker being restarted on the shared port (POSIX)
+#include <csignal>
+#include <cstring>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <dcmtk/dcmnet/dul.h>
+
+#include "Supervisor.h"
+#include "TestUtil.h"
+
+namespace {
+
+// Stands in for the DICOM server: answers "ok" to each connection, dies on 'X'
+int echoWorker(const ServerConfig&, T_ASC_Network* network) {
+    const int listenSocket = DUL_networkSocket(network->network);
+    while (true) {
+        const int client = accept(listenSocket, NULL, NULL);
+        if (client < 0) return 0; // the supervisor shut the socket down
+        char command = 0;
+        if (read(client, &command, 1) == 1 && command == 'X') raise(SIGKILL);
+        if (write(client, "ok", 2) != 2) {}
+        close(client);
+    }
+}
+
+int freePort() {
+    const int probe = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bind(probe, (sockaddr*)&address, sizeof(address));
+    getsockname(probe, (sockaddr*)&address, &length);
+    close(probe);
+    return ntohs(address.sin_port);
+}
+
+// Sends one command byte and returns the reply ("" when the worker died first)
+std::string request(int port, char command) {
+    const int client = socket(AF_INET, SOCK_STREAM, 0);
+    timeval timeout = {10, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::string reply;
+    if (connect(client, (sockaddr*)&address, sizeof(address)) == 0 && write(client, &command, 1) == 1) {
+        char buffer[8];
+        ssize_t count;
+        while ((count = read(client, buffer, sizeof(buffer))) > 0) reply.append(buffer, (size_t)count);
+    }
+    close(client);
+    return reply;
+}
+
+void testWorkerConfig() {
+    ServerConfig config;
+    config.metricsPort = 9100;
+    config.metricsFile = "metrics.prom";
+    config.logFile = "print.log";
+    config.spoolDirectory = "spool";
+
+    const ServerConfig second = workerConfig(config, 1);
+    CHECK(second.metricsPort == 9101);
+    CHECK(second.metricsFile == "metrics.prom.2");
+    CHECK(second.logFile == "print.log.2");
+    CHECK(second.spoolDirectory.find("worker2") != std::string::npos);
+
+    config.metricsPort = 0;
+    config.metricsFile.clear();
+    CHECK(workerConfig(config, 3).metricsPort == 0);
+    CHECK(workerConfig(config, 3).metricsFile.empty());
+}
+
+void testRestartAfterCrash() {
+    ServerConfig config;
+    config.processes = 2;
+    config.port = freePort();
+    config.logLevel = "warn";
+
+    const pid_t supervisor = fork();
+    if (supervisor == 0) {
+        Supervisor instance(config);
+        std::_Exit(instance.run(echoWorker));
+    }
+
+    // Connections queue on the listening socket until a worker accepts them,
+    // so the first request also waits for the workers to start
+    std::string reply;
+    for (int attempt = 0; attempt < 50 && reply.empty(); ++attempt) {
+        reply = request(config.port, 'a');
+        if (reply.empty()) usleep(100 * 1000);
+    }
+    CHECK(reply == "ok");
+
+    // Both workers die; the requests after them are served by the restarted ones
+    CHECK(request(config.port, 'X').empty());
+    CHECK(request(config.port, 'X').empty());
+    for (char command = 'b'; command < 'f'; ++command) CHECK(request(config.port, command) == "ok");
+
+    kill(supervisor, SIGTERM);
+    int status = 0;
+    CHECK(waitpid(supervisor, &status, 0) == supervisor);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+} // namespace
+
+int main() {
+    testWorkerConfig();
+    testRestartAfterCrash();
+    return TestUtil::result("SupervisorTest");
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdio>
+
+/**
+ * @brief أدوات الاختبار: كل ملف اختبار برنامج مستقل يعيد 0 عند النجاح (ctest)
+ *
+ * CHECK لا يوقف الاختبار عند الفشل، بل يطبع الموقع ويزيد العداد حتى تظهر كل
+ * الاختلافات في تشغيل واحد.
+ */
+namespace TestUtil {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline int result(const char* name) {
+    if (failures()) std::printf("%s: %d check(s) failed\n", name, failures());
+    else std::printf("%s: ok\n", name);
+    return failures() ? 1 : 0;
+}
+
+} // namespace TestUtil
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);     \
+            ++TestUtil::failures();                                                  \
+        }                                                                            \
+    } while (0)
@@ -0,0 +1,473 @@
+// PrintLoadGen.cpp
+// Loopback load generator: N concurrent print SCUs replaying full
+// Basic Grayscale / Color Print Management sessions against the server
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcuid.h>
+#include <dcmtk/dcmnet/assoc.h>
+#include <dcmtk/dcmnet/dimse.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#pragma comment(lib, "ws2_32.lib")
+#endif
+
+namespace {
+
+struct LoadOptions {
+    std::string host = "127.0.0.1";
+    int port = 11112;
+    std::string calledAE = "DICOM_PRINT_SCP";
+    std::string callingAE = "PRINT_LOADGEN";
+    unsigned associations = 4;    ///< concurrent SCUs
+    unsigned sessions = 10;       ///< sessions per SCU
+    unsigned filmsPerSession = 1;
+    std::string displayFormat = "STANDARD\\1,1";
+    bool color = false;
+    unsigned rows = 2048;
+    unsigned columns = 2048;
+    long maxPdu = ASC_DEFAULTMAXPDU;
+    int timeoutSec = 30;
+};
+
+// Outcome of one SCU thread
+struct WorkerResult {
+    std::vector<double> sessionMs;
+    unsigned films = 0;
+    unsigned failures = 0;
+    std::string lastError;
+};
+
+// -----------------------------
+// DIMSE request/response helper
+// -----------------------------
+DIC_US responseStatus(const T_DIMSE_Message& response, T_DIMSE_DataSetType& dataSetType) {
+    switch (response.CommandField) {
+    case DIMSE_N_CREATE_RSP:
+        dataSetType = response.msg.NCreateRSP.DataSetType;
+        return response.msg.NCreateRSP.DimseStatus;
+    case DIMSE_N_SET_RSP:
+        dataSetType = response.msg.NSetRSP.DataSetType;
+        return response.msg.NSetRSP.DimseStatus;
+    case DIMSE_N_ACTION_RSP:
+        dataSetType = response.msg.NActionRSP.DataSetType;
+        return response.msg.NActionRSP.DimseStatus;
+    case DIMSE_N_DELETE_RSP:
+        dataSetType = response.msg.NDeleteRSP.DataSetType;
+        return response.msg.NDeleteRSP.DimseStatus;
+    default:
+        dataSetType = DIMSE_DATASET_NULL;
+        return 0xFFFF;
+    }
+}
+
+class PrintClient {
+private:
+    const LoadOptions& options_;
+    T_ASC_Network* network_;
+    T_ASC_Association* association_ = nullptr;
+    T_ASC_PresentationContextID presID_ = 0;
+    DIC_US nextMessageID_ = 1;
+
+public:
+    std::string error;
+
+    PrintClient(const LoadOptions& options, T_ASC_Network* network) : options_(options), network_(network) {}
+
+    ~PrintClient() {
+        if (association_) {
+            ASC_abortAssociation(association_);
+            ASC_destroyAssociation(&association_);
+        }
+    }
+
+    bool connect() {
+        T_ASC_Parameters* params = nullptr;
+        OFCondition cond = ASC_createAssociationParameters(&params, options_.maxPdu);
+        if (cond.bad()) return fail("association parameters", cond);
+
+        const std::string peer = options_.host + ":" + std::to_string(options_.port);
+        ASC_setAPTitles(params, options_.callingAE.c_str(), options_.calledAE.c_str(), NULL);
+        ASC_setPresentationAddresses(params, "localhost", peer.c_str());
+
+        const char* transferSyntaxes[] = { UID_LittleEndianExplicitTransferSyntax,
+                                           UID_LittleEndianImplicitTransferSyntax };
+        const char* metaClass = options_.color ? UID_BasicColorPrintManagementMetaSOPClass
+                                               : UID_BasicGrayscalePrintManagementMetaSOPClass;
+        ASC_addPresentationContext(params, 1, metaClass, transferSyntaxes, 2);
+
+        cond = ASC_requestAssociation(network_, params, &association_);
+        if (cond.bad()) {
+            if (!association_) ASC_destroyAssociationParameters(&params);
+            return fail("association request", cond);
+        }
+        presID_ = ASC_findAcceptedPresentationContextID(association_, metaClass);
+        if (presID_ == 0) {
+            error = "print management meta SOP class not accepted";
+            return false;
+        }
+        return true;
+    }
+
+    bool release() {
+        OFCondition cond = ASC_releaseAssociation(association_);
+        ASC_destroyAssociation(&association_);
+        return cond.good() || fail("release", cond);
+    }
+
+    // Sends one request and waits for its response; a warning status counts as success
+    bool exchange(T_DIMSE_Message& request, DcmDataset* dataset, T_DIMSE_Message& response,
+                  std::unique_ptr<DcmDataset>* rspDataset, const char* what) {
+        OFCondition cond = DIMSE_sendMessageUsingMemoryData(association_, presID_, &request, NULL, dataset,
+                                                            NULL, NULL);
+        if (cond.bad()) return fail(what, cond);
+
+        T_ASC_PresentationContextID rspPresID = 0;
+        DcmDataset* statusDetail = nullptr;
+        cond = DIMSE_receiveCommand(association_, DIMSE_BLOCKING, 0, &rspPresID, &response, &statusDetail);
+        delete statusDetail;
+        if (cond.bad()) return fail(what, cond);
+
+        T_DIMSE_DataSetType dataSetType = DIMSE_DATASET_NULL;
+        const DIC_US status = responseStatus(response, dataSetType);
+        if (dataSetType != DIMSE_DATASET_NULL) {
+            DcmDataset* received = nullptr;
+            cond = DIMSE_receiveDataSetInMemory(association_, DIMSE_BLOCKING, 0, &rspPresID, &received,
+                                                NULL, NULL);
+            if (cond.bad()) return fail(what, cond);
+            if (rspDataset) rspDataset->reset(received);
+            else delete received;
+        }
+        // 0x0000 success, 0xB*** warnings
+        if (status != 0x0000 && (status & 0xF000) != 0xB000) {
+            char text[64];
+            std::snprintf(text, sizeof(text), "%s status 0x%04X", what, status);
+            error = text;
+            return false;
+        }
+        return true;
+    }
+
+    bool create(const char* sopClass, DcmDataset* dataset, std::string& instanceUID,
+                std::unique_ptr<DcmDataset>* rspDataset, const char* what) {
+        T_DIMSE_Message request;
+        memset(&request, 0, sizeof(request));
+        request.CommandField = DIMSE_N_CREATE_RQ;
+        T_DIMSE_N_CreateRQ& rq = request.msg.NCreateRQ;
+        rq.MessageID = nextMessageID_++;
+        OFStandard::strlcpy(rq.AffectedSOPClassUID, sopClass, sizeof(rq.AffectedSOPClassUID));
+        rq.DataSetType = dataset ? DIMSE_DATASET_PRESENT : DIMSE_DATASET_NULL;
+        T_DIMSE_Message response;
+        if (!exchange(request, dataset, response, rspDataset, what)) return false;
+        instanceUID = response.msg.NCreateRSP.AffectedSOPInstanceUID;
+        return true;
+    }
+
+    bool set(const char* sopClass, const std::string& instanceUID, DcmDataset* dataset) {
+        T_DIMSE_Message request;
+        memset(&request, 0, sizeof(request));
+        request.CommandField = DIMSE_N_SET_RQ;
+        T_DIMSE_N_SetRQ& rq = request.msg.NSetRQ;
+        rq.MessageID = nextMessageID_++;
+        OFStandard::strlcpy(rq.RequestedSOPClassUID, sopClass, sizeof(rq.RequestedSOPClassUID));
+        OFStandard::strlcpy(rq.RequestedSOPInstanceUID, instanceUID.c_str(), sizeof(rq.RequestedSOPInstanceUID));
+        rq.DataSetType = DIMSE_DATASET_PRESENT;
+        T_DIMSE_Message response;
+        return exchange(request, dataset, response, nullptr, "N-SET image box");
+    }
+
+    bool print(const char* sopClass, const std::string& instanceUID) {
+        T_DIMSE_Message request;
+        memset(&request, 0, sizeof(request));
+        request.CommandField = DIMSE_N_ACTION_RQ;
+        T_DIMSE_N_ActionRQ& rq = request.msg.NActionRQ;
+        rq.MessageID = nextMessageID_++;
+        OFStandard::strlcpy(rq.RequestedSOPClassUID, sopClass, sizeof(rq.RequestedSOPClassUID));
+        OFStandard::strlcpy(rq.RequestedSOPInstanceUID, instanceUID.c_str(), sizeof(rq.RequestedSOPInstanceUID));
+        rq.ActionTypeID = 1; // Print
+        rq.DataSetType = DIMSE_DATASET_NULL;
+        T_DIMSE_Message response;
+        return exchange(request, nullptr, response, nullptr, "N-ACTION print");
+    }
+
+    bool remove(const char* sopClass, const std::string& instanceUID) {
+        T_DIMSE_Message request;
+        memset(&request, 0, sizeof(request));
+        request.CommandField = DIMSE_N_DELETE_RQ;
+        T_DIMSE_N_DeleteRQ& rq = request.msg.NDeleteRQ;
+        rq.MessageID = nextMessageID_++;
+        OFStandard::strlcpy(rq.RequestedSOPClassUID, sopClass, sizeof(rq.RequestedSOPClassUID));
+        OFStandard::strlcpy(rq.RequestedSOPInstanceUID, instanceUID.c_str(), sizeof(rq.RequestedSOPInstanceUID));
+        rq.DataSetType = DIMSE_DATASET_NULL;
+        T_DIMSE_Message response;
+        return exchange(request, nullptr, response, nullptr, "N-DELETE film session");
+    }
+
+private:
+    bool fail(const char* what, const OFCondition& cond) {
+        error = std::string(what) + ": " + cond.text();
+        return false;
+    }
+};
+
+// -----------------------------
+// Session content
+// -----------------------------
+
+// Image Box N-SET payload: one synthetic image in the pixel module sequence
+std::unique_ptr<DcmDataset> makeImageBoxPayload(const LoadOptions& options) {
+    std::unique_ptr<DcmDataset> dataset(new DcmDataset());
+    DcmItem* image = nullptr;
+    const DcmTagKey sequence = options.color ? DCM_BasicColorImageSequence : DCM_BasicGrayscaleImageSequence;
+    if (dataset->findOrCreateSequenceItem(sequence, image, -2).bad()) return nullptr;
+
+    const unsigned long count = (unsigned long)options.rows * options.columns;
+    image->putAndInsertUint16(DCM_Rows, (Uint16)options.rows);
+    image->putAndInsertUint16(DCM_Columns, (Uint16)options.columns);
+    image->putAndInsertString(DCM_PixelAspectRatio, "1\\1");
+    image->putAndInsertUint16(DCM_PixelRepresentation, 0);
+    if (options.color) {
+        image->putAndInsertUint16(DCM_SamplesPerPixel, 3);
+        image->putAndInsertString(DCM_PhotometricInterpretation, "RGB");
+        image->putAndInsertUint16(DCM_PlanarConfiguration, 0);
+        image->putAndInsertUint16(DCM_BitsAllocated, 8);
+        image->putAndInsertUint16(DCM_BitsStored, 8);
+        image->putAndInsertUint16(DCM_HighBit, 7);
+        std::vector<Uint8> pixels(count * 3);
+        for (size_t i = 0; i < pixels.size(); ++i) pixels[i] = (Uint8)((i / 3) % options.columns);
+        image->putAndInsertUint8Array(DCM_PixelData, pixels.data(), (unsigned long)pixels.size());
+    } else {
+        image->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+        image->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+        image->putAndInsertUint16(DCM_BitsAllocated, 16);
+        image->putAndInsertUint16(DCM_BitsStored, 12);
+        image->putAndInsertUint16(DCM_HighBit, 11);
+        std::vector<Uint16> pixels(count);
+        for (unsigned long i = 0; i < count; ++i)
+            pixels[i] = (Uint16)(((i % options.columns) * 4096 / options.columns) & 0x0FFF);
+        image->putAndInsertUint16Array(DCM_PixelData, pixels.data(), count);
+    }
+    return dataset;
+}
+
+// Film Session → Film Box(es) → Image Boxes → print → delete; true if every film printed
+bool runSession(PrintClient& client, const LoadOptions& options, DcmDataset& imagePayload, unsigned& films) {
+    DcmDataset session;
+    session.putAndInsertString(DCM_NumberOfCopies, "1");
+    session.putAndInsertString(DCM_PrintPriority, "MED");
+    session.putAndInsertString(DCM_MediumType, "BLUE FILM");
+    std::string sessionUID;
+    if (!client.create(UID_BasicFilmSessionSOPClass, &session, sessionUID, nullptr, "N-CREATE film session"))
+        return false;
+
+    for (unsigned f = 0; f < options.filmsPerSession; ++f) {
+        DcmDataset filmBox;
+        filmBox.putAndInsertString(DCM_ImageDisplayFormat, options.displayFormat.c_str());
+        filmBox.putAndInsertString(DCM_FilmOrientation, "PORTRAIT");
+        filmBox.putAndInsertString(DCM_FilmSizeID, "14INX17IN");
+        DcmItem* reference = nullptr;
+        if (filmBox.findOrCreateSequenceItem(DCM_ReferencedFilmSessionSequence, reference, -2).good()) {
+            reference->putAndInsertString(DCM_ReferencedSOPClassUID, UID_BasicFilmSessionSOPClass);
+            reference->putAndInsertString(DCM_ReferencedSOPInstanceUID, sessionUID.c_str());
+        }
+
+        std::unique_ptr<DcmDataset> created;
+        std::string filmBoxUID;
+        if (!client.create(UID_BasicFilmBoxSOPClass, &filmBox, filmBoxUID, &created, "N-CREATE film box"))
+            return false;
+        if (!created) {
+            client.error = "film box response without Referenced Image Box Sequence";
+            return false;
+        }
+
+        // Fill every image box the server created for the display format
+        DcmItem* imageBox = nullptr;
+        for (signed long i = 0; created->findAndGetSequenceItem(DCM_ReferencedImageBoxSequence, imageBox, i).good();
+             ++i) {
+            OFString sopClass, sopInstance;
+            imageBox->findAndGetOFString(DCM_ReferencedSOPClassUID, sopClass);
+            imageBox->findAndGetOFString(DCM_ReferencedSOPInstanceUID, sopInstance);
+            imagePayload.putAndInsertUint16(DCM_ImageBoxPosition, (Uint16)(i + 1));
+            if (!client.set(sopClass.c_str(), sopInstance.c_str(), &imagePayload)) return false;
+        }
+
+        if (!client.print(UID_BasicFilmBoxSOPClass, filmBoxUID)) return false;
+        ++films;
+    }
+    return client.remove(UID_BasicFilmSessionSOPClass, sessionUID);
+}
+
+void runWorker(const LoadOptions& options, T_ASC_Network* network, DcmDataset& imagePayload,
+               WorkerResult& result) {
+    for (unsigned s = 0; s < options.sessions; ++s) {
+        const auto start = std::chrono::steady_clock::now();
+        PrintClient client(options, network);
+        unsigned films = 0;
+        const bool ok = client.connect() && runSession(client, options, imagePayload, films) && client.release();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        result.films += films;
+        if (ok) {
+            result.sessionMs.push_back(std::chrono::duration<double, std::milli>(elapsed).count());
+        } else {
+            ++result.failures;
+            result.lastError = client.error;
+        }
+    }
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    const size_t index = std::min(sorted.size() - 1, (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+void printLoadUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --host <address>           print SCP address (default 127.0.0.1)\n"
+              << "  --port <port>              print SCP port (default 11112)\n"
+              << "  --called-ae <title>        print SCP AE title (default DICOM_PRINT_SCP)\n"
+              << "  --calling-ae <title>       our AE title (default PRINT_LOADGEN)\n"
+              << "  --associations <n>         concurrent associations (default 4)\n"
+              << "  --sessions <n>             sessions per association thread (default 10)\n"
+              << "  --films <n>                film boxes per session (default 1)\n"
+              << "  --format <format>          Image Display Format (default STANDARD\\1,1)\n"
+              << "  --color                    Basic Color Print Management instead of grayscale\n"
+              << "  --size <rows>x<columns>    synthetic image size (default 2048x2048)\n"
+              << "  --max-pdu <bytes>          maximum receive PDU size\n"
+              << "  --timeout <seconds>        network timeout (default 30)\n"
+              << "  --help                     show this message\n"
+              << "Start the server with --output null (or file) so the printer is not the bottleneck.\n";
+}
+
+bool parseOptions(int argc, char* argv[], LoadOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) return false;
+        if (std::strcmp(arg, "--color") == 0) {
+            options.color = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "❌ Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (std::strcmp(arg, "--host") == 0) {
+            options.host = value;
+        } else if (std::strcmp(arg, "--port") == 0) {
+            options.port = std::atoi(value);
+        } else if (std::strcmp(arg, "--called-ae") == 0) {
+            options.calledAE = value;
+        } else if (std::strcmp(arg, "--calling-ae") == 0) {
+            options.callingAE = value;
+        } else if (std::strcmp(arg, "--associations") == 0) {
+            options.associations = (unsigned)std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--sessions") == 0) {
+            options.sessions = (unsigned)std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--films") == 0) {
+            options.filmsPerSession = (unsigned)std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--format") == 0) {
+            options.displayFormat = value;
+        } else if (std::strcmp(arg, "--size") == 0) {
+            unsigned rows = 0, columns = 0;
+            if (std::sscanf(value, "%ux%u", &rows, &columns) != 2 || rows == 0 || columns == 0 ||
+                rows > 65535 || columns > 65535) {
+                std::cerr << "❌ Invalid --size: " << value << std::endl;
+                return false;
+            }
+            options.rows = rows;
+            options.columns = columns;
+        } else if (std::strcmp(arg, "--max-pdu") == 0) {
+            options.maxPdu = std::atol(value);
+        } else if (std::strcmp(arg, "--timeout") == 0) {
+            options.timeoutSec = std::max(1, std::atoi(value));
+        } else {
+            std::cerr << "❌ Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return options.port > 0 && options.port <= 65535;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printLoadUsage(argv[0]);
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    T_ASC_Network* network = nullptr;
+    OFCondition cond = ASC_initializeNetwork(NET_REQUESTOR, 0, options.timeoutSec, &network);
+    if (cond.bad()) {
+        std::cerr << "❌ Cannot initialize network: " << cond.text() << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<DcmDataset> imagePayload = makeImageBoxPayload(options);
+    if (!imagePayload) return 1;
+
+    std::cout << "🚀 " << options.associations << " associations × " << options.sessions << " sessions × "
+              << options.filmsPerSession << " films (" << options.displayFormat << ", "
+              << (options.color ? "color" : "grayscale") << " " << options.rows << "x" << options.columns
+              << ") → " << options.host << ":" << options.port << std::endl;
+
+    // Each thread owns a copy of the payload; the image box position is rewritten per N-SET
+    std::vector<std::unique_ptr<DcmDataset>> payloads;
+    std::vector<WorkerResult> results(options.associations);
+    std::vector<std::thread> workers;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < options.associations; ++i) {
+        payloads.emplace_back(new DcmDataset(*imagePayload));
+        workers.emplace_back(runWorker, std::cref(options), network, std::ref(*payloads.back()),
+                             std::ref(results[i]));
+    }
+    for (std::thread& worker : workers) worker.join();
+    const double wallSec =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> latencies;
+    unsigned films = 0, failures = 0;
+    for (const WorkerResult& result : results) {
+        latencies.insert(latencies.end(), result.sessionMs.begin(), result.sessionMs.end());
+        films += result.films;
+        failures += result.failures;
+        if (!result.lastError.empty()) std::cerr << "❌ " << result.lastError << std::endl;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::printf("sessions ok      %zu\n", latencies.size());
+    std::printf("sessions failed  %u\n", failures);
+    std::printf("films accepted   %u in %.2f s\n", films, wallSec);
+    std::printf("films/second     %.2f\n", wallSec > 0 ? films / wallSec : 0.0);
+    if (!latencies.empty()) {
+        std::printf("session latency  p50 %.1f ms  p90 %.1f ms  p99 %.1f ms  max %.1f ms\n",
+                    percentile(latencies, 50), percentile(latencies, 90), percentile(latencies, 99),
+                    latencies.back());
+    }
+
+    ASC_dropNetwork(&network);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return failures == 0 ? 0 : 2;
+}
@@ -0,0 +1,432 @@
+// RenderBench.cpp
+// Microbenchmarks for the render pipeline on synthetic CR / CT / MG / US images
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcrledrg.h>
+#include <dcmtk/dcmdata/dcrleerg.h>
+#include <dcmtk/dcmdata/dcrlerp.h>
+#include <dcmtk/dcmjpls/djdecode.h>
+#include <dcmtk/dcmjpls/djencode.h>
+#include <dcmtk/dcmjpls/djrparam.h>
+
+#include "FilmCompositor.h"
+#include "FilmLayout.h"
+#include "GrayscaleLut.h"
+#include "ImageRenderer.h"
+#include "PageBuffer.h"
+#include "PixelDecoder.h"
+#include "PixelKernels.h"
+#include "Resampler.h"
+#include "ThreadPool.h"
+
+namespace {
+
+struct BenchOptions {
+    unsigned iterations = 20;
+    unsigned dpi = 300;
+    unsigned threads = 0;
+    std::string filter; ///< only cases whose name contains this text
+};
+
+// One representative modality image, native and (optionally) compressed
+struct Sample {
+    std::string name;
+    std::unique_ptr<DcmDataset> native;
+    std::unique_ptr<DcmDataset> compressed;
+    unsigned long width = 0;
+    unsigned long height = 0;
+    bool color = false;
+};
+
+// Deterministic pseudo-noise so compressed sizes are stable between runs
+class Noise {
+private:
+    uint32_t state_ = 0x9E3779B9u;
+
+public:
+    unsigned next(unsigned range) {
+        state_ = state_ * 1664525u + 1013904223u;
+        return (state_ >> 16) % range;
+    }
+};
+
+void putCommon(DcmDataset& dataset, unsigned long width, unsigned long height, unsigned samples,
+               const char* photometric) {
+    dataset.putAndInsertUint16(DCM_Rows, (Uint16)height);
+    dataset.putAndInsertUint16(DCM_Columns, (Uint16)width);
+    dataset.putAndInsertUint16(DCM_SamplesPerPixel, (Uint16)samples);
+    dataset.putAndInsertString(DCM_PhotometricInterpretation, photometric);
+    dataset.putAndInsertString(DCM_PixelAspectRatio, "1\\1");
+}
+
+// Smooth anatomy-like gradient plus noise, stored in bitsStored bits
+std::unique_ptr<DcmDataset> makeGray(unsigned long width, unsigned long height, unsigned bitsStored,
+                                     bool isSigned, bool monochrome1, const char* intercept,
+                                     const char* center, const char* windowWidth) {
+    std::unique_ptr<DcmDataset> dataset(new DcmDataset());
+    putCommon(*dataset, width, height, 1, monochrome1 ? "MONOCHROME1" : "MONOCHROME2");
+    dataset->putAndInsertUint16(DCM_BitsAllocated, 16);
+    dataset->putAndInsertUint16(DCM_BitsStored, (Uint16)bitsStored);
+    dataset->putAndInsertUint16(DCM_HighBit, (Uint16)(bitsStored - 1));
+    dataset->putAndInsertUint16(DCM_PixelRepresentation, isSigned ? 1 : 0);
+    if (intercept) {
+        dataset->putAndInsertString(DCM_RescaleIntercept, intercept);
+        dataset->putAndInsertString(DCM_RescaleSlope, "1");
+    }
+    if (center) {
+        dataset->putAndInsertString(DCM_WindowCenter, center);
+        dataset->putAndInsertString(DCM_WindowWidth, windowWidth);
+    }
+
+    const int maxValue = (1 << (isSigned ? bitsStored - 1 : bitsStored)) - 1;
+    const int minValue = isSigned ? -maxValue - 1 : 0;
+    std::vector<Uint16> pixels(width * height);
+    Noise noise;
+    for (unsigned long y = 0; y < height; ++y) {
+        for (unsigned long x = 0; x < width; ++x) {
+            const long dx = (long)x - (long)width / 2, dy = (long)y - (long)height / 2;
+            const double radius = std::sqrt((double)(dx * dx + dy * dy)) / (double)(width / 2 + 1);
+            int value = minValue + (int)((maxValue - minValue) * std::max(0.0, 1.0 - radius * 0.8));
+            value += (int)noise.next(64) - 32;
+            value = std::min(maxValue, std::max(minValue, value));
+            pixels[y * width + x] = (Uint16)(value & ((1 << bitsStored) - 1));
+        }
+    }
+    dataset->putAndInsertUint16Array(DCM_PixelData, pixels.data(), (unsigned long)pixels.size());
+    return dataset;
+}
+
+std::unique_ptr<DcmDataset> makeColor(unsigned long width, unsigned long height) {
+    std::unique_ptr<DcmDataset> dataset(new DcmDataset());
+    putCommon(*dataset, width, height, 3, "RGB");
+    dataset->putAndInsertUint16(DCM_PlanarConfiguration, 0);
+    dataset->putAndInsertUint16(DCM_BitsAllocated, 8);
+    dataset->putAndInsertUint16(DCM_BitsStored, 8);
+    dataset->putAndInsertUint16(DCM_HighBit, 7);
+    dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+
+    // Ultrasound: dark sector with a speckled gray fan and a colour overlay
+    std::vector<Uint8> pixels(width * height * 3);
+    Noise noise;
+    for (unsigned long y = 0; y < height; ++y) {
+        for (unsigned long x = 0; x < width; ++x) {
+            Uint8* p = &pixels[(y * width + x) * 3];
+            const bool inFan = std::labs((long)x - (long)width / 2) < (long)y;
+            const Uint8 gray = inFan ? (Uint8)(noise.next(160) + 40) : 0;
+            const bool doppler = inFan && y > height / 3 && y < height / 2 && x > width / 2;
+            p[0] = doppler ? (Uint8)200 : gray;
+            p[1] = gray;
+            p[2] = doppler ? (Uint8)(gray / 2) : gray;
+        }
+    }
+    dataset->putAndInsertUint8Array(DCM_PixelData, pixels.data(), (unsigned long)pixels.size());
+    return dataset;
+}
+
+std::unique_ptr<DcmDataset> compress(const DcmDataset& native, E_TransferSyntax xfer,
+                                     const DcmRepresentationParameter* parameter) {
+    std::unique_ptr<DcmDataset> dataset(new DcmDataset(native));
+    if (dataset->chooseRepresentation(xfer, parameter).bad() || !dataset->canWriteXfer(xfer)) {
+        std::cerr << "⚠ Cannot compress sample, decode case skipped" << std::endl;
+        return nullptr;
+    }
+    dataset->removeAllButCurrentRepresentations();
+    dataset->updateOriginalXfer();
+    return dataset;
+}
+
+std::vector<Sample> makeSamples() {
+    DJLSRepresentationParameter lossless(2, OFTrue);
+    DcmRLERepresentationParameter rle;
+    std::vector<Sample> samples(4);
+
+    samples[0].name = "CR";
+    samples[0].width = 1760;
+    samples[0].height = 2140;
+    samples[0].native = makeGray(1760, 2140, 12, false, true, nullptr, "2048", "4096");
+
+    samples[1].name = "CT";
+    samples[1].width = 512;
+    samples[1].height = 512;
+    samples[1].native = makeGray(512, 512, 12, true, false, "-1024", "40", "400");
+
+    samples[2].name = "MG";
+    samples[2].width = 3328;
+    samples[2].height = 4096;
+    samples[2].native = makeGray(3328, 4096, 12, false, false, nullptr, "2048", "4096");
+
+    samples[3].name = "US";
+    samples[3].width = 800;
+    samples[3].height = 600;
+    samples[3].color = true;
+    samples[3].native = makeColor(800, 600);
+
+    for (Sample& sample : samples) {
+        if (sample.color)
+            sample.compressed = compress(*sample.native, EXS_RLELossless, &rle);
+        else
+            sample.compressed = compress(*sample.native, EXS_JPEGLSLossless, &lossless);
+    }
+    return samples;
+}
+
+// -----------------------------
+// Timing harness
+// -----------------------------
+struct CaseResult {
+    double minMs = 0;
+    double medianMs = 0;
+};
+
+// prepare() runs untimed before every iteration; the first iteration is a warm-up
+CaseResult runCase(unsigned iterations, const std::function<void()>& prepare,
+                   const std::function<bool()>& body) {
+    std::vector<double> times;
+    for (unsigned i = 0; i <= iterations; ++i) {
+        if (prepare) prepare();
+        const auto start = std::chrono::steady_clock::now();
+        if (!body()) return CaseResult();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        if (i > 0) times.push_back(std::chrono::duration<double, std::milli>(elapsed).count());
+    }
+    std::sort(times.begin(), times.end());
+    CaseResult result;
+    result.minMs = times.front();
+    result.medianMs = times[times.size() / 2];
+    return result;
+}
+
+class Bench {
+private:
+    const BenchOptions& options_;
+
+public:
+    explicit Bench(const BenchOptions& options) : options_(options) {
+        std::printf("%-34s %10s %10s %10s\n", "case", "median ms", "min ms", "MPix/s");
+    }
+
+    // megapixels = pixels produced per iteration (for throughput)
+    void run(const std::string& name, double megapixels, const std::function<bool()>& body,
+             const std::function<void()>& prepare = std::function<void()>()) {
+        if (!options_.filter.empty() && name.find(options_.filter) == std::string::npos) return;
+        const CaseResult result = runCase(options_.iterations, prepare, body);
+        if (result.medianMs <= 0) {
+            std::printf("%-34s %10s\n", name.c_str(), "failed");
+            return;
+        }
+        std::printf("%-34s %10.3f %10.3f %10.1f\n", name.c_str(), result.medianMs, result.minMs,
+                    megapixels / (result.medianMs / 1000.0));
+    }
+};
+
+// -----------------------------
+// Benchmark cases
+// -----------------------------
+void benchSample(Bench& bench, Sample& sample, const TileRect& tile, ThreadPool& pool) {
+    const std::string prefix = sample.name + " ";
+    const double sourceMp = sample.width * sample.height / 1e6;
+    const double tileMp = tile.width * tile.height / 1e6;
+
+    // Decode: compressed frame → native Little Endian, fresh copy every iteration
+    if (sample.compressed) {
+        std::unique_ptr<DcmDataset> work;
+        bench.run(prefix + "decode", sourceMp,
+                  [&]() {
+                      size_t decoded = 0;
+                      return decodeFirstFrame(*work, (size_t)-1, decoded) && decoded > 0;
+                  },
+                  [&]() { work.reset(new DcmDataset(*sample.compressed)); });
+    }
+
+    // Windowing at native size: stored value → LUT → 8bit, no scaling
+    RenderOptions native;
+    native.magnificationType = "REPLICATE";
+    const int channels = sample.color ? 3 : 1;
+    const size_t srcStride = sample.width * channels;
+    std::vector<Uint8> rendered(srcStride * sample.height);
+    RenderTarget target;
+    target.data = rendered.data();
+    target.stride = srcStride;
+    target.width = sample.width;
+    target.height = sample.height;
+    target.color = sample.color;
+    {
+        LutCache warm;
+        bench.run(prefix + "window (cached LUT)", sourceMp, [&]() {
+            return renderImageToFit(*sample.native, target, native, warm, nullptr);
+        });
+    }
+    if (!sample.color) {
+        std::unique_ptr<LutCache> cold;
+        bench.run(prefix + "window (LUT build)", sourceMp,
+                  [&]() { return renderImageToFit(*sample.native, target, native, *cold, nullptr); },
+                  [&]() { cold.reset(new LutCache()); });
+    }
+
+    // The 8bit image every later stage works on
+    LutCache lutCache;
+    if (!renderImageToFit(*sample.native, target, native, lutCache, nullptr)) return;
+
+    // Scaling into a 14x17in tile with each filter, single thread and pooled
+    std::vector<Uint8> scaled(tile.width * tile.height * channels);
+    const struct { const char* name; ResampleFilter filter; } filters[] = {
+        { "replicate", ResampleFilter::Replicate },
+        { "bilinear", ResampleFilter::Bilinear },
+        { "cubic", ResampleFilter::Cubic },
+    };
+    for (const auto& f : filters) {
+        bench.run(prefix + "scale " + f.name, tileMp, [&]() {
+            return resample8(rendered.data(), sample.width, sample.height, srcStride,
+                             scaled.data(), tile.width, tile.height, tile.width * channels,
+                             channels, f.filter, nullptr);
+        });
+        bench.run(prefix + "scale " + f.name + " (pool)", tileMp, [&]() {
+            return resample8(rendered.data(), sample.width, sample.height, srcStride,
+                             scaled.data(), tile.width, tile.height, tile.width * channels,
+                             channels, f.filter, &pool);
+        });
+    }
+
+    // Inversion (REVERSE polarity) over the scaled tile
+    if (!sample.color) {
+        bench.run(prefix + "invert", tileMp, [&]() {
+            PixelKernels::invert8(scaled.data(), scaled.data(), scaled.size());
+            return true;
+        });
+    }
+
+    // Swizzle / DIB padding into the page row format
+    const size_t rowBytes = tile.width * channels;
+    std::vector<Uint8> padded(PixelKernels::dibStride(rowBytes) * tile.height);
+    bench.run(prefix + (sample.color ? "swizzle+pad" : "pad"), tileMp, [&]() {
+        if (sample.color)
+            PixelKernels::swizzleRGBtoBGR(scaled.data(), rowBytes, padded.data(),
+                                          PixelKernels::dibStride(rowBytes), tile.width, tile.height);
+        else
+            PixelKernels::convertStride(scaled.data(), rowBytes, padded.data(),
+                                        PixelKernels::dibStride(rowBytes), rowBytes, tile.height);
+        return true;
+    });
+}
+
+// Whole pages: every box of a 1x1 and 2x2 film rendered and composed
+void benchCompose(Bench& bench, std::vector<Sample>& samples, unsigned dpi, ThreadPool& pool) {
+    FilmCompositor compositor(pool, dpi);
+    RasterLayout layout;
+    layout.rowAlignment = 4;
+    layout.bgr = true;
+
+    const char* formats[] = { "STANDARD\\1,1", "STANDARD\\2,2" };
+    for (Sample& sample : samples) {
+        for (const char* format : formats) {
+            FilmBoxSpec spec;
+            spec.imageDisplayFormat = format;
+            spec.magnificationType = "CUBIC";
+            FilmLayout film;
+            if (!computeFilmLayout(spec, dpi, film)) continue;
+
+            std::vector<PageImage> images(film.tiles.size());
+            for (PageImage& image : images) image.dataset.reset(new DcmDataset(*sample.native));
+
+            PageBuffer page;
+            bench.run(sample.name + " compose " + format, film.pageWidth * film.pageHeight / 1e6,
+                      [&]() { return compositor.compose(spec, images, layout, page); });
+        }
+    }
+}
+
+void printBenchUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --iterations <n>           timed iterations per case (default 20)\n"
+              << "  --dpi <n>                  page resolution for tiles and pages (default 300)\n"
+              << "  --threads <n>              render pool threads, 0 = all cores\n"
+              << "  --simd <auto|avx2|ssse3|sse2|off>  highest pixel kernel instruction set\n"
+              << "  --filter <text>            only run cases whose name contains text\n"
+              << "  --help                     show this message\n";
+}
+
+bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--help") == 0 || std::strcmp(arg, "-h") == 0) return false;
+        if (i + 1 >= argc) {
+            std::cerr << "❌ Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (std::strcmp(arg, "--iterations") == 0) {
+            options.iterations = (unsigned)std::max(1, std::atoi(value));
+        } else if (std::strcmp(arg, "--dpi") == 0) {
+            options.dpi = (unsigned)std::max(50, std::atoi(value));
+        } else if (std::strcmp(arg, "--threads") == 0) {
+            options.threads = (unsigned)std::max(0, std::atoi(value));
+        } else if (std::strcmp(arg, "--filter") == 0) {
+            options.filter = value;
+        } else if (std::strcmp(arg, "--simd") == 0) {
+            const std::string level = value;
+            if (level == "off") PixelKernels::setMaxIsa(PixelKernels::IsaLevel::Scalar);
+            else if (level == "sse2") PixelKernels::setMaxIsa(PixelKernels::IsaLevel::SSE2);
+            else if (level == "ssse3") PixelKernels::setMaxIsa(PixelKernels::IsaLevel::SSSE3);
+            else if (level != "auto" && level != "avx2") {
+                std::cerr << "❌ Unknown --simd level: " << level << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "❌ Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printBenchUsage(argv[0]);
+        return 1;
+    }
+
+    DJLSDecoderRegistration::registerCodecs();
+    DJLSEncoderRegistration::registerCodecs();
+    DcmRLEDecoderRegistration::registerCodecs();
+    DcmRLEEncoderRegistration::registerCodecs();
+
+    ThreadPool pool(options.threads);
+    std::cout << "⏱ Render benchmark: " << options.iterations << " iterations, " << options.dpi
+              << " dpi, " << pool.size() << " threads, SIMD " << PixelKernels::activeIsaName() << std::endl;
+
+    std::cout << "🧪 Generating samples..." << std::endl;
+    std::vector<Sample> samples = makeSamples();
+
+    // Single 14x17in box: the tile every image is scaled into
+    FilmBoxSpec spec;
+    FilmLayout film;
+    computeFilmLayout(spec, options.dpi, film);
+    const TileRect tile = film.tiles.front();
+    std::cout << "📐 Tile " << tile.width << "x" << tile.height << std::endl;
+
+    Bench bench(options);
+    for (Sample& sample : samples) benchSample(bench, sample, tile, pool);
+    benchCompose(bench, samples, options.dpi, pool);
+
+    DcmRLEEncoderRegistration::cleanup();
+    DcmRLEDecoderRegistration::cleanup();
+    DJLSEncoderRegistration::cleanup();
+    DJLSDecoderRegistration::cleanup();
+    return 0;
+}